@@ -0,0 +1,123 @@
+/////////////////////////////////////////////////////////////////////////////////
+// AllocationCounter.cpp
+// =====================
+// counts of the heap allocations made through operator new
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<bool> g_bCountAllocations(false);
+	std::atomic<uint64_t> g_AllocationCount(0);
+	std::atomic<uint64_t> g_AllocatedBytes(0);
+
+	/***********************************************************
+	 *  CountedAllocate()
+	 ***********************************************************/
+	void* CountedAllocate(size_t size)
+	{
+		if (g_bCountAllocations.load(std::memory_order_relaxed))
+		{
+			g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+			g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		}
+		return malloc((size > 0) ? size : 1);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* pointer = CountedAllocate(size);
+	if (NULL == pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	void* pointer = CountedAllocate(size);
+	if (NULL == pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	free(pointer);
+}
+
+/***********************************************************
+ *  SetEnabled()
+ ***********************************************************/
+void AllocationCounter::SetEnabled(bool bEnabled)
+{
+	g_bCountAllocations.store(bEnabled, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  IsEnabled()
+ ***********************************************************/
+bool AllocationCounter::IsEnabled()
+{
+	return g_bCountAllocations.load(std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  GetAllocationCount()
+ ***********************************************************/
+uint64_t AllocationCounter::GetAllocationCount()
+{
+	return g_AllocationCount.load(std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  GetAllocatedBytes()
+ ***********************************************************/
+uint64_t AllocationCounter::GetAllocatedBytes()
+{
+	return g_AllocatedBytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+/////////////////////////////////////////////////////////////////////////////////
+// AllocationCounter.h
+// ===================
+// counts of the heap allocations made through operator new
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+/***********************************************************
+ *  AllocationCounter
+ *
+ *  AllocationCounter.cpp replaces the global operator new and
+ *  delete for the whole program. The replacements only count
+ *  while counting is switched on, which only the benchmark
+ *  runner does, so every other mode pays for one relaxed load
+ *  per allocation and nothing more. Memory stb_image takes
+ *  with malloc() is not counted.
+ ***********************************************************/
+class AllocationCounter
+{
+public:
+	// start or stop counting the calls to operator new
+	static void SetEnabled(bool bEnabled);
+	static bool IsEnabled();
+
+	// calls to operator new, and the bytes they asked for, while counting was on
+	static uint64_t GetAllocationCount();
+	static uint64_t GetAllocatedBytes();
+};
@@ -0,0 +1,342 @@
+/////////////////////////////////////////////////////////////////////////////////
+// BatchRenderer.cpp
+// =================
+// headless rendering of many camera poses as tiles of one atlas framebuffer
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "BatchRenderer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "GLFW/glfw3.h"
+
+namespace
+{
+	// largest atlas side, also limited by the driver's renderbuffer size
+	const int g_MaxAtlasSize = 8192;
+}
+
+/***********************************************************
+ *  BatchRenderer()
+ ***********************************************************/
+BatchRenderer::BatchRenderer()
+	: m_pSoftwareRasterizer(NULL),
+	m_framebuffer(0),
+	m_colorBuffer(0),
+	m_depthBuffer(0),
+	m_atlasWidth(0),
+	m_atlasHeight(0)
+{
+}
+
+/***********************************************************
+ *  ~BatchRenderer()
+ ***********************************************************/
+BatchRenderer::~BatchRenderer()
+{
+	DestroyAtlas();
+}
+
+/***********************************************************
+ *  LoadPoses()
+ ***********************************************************/
+bool BatchRenderer::LoadPoses(const char* filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open camera pose list: " << filename << std::endl;
+		return false;
+	}
+
+	m_poses.clear();
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		std::istringstream fields(line);
+		std::string name;
+		if (!(fields >> name) || (name[0] == '#'))
+		{
+			continue;
+		}
+
+		CAMERA_POSE pose;
+		pose.name = name;
+		std::string poseFields;
+		std::getline(fields, poseFields);
+		if (ParsePose(poseFields, pose) == false)
+		{
+			std::cout << filename << ":" << lineNumber << ": expected name x y z yaw pitch [zoom] [ortho]" << std::endl;
+			return false;
+		}
+
+		m_poses.push_back(pose);
+	}
+
+	if (m_poses.empty())
+	{
+		std::cout << "No camera poses in " << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ParsePose()
+ *
+ *  This method is used for reading "x y z yaw pitch", then an
+ *  optional field of view and the word ortho in any order.
+ ***********************************************************/
+bool BatchRenderer::ParsePose(const std::string& line, CAMERA_POSE& pose)
+{
+	std::istringstream fields(line);
+	if (!(fields >> pose.position.x >> pose.position.y >> pose.position.z >> pose.yaw >> pose.pitch))
+	{
+		return false;
+	}
+
+	std::string option;
+	while (fields >> option)
+	{
+		if (option == "ortho")
+		{
+			pose.bOrthographic = true;
+		}
+		else
+		{
+			pose.zoom = (float)atof(option.c_str());
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  RenderAllSoftware()
+ *
+ *  This method is used for rendering the poses on the CPU.
+ *  There is no atlas; the rasterizer already spreads each
+ *  image over all of its threads, and its rows are top-down.
+ ***********************************************************/
+bool BatchRenderer::RenderAllSoftware(
+	SceneManager* pSceneManager,
+	int tileSize,
+	const std::string& outputFolder,
+	IMAGE_FORMAT format)
+{
+	double startTime = glfwGetTime();
+	bool bAllWritten = true;
+
+	for (size_t i = 0; i < m_poses.size(); i++)
+	{
+		SCENE_VIEW sceneView;
+		ViewManager::BuildCameraPoseView(m_poses[i], 1.0f, sceneView);
+		m_pSoftwareRasterizer->RenderView(pSceneManager, sceneView, tileSize, tileSize);
+
+		PROFILE_SCOPE("BatchWrite");
+		std::string filename = outputFolder + "/" + m_poses[i].name + "." + ImageWriter::GetExtension(format);
+		bAllWritten &= ImageWriter::WriteImage(
+			filename.c_str(),
+			format,
+			tileSize,
+			tileSize,
+			m_pSoftwareRasterizer->GetPixels(),
+			m_pSoftwareRasterizer->GetRowStride());
+	}
+
+	int poseCount = (int)m_poses.size();
+	double elapsedMilliseconds = (glfwGetTime() - startTime) * 1000.0;
+	std::cout << "INFO: Rendered " << poseCount << " " << tileSize << "x" << tileSize << " images on the CPU with "
+		<< m_pSoftwareRasterizer->GetThreadCount() << " threads, " << elapsedMilliseconds << " ms ("
+		<< elapsedMilliseconds / poseCount << " ms per image)" << std::endl;
+
+	return bAllWritten;
+}
+
+/***********************************************************
+ *  CreateAtlas()
+ ***********************************************************/
+bool BatchRenderer::CreateAtlas(int width, int height)
+{
+	if ((m_framebuffer != 0) && (width == m_atlasWidth) && (height == m_atlasHeight))
+	{
+		return true;
+	}
+
+	DestroyAtlas();
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Could not create the " << width << "x" << height << " atlas framebuffer" << std::endl;
+		DestroyAtlas();
+		return false;
+	}
+
+	m_atlasWidth = width;
+	m_atlasHeight = height;
+	return true;
+}
+
+/***********************************************************
+ *  DestroyAtlas()
+ ***********************************************************/
+void BatchRenderer::DestroyAtlas()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+
+	m_atlasWidth = 0;
+	m_atlasHeight = 0;
+}
+
+/***********************************************************
+ *  RenderAll()
+ *
+ *  This method is used for rendering the poses an atlas at a
+ *  time. The grid is as square as the pose count allows and
+ *  no larger than the driver supports; when there are more
+ *  poses than tiles, the atlas is reused for the next batch.
+ ***********************************************************/
+bool BatchRenderer::RenderAll(
+	SceneManager* pSceneManager,
+	int tileSize,
+	const std::string& outputFolder,
+	IMAGE_FORMAT format)
+{
+	PROFILE_SCOPE("BatchRender");
+
+	if ((NULL == pSceneManager) || m_poses.empty() || (tileSize <= 0))
+	{
+		return false;
+	}
+
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		return RenderAllSoftware(pSceneManager, tileSize, outputFolder, format);
+	}
+
+	GLint maxRenderbufferSize = 0;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbufferSize);
+	int maxAtlasSize = std::min(g_MaxAtlasSize, (int)maxRenderbufferSize);
+	int maxTilesPerSide = maxAtlasSize / tileSize;
+	if (maxTilesPerSide < 1)
+	{
+		std::cout << "Tile size " << tileSize << " exceeds the largest framebuffer, " << maxAtlasSize << std::endl;
+		return false;
+	}
+
+	int poseCount = (int)m_poses.size();
+	int columns = std::min(maxTilesPerSide, (int)ceil(sqrt((double)poseCount)));
+	int rows = std::min(maxTilesPerSide, (poseCount + columns - 1) / columns);
+	int tilesPerAtlas = columns * rows;
+
+	if (CreateAtlas(columns * tileSize, rows * tileSize) == false)
+	{
+		return false;
+	}
+
+	double startTime = glfwGetTime();
+	std::vector<SCENE_VIEW> tileViews;
+	std::vector<uint8_t> atlasPixels((size_t)m_atlasWidth * m_atlasHeight * 4);
+	ptrdiff_t atlasStride = (ptrdiff_t)m_atlasWidth * 4;
+	int atlasCount = 0;
+	bool bAllWritten = true;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	for (int firstPose = 0; firstPose < poseCount; firstPose += tilesPerAtlas)
+	{
+		int tileCount = std::min(tilesPerAtlas, poseCount - firstPose);
+
+		// one view per tile, laid out left to right, top to bottom
+		tileViews.resize(tileCount);
+		for (int t = 0; t < tileCount; t++)
+		{
+			int column = t % columns;
+			int row = rows - 1 - (t / columns);
+			tileViews[t].viewportRect = glm::vec4(
+				(float)column / columns,
+				(float)row / rows,
+				1.0f / columns,
+				1.0f / rows);
+			ViewManager::BuildCameraPoseView(m_poses[firstPose + t], 1.0f, tileViews[t]);
+		}
+
+		{
+			PROFILE_SCOPE("BatchAtlas");
+			glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+			glViewport(0, 0, m_atlasWidth, m_atlasHeight);
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			for (int t = 0; t < tileCount; t += SceneManager::MAX_SCENE_VIEWS)
+			{
+				pSceneManager->RenderSceneViews(
+					&tileViews[t],
+					std::min((int)SceneManager::MAX_SCENE_VIEWS, tileCount - t),
+					m_atlasWidth,
+					m_atlasHeight);
+			}
+
+			glReadPixels(0, 0, m_atlasWidth, m_atlasHeight, GL_RGBA, GL_UNSIGNED_BYTE, &atlasPixels[0]);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+		// the readback is bottom-up, so each tile starts at its highest row
+		{
+			PROFILE_SCOPE("BatchWrite");
+			for (int t = 0; t < tileCount; t++)
+			{
+				int x = (t % columns) * tileSize;
+				int topRow = (rows - (t / columns)) * tileSize - 1;
+				const uint8_t* pTopRow = &atlasPixels[(size_t)topRow * atlasStride + (size_t)x * 4];
+
+				std::string filename = outputFolder + "/" + m_poses[firstPose + t].name + "." + ImageWriter::GetExtension(format);
+				bAllWritten &= ImageWriter::WriteImage(filename.c_str(), format, tileSize, tileSize, pTopRow, -atlasStride);
+			}
+		}
+
+		atlasCount++;
+	}
+
+	double elapsedMilliseconds = (glfwGetTime() - startTime) * 1000.0;
+	std::cout << "INFO: Rendered " << poseCount << " " << tileSize << "x" << tileSize << " images in "
+		<< atlasCount << " atlas pass" << ((atlasCount == 1) ? "" : "es") << " of " << columns << "x" << rows
+		<< " tiles, " << elapsedMilliseconds << " ms (" << elapsedMilliseconds / poseCount << " ms per image)" << std::endl;
+
+	return bAllWritten;
+}
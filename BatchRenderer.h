@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////////
+// BatchRenderer.h
+// ===============
+// headless rendering of many camera poses as tiles of one atlas framebuffer
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "ImageWriter.h"
+#include "SceneManager.h"
+#include "SoftwareRasterizer.h"
+#include "ViewManager.h"
+
+/***********************************************************
+ *  BatchRenderer
+ *
+ *  Renders a list of camera poses as square tiles of a large
+ *  offscreen framebuffer. The scene is prepared once, and
+ *  each atlas is drawn with SceneManager::RenderSceneViews(),
+ *  so the tiles share culling, sorting and state changes, and
+ *  the atlas is read back with a single glReadPixels call
+ *  before each tile is written out as its own image. With a
+ *  software rasterizer set, each pose is drawn by it instead.
+ ***********************************************************/
+class BatchRenderer
+{
+public:
+	BatchRenderer();
+	~BatchRenderer();
+
+	// read the camera poses, one per line:
+	//   name x y z yaw pitch [zoom] [ortho]
+	// blank lines and lines starting with # are skipped
+	bool LoadPoses(const char* filename);
+	size_t GetPoseCount() const { return m_poses.size(); }
+	const std::vector<CAMERA_POSE>& GetPoses() const { return m_poses; }
+	// parse the fields of one pose line, false if they are incomplete
+	static bool ParsePose(const std::string& line, CAMERA_POSE& pose);
+
+	// render every pose and write <outputFolder>/<name>.<ext>
+	bool RenderAll(
+		SceneManager* pSceneManager,
+		int tileSize,
+		const std::string& outputFolder,
+		IMAGE_FORMAT format);
+	// draw the poses on the CPU instead of through OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pSoftwareRasterizer) { m_pSoftwareRasterizer = pSoftwareRasterizer; }
+
+private:
+	std::vector<CAMERA_POSE> m_poses;
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_atlasWidth;
+	int m_atlasHeight;
+
+	// create the atlas framebuffer with color and depth renderbuffers
+	bool CreateAtlas(int width, int height);
+	void DestroyAtlas();
+
+	// render every pose with the software rasterizer, one at a time
+	bool RenderAllSoftware(
+		SceneManager* pSceneManager,
+		int tileSize,
+		const std::string& outputFolder,
+		IMAGE_FORMAT format);
+};
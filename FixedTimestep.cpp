@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FixedTimestep.cpp
+// =================
+// accumulator that turns variable frame times into fixed update steps
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "FixedTimestep.h"
+
+/***********************************************************
+ *  FixedTimestep()
+ ***********************************************************/
+FixedTimestep::FixedTimestep(double stepSeconds, int maxStepsPerFrame)
+	: m_stepSeconds(stepSeconds),
+	m_maxStepsPerFrame(maxStepsPerFrame),
+	m_lastTime(0.0),
+	m_accumulator(0.0),
+	m_bStarted(false),
+	m_stepCount(0),
+	m_droppedSeconds(0.0)
+{
+}
+
+/***********************************************************
+ *  Reset()
+ ***********************************************************/
+void FixedTimestep::Reset(double currentTime)
+{
+	m_lastTime = currentTime;
+	m_accumulator = 0.0;
+	m_bStarted = true;
+	m_stepCount = 0;
+	m_droppedSeconds = 0.0;
+}
+
+/***********************************************************
+ *  SkipTo()
+ ***********************************************************/
+void FixedTimestep::SkipTo(double currentTime)
+{
+	m_lastTime = currentTime;
+	m_bStarted = true;
+}
+
+/***********************************************************
+ *  Advance()
+ *
+ *  This method is used for adding the elapsed time to the
+ *  accumulator and taking out the whole steps it holds. When
+ *  more than the step limit is waiting, the excess whole steps
+ *  are dropped but the partial step is kept, so interpolation
+ *  stays smooth after a stall.
+ ***********************************************************/
+int FixedTimestep::Advance(double currentTime)
+{
+	if (m_bStarted == false)
+	{
+		Reset(currentTime);
+		return 0;
+	}
+
+	double elapsed = currentTime - m_lastTime;
+	m_lastTime = currentTime;
+	if (elapsed > 0.0)
+	{
+		m_accumulator += elapsed;
+	}
+
+	int steps = (int)(m_accumulator / m_stepSeconds);
+	m_accumulator -= steps * m_stepSeconds;
+
+	if (steps > m_maxStepsPerFrame)
+	{
+		m_droppedSeconds += (steps - m_maxStepsPerFrame) * m_stepSeconds;
+		steps = m_maxStepsPerFrame;
+	}
+
+	m_stepCount += steps;
+	return steps;
+}
+
+/***********************************************************
+ *  GetInterpolation()
+ ***********************************************************/
+float FixedTimestep::GetInterpolation() const
+{
+	float interpolation = (float)(m_accumulator / m_stepSeconds);
+
+	if (interpolation < 0.0f) interpolation = 0.0f;
+	if (interpolation > 1.0f) interpolation = 1.0f;
+
+	return interpolation;
+}
@@ -0,0 +1,48 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FixedTimestep.h
+// ===============
+// accumulator that turns variable frame times into fixed update steps
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  FixedTimestep
+ *
+ *  Each frame adds the real time that passed to an
+ *  accumulator and runs as many whole steps as fit, so camera
+ *  movement and any simulation advance by the same amount no
+ *  matter the frame rate. The fraction of a step left over is
+ *  used to blend the last two update states when rendering.
+ *  A slow frame runs at most a few steps and drops the rest,
+ *  so one stall cannot snowball into more stalls.
+ ***********************************************************/
+class FixedTimestep
+{
+public:
+	FixedTimestep(double stepSeconds, int maxStepsPerFrame);
+
+	// restart timing from the given time with an empty accumulator
+	void Reset(double currentTime);
+	// restart timing from the given time, keeping the partial step
+	void SkipTo(double currentTime);
+	// add the time since the last call and return the number of steps to run
+	int Advance(double currentTime);
+
+	double GetStepSeconds() const { return m_stepSeconds; }
+	// fraction of a step in the accumulator, 0 to 1, for blending update states
+	float GetInterpolation() const;
+	// steps run since the last reset
+	unsigned int GetStepCount() const { return m_stepCount; }
+	// seconds thrown away because frames needed more than the step limit
+	double GetDroppedSeconds() const { return m_droppedSeconds; }
+
+private:
+	double m_stepSeconds;
+	int m_maxStepsPerFrame;
+	double m_lastTime;
+	double m_accumulator;
+	bool m_bStarted;
+	unsigned int m_stepCount;
+	double m_droppedSeconds;
+};
@@ -0,0 +1,123 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FrameCache.cpp
+// ==============
+// copy of the last rendered frame, presented again while nothing changes
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCache.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  FrameCache()
+ ***********************************************************/
+FrameCache::FrameCache()
+	: m_framebuffer(0),
+	m_colorBuffer(0),
+	m_width(0),
+	m_height(0),
+	m_bHasFrame(false)
+{
+}
+
+/***********************************************************
+ *  ~FrameCache()
+ ***********************************************************/
+FrameCache::~FrameCache()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Destroy()
+ ***********************************************************/
+void FrameCache::Destroy()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+	}
+
+	m_width = 0;
+	m_height = 0;
+	m_bHasFrame = false;
+}
+
+/***********************************************************
+ *  Resize()
+ ***********************************************************/
+bool FrameCache::Resize(int width, int height)
+{
+	Destroy();
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Frame cache framebuffer is incomplete" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	return true;
+}
+
+/***********************************************************
+ *  Capture()
+ ***********************************************************/
+bool FrameCache::Capture(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	if ((width != m_width) || (height != m_height))
+	{
+		if (Resize(width, height) == false)
+		{
+			return false;
+		}
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_bHasFrame = true;
+	return true;
+}
+
+/***********************************************************
+ *  Present()
+ ***********************************************************/
+bool FrameCache::Present(int width, int height)
+{
+	// a resized window needs a new frame, not a stretched copy
+	if ((m_bHasFrame == false) || (width != m_width) || (height != m_height))
+	{
+		return false;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return true;
+}
@@ -0,0 +1,45 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FrameCache.h
+// ============
+// copy of the last rendered frame, presented again while nothing changes
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  FrameCache
+ *
+ *  The back buffer is undefined after a swap, so the finished
+ *  frame is copied into an offscreen framebuffer before it is
+ *  presented. When the window has to be redrawn without any
+ *  change to the scene, the copy is blitted back instead of
+ *  rendering the scene again.
+ ***********************************************************/
+class FrameCache
+{
+public:
+	FrameCache();
+	~FrameCache();
+
+	void Destroy();
+
+	// copy the default framebuffer's back buffer into the cache
+	bool Capture(int width, int height);
+	// copy the cached frame into the default framebuffer's back buffer
+	bool Present(int width, int height);
+
+	// true once a frame of the current size has been captured
+	bool HasFrame() const { return m_bHasFrame; }
+
+private:
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	int m_width;
+	int m_height;
+	bool m_bHasFrame;
+
+	// recreate the offscreen color buffer for a new window size
+	bool Resize(int width, int height);
+};
@@ -0,0 +1,379 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FrameCapture.cpp
+// ================
+// asynchronous readback of rendered frames to a numbered image sequence
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "GLFW/glfw3.h"
+
+namespace
+{
+	// how long to wait on a fence before checking it again, in nanoseconds
+	const GLuint64 g_FenceWaitNanoseconds = 100000000;
+	// frames that may wait in the queue per encoder
+	const size_t g_QueuedJobsPerEncoder = 2;
+}
+
+/***********************************************************
+ *  FrameCapture()
+ ***********************************************************/
+FrameCapture::FrameCapture()
+	: m_nextSlot(0),
+	m_frameCount(0),
+	m_stallCount(0),
+	m_droppedCount(0),
+	m_format(IMAGE_FORMAT_PNG),
+	m_bStarted(false),
+	m_startTime(0.0),
+	m_maxQueuedJobs(0),
+	m_runningEncoders(0),
+	m_encoderCount(0),
+	m_writtenCount(0),
+	m_failedCount(0)
+{
+	memset(m_slots, 0, sizeof(m_slots));
+}
+
+/***********************************************************
+ *  ~FrameCapture()
+ ***********************************************************/
+FrameCapture::~FrameCapture()
+{
+	Finish();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for setting up the capture. No threads
+ *  are started; encoder jobs are submitted to the job system
+ *  as frames arrive, and the job system already leaves the
+ *  main thread its own core.
+ ***********************************************************/
+bool FrameCapture::Start(const std::string& outputFolder, IMAGE_FORMAT format, int encoderCount)
+{
+	if (m_bStarted)
+	{
+		return false;
+	}
+
+	if (encoderCount <= 0)
+	{
+		encoderCount = JobSystem::GetWorkerCount();
+		if (encoderCount < 1)
+		{
+			encoderCount = 1;
+		}
+	}
+
+	m_outputFolder = outputFolder;
+	m_format = format;
+	m_nextSlot = 0;
+	m_frameCount = 0;
+	m_stallCount = 0;
+	m_droppedCount = 0;
+	m_writtenCount = 0;
+	m_failedCount = 0;
+	m_runningEncoders = 0;
+	m_encoderCount = encoderCount;
+	m_maxQueuedJobs = encoderCount * g_QueuedJobsPerEncoder;
+
+	m_startTime = glfwGetTime();
+	m_bStarted = true;
+
+	std::cout << "INFO: Capturing frames to " << outputFolder << " as "
+		<< ImageWriter::GetExtension(format) << " with up to " << encoderCount << " encoder"
+		<< ((encoderCount == 1) ? "" : "s") << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for collecting the frames still in the
+ *  readback ring, oldest first, then waiting until the encoder
+ *  jobs have emptied the queue.
+ ***********************************************************/
+void FrameCapture::Finish()
+{
+	if (m_bStarted == false)
+	{
+		return;
+	}
+
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		READBACK_SLOT& slot = m_slots[(m_nextSlot + i) % RING_SIZE];
+		if (0 != slot.fence)
+		{
+			CollectSlot(slot, true);
+		}
+		if (0 != slot.pixelBuffer)
+		{
+			glDeleteBuffers(1, &slot.pixelBuffer);
+		}
+	}
+	memset(m_slots, 0, sizeof(m_slots));
+
+	{
+		std::unique_lock<std::mutex> lock(m_queueMutex);
+		m_jobTaken.wait(lock, [this] { return m_jobs.empty() && (m_runningEncoders == 0); });
+	}
+	m_freePixels.clear();
+
+	double elapsedSeconds = glfwGetTime() - m_startTime;
+	std::cout << "INFO: Captured " << m_frameCount << " frames in " << elapsedSeconds << " s, "
+		<< m_writtenCount << " written";
+	if (m_failedCount + m_droppedCount > 0)
+	{
+		std::cout << ", " << m_failedCount + m_droppedCount << " failed";
+	}
+	std::cout << ", " << m_stallCount << " readback stall" << ((m_stallCount == 1) ? "" : "s") << std::endl;
+
+	m_bStarted = false;
+}
+
+/***********************************************************
+ *  CaptureFrame()
+ *
+ *  This method is used for starting the readback of the back
+ *  buffer into the next slot of the ring. Any older slot the
+ *  GPU has finished is collected first without waiting; the
+ *  slot about to be reused is collected even if that means
+ *  waiting, which only happens when the GPU is RING_SIZE
+ *  frames behind.
+ ***********************************************************/
+void FrameCapture::CaptureFrame(int width, int height)
+{
+	if ((m_bStarted == false) || (width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("CaptureFrame");
+
+	for (int i = 1; i < RING_SIZE; i++)
+	{
+		READBACK_SLOT& slot = m_slots[(m_nextSlot + i) % RING_SIZE];
+		if (0 != slot.fence)
+		{
+			CollectSlot(slot, false);
+		}
+	}
+
+	READBACK_SLOT& slot = m_slots[m_nextSlot];
+	if (0 != slot.fence)
+	{
+		CollectSlot(slot, true);
+	}
+
+	// grow the buffer for a larger window; a smaller frame reuses it
+	size_t frameSize = (size_t)width * height * 4;
+	if ((0 == slot.pixelBuffer) || (slot.bufferSize < frameSize))
+	{
+		if (0 == slot.pixelBuffer)
+		{
+			glGenBuffers(1, &slot.pixelBuffer);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+		slot.bufferSize = frameSize;
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+	}
+
+	// with a pack buffer bound the read only queues a copy on the GPU
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.width = width;
+	slot.height = height;
+	slot.frameIndex = m_frameCount++;
+
+	m_nextSlot = (m_nextSlot + 1) % RING_SIZE;
+}
+
+/***********************************************************
+ *  CollectSlot()
+ *
+ *  This method is used for copying a finished readback out of
+ *  its pack buffer so the buffer can be reused. Without bWait
+ *  the slot is left alone if the GPU has not reached its
+ *  fence yet.
+ ***********************************************************/
+void FrameCapture::CollectSlot(READBACK_SLOT& slot, bool bWait)
+{
+	GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		if (bWait == false)
+		{
+			return;
+		}
+
+		PROFILE_SCOPE("CaptureStall");
+		m_stallCount++;
+		while (status == GL_TIMEOUT_EXPIRED)
+		{
+			status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceWaitNanoseconds);
+		}
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	if (status == GL_WAIT_FAILED)
+	{
+		std::cout << "Frame capture fence failed, frame " << slot.frameIndex << " dropped" << std::endl;
+		m_droppedCount++;
+		return;
+	}
+
+	size_t frameSize = (size_t)slot.width * slot.height * 4;
+
+	ENCODE_JOB job;
+	job.width = slot.width;
+	job.height = slot.height;
+	job.frameIndex = slot.frameIndex;
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		if (m_freePixels.empty() == false)
+		{
+			job.pixels.swap(m_freePixels.back());
+			m_freePixels.pop_back();
+		}
+	}
+	job.pixels.resize(frameSize);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+	const void* pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+	if (NULL == pMapped)
+	{
+		std::cout << "Could not map the frame capture buffer, frame " << slot.frameIndex << " dropped" << std::endl;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		m_droppedCount++;
+		return;
+	}
+	memcpy(&job.pixels[0], pMapped, frameSize);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  QueueJob()
+ *
+ *  This method is used for handing a frame to the encoders,
+ *  waiting for room when the queue is full. A new encoder job
+ *  is only submitted while fewer than the encoder count are
+ *  running; the running ones take the frame otherwise.
+ ***********************************************************/
+void FrameCapture::QueueJob(ENCODE_JOB& job)
+{
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	if (m_jobs.size() >= m_maxQueuedJobs)
+	{
+		PROFILE_SCOPE("CaptureQueueFull");
+		m_jobTaken.wait(lock, [this] { return m_jobs.size() < m_maxQueuedJobs; });
+	}
+
+	m_jobs.push_back(ENCODE_JOB());
+	m_jobs.back().pixels.swap(job.pixels);
+	m_jobs.back().width = job.width;
+	m_jobs.back().height = job.height;
+	m_jobs.back().frameIndex = job.frameIndex;
+
+	bool bStartEncoder = (m_runningEncoders < m_encoderCount);
+	if (bStartEncoder)
+	{
+		m_runningEncoders++;
+	}
+	lock.unlock();
+
+	if (bStartEncoder)
+	{
+		JobSystem::Submit([this]() { EncodeFrames(); });
+	}
+}
+
+/***********************************************************
+ *  EncodeFrames()
+ *
+ *  This method is used for encoding queued frames until the
+ *  queue is empty, so a running encoder job keeps going while
+ *  frames keep coming instead of a job being submitted per
+ *  frame. The readback is bottom-up, so each image is written
+ *  from its last row with a negative stride.
+ ***********************************************************/
+void FrameCapture::EncodeFrames()
+{
+	for (;;)
+	{
+		ENCODE_JOB job;
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			if (m_jobs.empty())
+			{
+				m_runningEncoders--;
+				// Finish() waits for the last encoder to stop
+				m_jobTaken.notify_all();
+				return;
+			}
+
+			job.pixels.swap(m_jobs.front().pixels);
+			job.width = m_jobs.front().width;
+			job.height = m_jobs.front().height;
+			job.frameIndex = m_jobs.front().frameIndex;
+			m_jobs.pop_front();
+		}
+		m_jobTaken.notify_one();
+
+		char filename[32];
+		snprintf(filename, sizeof(filename), "/frame_%06d.", job.frameIndex);
+		std::string path = m_outputFolder + filename + ImageWriter::GetExtension(m_format);
+
+		ptrdiff_t rowStride = (ptrdiff_t)job.width * 4;
+		bool bWritten = false;
+		{
+			PROFILE_SCOPE("EncodeFrame");
+			bWritten = ImageWriter::WriteImage(
+				path.c_str(),
+				m_format,
+				job.width,
+				job.height,
+				&job.pixels[(size_t)(job.height - 1) * rowStride],
+				-rowStride);
+		}
+
+		// keep the pixel storage for a later frame
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		if (bWritten)
+		{
+			m_writtenCount++;
+		}
+		else
+		{
+			m_failedCount++;
+		}
+		if (m_freePixels.size() < m_maxQueuedJobs + RING_SIZE)
+		{
+			m_freePixels.push_back(std::vector<uint8_t>());
+			m_freePixels.back().swap(job.pixels);
+		}
+	}
+}
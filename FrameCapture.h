@@ -0,0 +1,105 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FrameCapture.h
+// ==============
+// asynchronous readback of rendered frames to a numbered image sequence
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "ImageWriter.h"
+
+/***********************************************************
+ *  FrameCapture
+ *
+ *  Each captured frame is read into one of a ring of pixel
+ *  pack buffers and a fence is placed after the read. The
+ *  copy runs on the GPU while later frames are drawn; a slot
+ *  is only mapped once its fence has signaled, normally a
+ *  couple of frames later, so the render thread never waits
+ *  on glReadPixels. The mapped pixels are copied out and
+ *  queued, and encoder jobs on the job system write the
+ *  image files in parallel.
+ ***********************************************************/
+class FrameCapture
+{
+public:
+	// pixel pack buffers in the readback ring
+	static const int RING_SIZE = 3;
+
+	FrameCapture();
+	~FrameCapture();
+
+	// start capturing; encoderCount is the most frames encoded at once,
+	// 0 for one per job system worker
+	bool Start(const std::string& outputFolder, IMAGE_FORMAT format, int encoderCount);
+	// read back every frame still in flight and wait until all queued
+	// images are written; needs the GL context that captured the frames
+	void Finish();
+
+	// queue a readback of the back buffer just rendered, before the swap
+	void CaptureFrame(int width, int height);
+
+	bool IsCapturing() const { return m_bStarted; }
+
+private:
+	struct READBACK_SLOT
+	{
+		GLuint pixelBuffer;
+		GLsync fence;
+		int width;
+		int height;
+		// capacity of the pixel buffer in bytes
+		size_t bufferSize;
+		int frameIndex;
+	};
+
+	struct ENCODE_JOB
+	{
+		std::vector<uint8_t> pixels;
+		int width;
+		int height;
+		int frameIndex;
+	};
+
+	READBACK_SLOT m_slots[RING_SIZE];
+	int m_nextSlot;
+	int m_frameCount;
+	// frames whose slot was reused before the GPU had finished the copy
+	int m_stallCount;
+	// frames lost to a failed fence or map on the render thread
+	int m_droppedCount;
+
+	std::string m_outputFolder;
+	IMAGE_FORMAT m_format;
+	bool m_bStarted;
+	double m_startTime;
+
+	// frames waiting for an encoder; the queue is bounded so a slow disk
+	// holds back the render loop instead of growing memory without limit
+	std::mutex m_queueMutex;
+	std::condition_variable m_jobTaken;
+	std::deque<ENCODE_JOB> m_jobs;
+	size_t m_maxQueuedJobs;
+	// encoder jobs running or queued, at most m_encoderCount
+	int m_runningEncoders;
+	int m_encoderCount;
+	// pixel vectors returned by the workers for reuse
+	std::vector<std::vector<uint8_t>> m_freePixels;
+	int m_writtenCount;
+	int m_failedCount;
+
+	// map a finished slot, copy its pixels out and queue them for encoding
+	void CollectSlot(READBACK_SLOT& slot, bool bWait);
+	void QueueJob(ENCODE_JOB& job);
+	// encoder job: write queued frames until the queue is empty
+	void EncodeFrames();
+};
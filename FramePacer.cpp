@@ -0,0 +1,260 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FramePacer.cpp
+// ==============
+// swap interval modes, target frame rate limiter and frame time statistics
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+#include "GLFW/glfw3.h"
+
+namespace
+{
+	// intervals kept for the 99th percentile
+	const size_t g_RecentIntervalCount = 1000;
+	// starting and largest spin margin for the limiter
+	const std::chrono::microseconds g_InitialSpinMargin(2000);
+	const std::chrono::microseconds g_MaxSpinMargin(4000);
+}
+
+/***********************************************************
+ *  FramePacer()
+ ***********************************************************/
+FramePacer::FramePacer()
+	: m_mode(PACING_VSYNC),
+	m_framePeriod(0),
+	m_bHasLastPresent(false),
+	m_bHasDeadline(false),
+	m_spinMargin(g_InitialSpinMargin)
+{
+	ResetStats();
+}
+
+/***********************************************************
+ *  SetMode()
+ ***********************************************************/
+void FramePacer::SetMode(PACING_MODE mode, double targetFramesPerSecond)
+{
+	m_mode = mode;
+
+	if ((mode == PACING_LIMITED) && (targetFramesPerSecond > 0.0))
+	{
+		m_framePeriod = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / targetFramesPerSecond));
+	}
+	else
+	{
+		m_framePeriod = Clock::duration(0);
+	}
+
+	// only vsync waits for the display; the limiter does its own waiting
+	glfwSwapInterval((mode == PACING_VSYNC) ? 1 : 0);
+
+	m_bHasDeadline = false;
+	m_bHasLastPresent = false;
+	ResetStats();
+}
+
+/***********************************************************
+ *  GetModeName()
+ ***********************************************************/
+const char* FramePacer::GetModeName() const
+{
+	switch (m_mode)
+	{
+	case PACING_VSYNC:
+		return "vsync";
+	case PACING_UNCAPPED:
+		return "uncapped";
+	case PACING_LIMITED:
+		return "limited";
+	}
+	return "";
+}
+
+/***********************************************************
+ *  WaitForFrameDeadline()
+ *
+ *  This method is used for holding the frame until its
+ *  deadline. Deadlines advance by exactly one period so small
+ *  errors do not accumulate; a frame that arrives after its
+ *  deadline restarts the schedule from now instead of letting
+ *  the following frames rush to catch up.
+ ***********************************************************/
+void FramePacer::WaitForFrameDeadline()
+{
+	if ((m_mode != PACING_LIMITED) || (m_framePeriod.count() <= 0))
+	{
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+
+	if (m_bHasDeadline == false)
+	{
+		m_nextDeadline = now + m_framePeriod;
+		m_bHasDeadline = true;
+	}
+	else if (now > m_nextDeadline)
+	{
+		if (now - m_nextDeadline > m_framePeriod / 2)
+		{
+			m_missedDeadlines++;
+		}
+		m_nextDeadline = now;
+	}
+
+	// sleep through most of the wait, measuring how late the sleep wakes up
+	Clock::duration remaining = m_nextDeadline - now;
+	if (remaining > m_spinMargin)
+	{
+		Clock::duration sleepTime = remaining - m_spinMargin;
+		Clock::time_point sleepStart = Clock::now();
+		std::this_thread::sleep_for(sleepTime);
+		Clock::duration overshoot = (Clock::now() - sleepStart) - sleepTime;
+
+		// follow the overshoot: grow quickly, shrink slowly
+		Clock::duration target = overshoot + overshoot / 2;
+		if (target > m_spinMargin)
+		{
+			m_spinMargin = std::min<Clock::duration>(target, g_MaxSpinMargin);
+		}
+		else
+		{
+			m_spinMargin -= (m_spinMargin - target) / 16;
+		}
+	}
+
+	// spin the rest of the way to the deadline
+	while (Clock::now() < m_nextDeadline)
+	{
+		std::this_thread::yield();
+	}
+
+	// a sleep that badly overshot also counts as arriving late
+	now = Clock::now();
+	if (now - m_nextDeadline > m_framePeriod / 2)
+	{
+		m_missedDeadlines++;
+		m_nextDeadline = now;
+	}
+
+	m_nextDeadline += m_framePeriod;
+}
+
+/***********************************************************
+ *  FramePresented()
+ ***********************************************************/
+void FramePacer::FramePresented()
+{
+	Clock::time_point now = Clock::now();
+
+	if (m_bHasLastPresent)
+	{
+		double milliseconds = std::chrono::duration<double, std::milli>(now - m_lastPresent).count();
+
+		m_frameCount++;
+		double delta = milliseconds - m_mean;
+		m_mean += delta / m_frameCount;
+		m_sumSquaredDeviations += delta * (milliseconds - m_mean);
+		m_minMilliseconds = std::min(m_minMilliseconds, milliseconds);
+		m_maxMilliseconds = std::max(m_maxMilliseconds, milliseconds);
+
+		if (m_recentIntervals.size() < g_RecentIntervalCount)
+		{
+			m_recentIntervals.push_back(milliseconds);
+		}
+		else
+		{
+			m_recentIntervals[m_nextRecentInterval] = milliseconds;
+			m_nextRecentInterval = (m_nextRecentInterval + 1) % g_RecentIntervalCount;
+		}
+	}
+
+	m_lastPresent = now;
+	m_bHasLastPresent = true;
+}
+
+/***********************************************************
+ *  ResetTiming()
+ ***********************************************************/
+void FramePacer::ResetTiming()
+{
+	m_bHasLastPresent = false;
+	m_bHasDeadline = false;
+}
+
+/***********************************************************
+ *  ResetStats()
+ ***********************************************************/
+void FramePacer::ResetStats()
+{
+	m_frameCount = 0;
+	m_mean = 0.0;
+	m_sumSquaredDeviations = 0.0;
+	m_minMilliseconds = 1.0e30;
+	m_maxMilliseconds = 0.0;
+	m_missedDeadlines = 0;
+	m_recentIntervals.clear();
+	m_nextRecentInterval = 0;
+}
+
+/***********************************************************
+ *  GetStats()
+ ***********************************************************/
+FRAME_PACING_STATS FramePacer::GetStats() const
+{
+	FRAME_PACING_STATS stats;
+
+	if (m_frameCount == 0)
+	{
+		return stats;
+	}
+
+	stats.frameCount = m_frameCount;
+	stats.meanMilliseconds = m_mean;
+	stats.standardDeviation = (m_frameCount > 1) ? sqrt(m_sumSquaredDeviations / (m_frameCount - 1)) : 0.0;
+	stats.minMilliseconds = m_minMilliseconds;
+	stats.maxMilliseconds = m_maxMilliseconds;
+	stats.missedDeadlines = m_missedDeadlines;
+
+	std::vector<double> sorted = m_recentIntervals;
+	std::sort(sorted.begin(), sorted.end());
+	stats.p99Milliseconds = sorted[(sorted.size() - 1) * 99 / 100];
+
+	return stats;
+}
+
+/***********************************************************
+ *  PrintStats()
+ ***********************************************************/
+void FramePacer::PrintStats() const
+{
+	FRAME_PACING_STATS stats = GetStats();
+
+	if (stats.frameCount == 0)
+	{
+		return;
+	}
+
+	char line[256];
+	std::cout << "PACING: " << GetModeName() << ", " << stats.frameCount << " frames" << std::endl;
+	snprintf(line, sizeof(line), "  present  mean %8.3f ms  stddev %8.3f ms  min %8.3f ms  p99 %8.3f ms  max %8.3f ms",
+		stats.meanMilliseconds, stats.standardDeviation, stats.minMilliseconds,
+		stats.p99Milliseconds, stats.maxMilliseconds);
+	std::cout << line << std::endl;
+
+	if (m_mode == PACING_LIMITED)
+	{
+		snprintf(line, sizeof(line), "  target   %8.3f ms  missed %u deadlines",
+			std::chrono::duration<double, std::milli>(m_framePeriod).count(),
+			stats.missedDeadlines);
+		std::cout << line << std::endl;
+	}
+}
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////////
+// FramePacer.h
+// ============
+// swap interval modes, target frame rate limiter and frame time statistics
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+/***********************************************************
+ *  FRAME_PACING_STATS
+ *
+ *  Present-to-present intervals in milliseconds.
+ ***********************************************************/
+struct FRAME_PACING_STATS
+{
+	unsigned int frameCount = 0;
+	double meanMilliseconds = 0.0;
+	double standardDeviation = 0.0;
+	double minMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+	double p99Milliseconds = 0.0;
+	// limited mode only: frames that reached the limiter more than half a period late
+	unsigned int missedDeadlines = 0;
+};
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  The vsync and uncapped modes only set the swap interval.
+ *  The limited mode turns vsync off and waits for a fixed
+ *  deadline before each swap: it sleeps while the deadline is
+ *  far away and spins for the last stretch, where the spin
+ *  margin tracks how much the OS has been oversleeping.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	enum PACING_MODE
+	{
+		PACING_VSYNC,
+		PACING_UNCAPPED,
+		PACING_LIMITED
+	};
+
+	FramePacer();
+
+	// set the swap interval for the mode; needs a current GL context
+	void SetMode(PACING_MODE mode, double targetFramesPerSecond = 60.0);
+	PACING_MODE GetMode() const { return m_mode; }
+	const char* GetModeName() const;
+
+	// in limited mode, wait until the next frame deadline; call right before swapping
+	void WaitForFrameDeadline();
+	// record the present time; call right after swapping
+	void FramePresented();
+	// forget the last present, so a pause is not counted as a frame
+	void ResetTiming();
+	// start the statistics over, keeping the mode
+	void ResetStats();
+
+	// statistics over every frame since the mode was set
+	FRAME_PACING_STATS GetStats() const;
+	// print the mode and its frame time statistics
+	void PrintStats() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	PACING_MODE m_mode;
+	Clock::duration m_framePeriod;
+	Clock::time_point m_nextDeadline;
+	Clock::time_point m_lastPresent;
+	bool m_bHasLastPresent;
+	bool m_bHasDeadline;
+	// extra time left for spinning because sleeps overshoot by about this much
+	Clock::duration m_spinMargin;
+
+	// running mean and variance (Welford) of the present intervals
+	unsigned int m_frameCount;
+	double m_mean;
+	double m_sumSquaredDeviations;
+	double m_minMilliseconds;
+	double m_maxMilliseconds;
+	unsigned int m_missedDeadlines;
+	// recent intervals for the percentile
+	std::vector<double> m_recentIntervals;
+	size_t m_nextRecentInterval;
+};
@@ -0,0 +1,449 @@
+/////////////////////////////////////////////////////////////////////////////////
+// GoldenImageCheck.cpp
+// ====================
+// regression check of rendered views against stored reference images and timings
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "GoldenImageCheck.h"
+#include "ImageWriter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "GLFW/glfw3.h"
+
+namespace
+{
+	// renders before timing starts, to fill caches and finish lazy driver work
+	const int g_WarmupRenders = 2;
+	// timed renders per view; the median is reported
+	const int g_TimedRenders = 7;
+	// share of a view's pixels that may differ before the view fails
+	const double g_MaxDifferentFraction = 0.001;
+	// change in render time, either way, reported as slower or faster
+	const double g_TimingChangeFraction = 0.10;
+	const char* g_BaselineFilename = "baseline.txt";
+}
+
+/***********************************************************
+ *  GoldenImageCheck()
+ ***********************************************************/
+GoldenImageCheck::GoldenImageCheck()
+	: m_channelTolerance(8),
+	m_pSoftwareRasterizer(NULL),
+	m_framebuffer(0),
+	m_colorBuffer(0),
+	m_depthBuffer(0),
+	m_targetSize(0)
+{
+}
+
+/***********************************************************
+ *  ~GoldenImageCheck()
+ ***********************************************************/
+GoldenImageCheck::~GoldenImageCheck()
+{
+	DestroyTarget();
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for checking every pose and printing
+ *  one line per view, then the total render time against the
+ *  baseline total for the views both runs have.
+ ***********************************************************/
+bool GoldenImageCheck::Run(
+	SceneManager* pSceneManager,
+	const std::vector<CAMERA_POSE>& poses,
+	int imageSize,
+	const std::string& goldenFolder,
+	bool bUpdate)
+{
+	PROFILE_SCOPE("GoldenImageCheck");
+
+	if ((NULL == pSceneManager) || poses.empty() || (imageSize <= 0))
+	{
+		return false;
+	}
+
+	std::string baselineFilename = goldenFolder + "/" + g_BaselineFilename;
+	std::map<std::string, VIEW_BASELINE> baseline;
+	if (bUpdate == false)
+	{
+		LoadBaseline(baselineFilename, baseline);
+	}
+	bool bBaselineChanged = false;
+
+	printf("INFO: Golden image check of %d views at %dx%d against %s (tolerance %d/255, %s)\n",
+		(int)poses.size(), imageSize, imageSize, goldenFolder.c_str(), m_channelTolerance,
+		(NULL != m_pSoftwareRasterizer) ? "software" : "OpenGL");
+	printf("  %-20s %-8s %9s %4s %9s %9s %8s %7s %7s\n",
+		"view", "result", "differ %", "max", "ms", "base ms", "change", "draws", "base");
+
+	int failedCount = 0;
+	double totalMilliseconds = 0.0;
+	double totalBaselineMilliseconds = 0.0;
+	std::vector<uint8_t> reference;
+
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		const CAMERA_POSE& pose = poses[i];
+		VIEW_BASELINE measured;
+		if (RenderPose(pSceneManager, pose, imageSize, measured) == false)
+		{
+			printf("  %-20s %-8s\n", pose.name.c_str(), "ERROR");
+			failedCount++;
+			continue;
+		}
+
+		// compare with the reference, or record it when there is none yet
+		std::string basePath = goldenFolder + "/" + pose.name;
+		std::string referenceFilename = basePath + ".qoi";
+		const char* result = "ok";
+		double differentPercent = 0.0;
+		int maxDifference = 0;
+		int referenceWidth = 0;
+		int referenceHeight = 0;
+
+		if (bUpdate || (ImageWriter::ReadQOI(referenceFilename.c_str(), referenceWidth, referenceHeight, reference) == false))
+		{
+			if (ImageWriter::WriteImage(referenceFilename.c_str(), IMAGE_FORMAT_QOI, imageSize, imageSize, &m_pixels[0], (ptrdiff_t)imageSize * 4))
+			{
+				result = "recorded";
+			}
+			else
+			{
+				result = "ERROR";
+				failedCount++;
+			}
+		}
+		else if ((referenceWidth != imageSize) || (referenceHeight != imageSize))
+		{
+			result = "SIZE";
+			failedCount++;
+		}
+		else
+		{
+			size_t differentPixels = CountDifferentPixels(reference, maxDifference);
+			size_t pixelCount = (size_t)imageSize * imageSize;
+			differentPercent = (100.0 * differentPixels) / pixelCount;
+			if (differentPixels > (size_t)(pixelCount * g_MaxDifferentFraction))
+			{
+				result = "FAIL";
+				failedCount++;
+				WriteFailureImages(basePath, reference, imageSize);
+			}
+		}
+
+		// timing and draw counters against the baseline
+		std::map<std::string, VIEW_BASELINE>::iterator entry = baseline.find(pose.name);
+		if (entry == baseline.end())
+		{
+			baseline[pose.name] = measured;
+			bBaselineChanged = true;
+			printf("  %-20s %-8s %9.3f %4d %9.3f %9s %8s %7llu %7s\n",
+				pose.name.c_str(), result, differentPercent, maxDifference, measured.milliseconds,
+				"-", "new", (unsigned long long)measured.drawCalls, "-");
+			continue;
+		}
+
+		const VIEW_BASELINE& previous = entry->second;
+		double change = (previous.milliseconds > 0.0) ? (measured.milliseconds / previous.milliseconds) - 1.0 : 0.0;
+		const char* changeNote = "";
+		if (change > g_TimingChangeFraction)
+		{
+			changeNote = " slower";
+		}
+		else if (change < -g_TimingChangeFraction)
+		{
+			changeNote = " faster";
+		}
+
+		printf("  %-20s %-8s %9.3f %4d %9.3f %9.3f %+7.1f%% %7llu %7llu%s\n",
+			pose.name.c_str(), result, differentPercent, maxDifference, measured.milliseconds,
+			previous.milliseconds, change * 100.0, (unsigned long long)measured.drawCalls,
+			(unsigned long long)previous.drawCalls, changeNote);
+
+		totalMilliseconds += measured.milliseconds;
+		totalBaselineMilliseconds += previous.milliseconds;
+	}
+
+	if (totalBaselineMilliseconds > 0.0)
+	{
+		printf("  total %.3f ms against a baseline of %.3f ms (%+.1f%%)\n",
+			totalMilliseconds, totalBaselineMilliseconds,
+			((totalMilliseconds / totalBaselineMilliseconds) - 1.0) * 100.0);
+	}
+	printf("  %d of %d views failed\n", failedCount, (int)poses.size());
+	fflush(stdout);
+
+	if (bBaselineChanged)
+	{
+		SaveBaseline(baselineFilename, baseline);
+	}
+
+	return (failedCount == 0);
+}
+
+/***********************************************************
+ *  RenderPose()
+ *
+ *  This method is used for rendering one view the warmup
+ *  count plus the timed count of times. Each GL render is
+ *  waited for with glFinish(), so the time covers the GPU
+ *  work as well, and the draw counters are those of the last
+ *  render alone.
+ ***********************************************************/
+bool GoldenImageCheck::RenderPose(SceneManager* pSceneManager, const CAMERA_POSE& pose, int imageSize, VIEW_BASELINE& measured)
+{
+	SCENE_VIEW sceneView;
+	ViewManager::BuildCameraPoseView(pose, 1.0f, sceneView);
+
+	if ((NULL == m_pSoftwareRasterizer) && (CreateTarget(imageSize) == false))
+	{
+		return false;
+	}
+
+	std::vector<double> renderTimes;
+	for (int render = 0; render < g_WarmupRenders + g_TimedRenders; render++)
+	{
+		RenderStats::EndFrame();
+		double startTime = glfwGetTime();
+
+		if (NULL != m_pSoftwareRasterizer)
+		{
+			m_pSoftwareRasterizer->RenderView(pSceneManager, sceneView, imageSize, imageSize);
+		}
+		else
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+			glViewport(0, 0, imageSize, imageSize);
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			pSceneManager->RenderSceneViews(&sceneView, 1, imageSize, imageSize);
+			glFinish();
+		}
+
+		if (render >= g_WarmupRenders)
+		{
+			renderTimes.push_back((glfwGetTime() - startTime) * 1000.0);
+		}
+	}
+
+	const RENDER_STATS& stats = RenderStats::GetCurrentStats();
+	measured.drawCalls = stats.drawCalls;
+	measured.triangles = stats.triangles;
+	std::sort(renderTimes.begin(), renderTimes.end());
+	measured.milliseconds = renderTimes[renderTimes.size() / 2];
+
+	// keep the image top row first, the order the reference is stored in
+	size_t rowBytes = (size_t)imageSize * 4;
+	m_pixels.resize(rowBytes * imageSize);
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		std::copy(m_pSoftwareRasterizer->GetPixels(), m_pSoftwareRasterizer->GetPixels() + m_pixels.size(), m_pixels.begin());
+	}
+	else
+	{
+		m_readback.resize(m_pixels.size());
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, imageSize, imageSize, GL_RGBA, GL_UNSIGNED_BYTE, &m_readback[0]);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		for (int y = 0; y < imageSize; y++)
+		{
+			std::copy(
+				m_readback.begin() + (imageSize - 1 - y) * rowBytes,
+				m_readback.begin() + (imageSize - y) * rowBytes,
+				m_pixels.begin() + y * rowBytes);
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  CountDifferentPixels()
+ ***********************************************************/
+size_t GoldenImageCheck::CountDifferentPixels(const std::vector<uint8_t>& reference, int& maxDifference) const
+{
+	size_t differentPixels = 0;
+	maxDifference = 0;
+
+	for (size_t i = 0; i < m_pixels.size(); i += 4)
+	{
+		int pixelDifference = 0;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			pixelDifference = std::max(pixelDifference, abs((int)m_pixels[i + channel] - (int)reference[i + channel]));
+		}
+
+		maxDifference = std::max(maxDifference, pixelDifference);
+		if (pixelDifference > m_channelTolerance)
+		{
+			differentPixels++;
+		}
+	}
+
+	return differentPixels;
+}
+
+/***********************************************************
+ *  WriteFailureImages()
+ *
+ *  This method is used for saving what a failed view looked
+ *  like. The diff image shows the reference dimmed, with the
+ *  pixels past the tolerance in red.
+ ***********************************************************/
+void GoldenImageCheck::WriteFailureImages(const std::string& basePath, const std::vector<uint8_t>& reference, int imageSize) const
+{
+	ptrdiff_t rowStride = (ptrdiff_t)imageSize * 4;
+	std::string actualFilename = basePath + ".actual.png";
+	ImageWriter::WriteImage(actualFilename.c_str(), IMAGE_FORMAT_PNG, imageSize, imageSize, &m_pixels[0], rowStride);
+
+	std::vector<uint8_t> diff(m_pixels.size());
+	for (size_t i = 0; i < m_pixels.size(); i += 4)
+	{
+		int pixelDifference = 0;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			pixelDifference = std::max(pixelDifference, abs((int)m_pixels[i + channel] - (int)reference[i + channel]));
+		}
+
+		if (pixelDifference > m_channelTolerance)
+		{
+			diff[i + 0] = 255;
+			diff[i + 1] = 0;
+			diff[i + 2] = 0;
+		}
+		else
+		{
+			diff[i + 0] = reference[i + 0] / 4;
+			diff[i + 1] = reference[i + 1] / 4;
+			diff[i + 2] = reference[i + 2] / 4;
+		}
+		diff[i + 3] = 255;
+	}
+
+	std::string diffFilename = basePath + ".diff.png";
+	ImageWriter::WriteImage(diffFilename.c_str(), IMAGE_FORMAT_PNG, imageSize, imageSize, &diff[0], rowStride);
+}
+
+/***********************************************************
+ *  LoadBaseline()
+ *
+ *  This method is used for reading the baseline file, one
+ *  view per line: name milliseconds drawCalls triangles.
+ ***********************************************************/
+bool GoldenImageCheck::LoadBaseline(const std::string& filename, std::map<std::string, VIEW_BASELINE>& baseline)
+{
+	std::ifstream file(filename.c_str());
+	if (!file)
+	{
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string name;
+		VIEW_BASELINE entry;
+		if (!(fields >> name) || (name[0] == '#'))
+		{
+			continue;
+		}
+		if (fields >> entry.milliseconds >> entry.drawCalls >> entry.triangles)
+		{
+			baseline[name] = entry;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SaveBaseline()
+ ***********************************************************/
+bool GoldenImageCheck::SaveBaseline(const std::string& filename, const std::map<std::string, VIEW_BASELINE>& baseline)
+{
+	std::ofstream file(filename.c_str());
+	if (!file)
+	{
+		std::cout << "Could not write the baseline file: " << filename << std::endl;
+		return false;
+	}
+
+	file << "# view milliseconds drawCalls triangles" << std::endl;
+	for (std::map<std::string, VIEW_BASELINE>::const_iterator entry = baseline.begin(); entry != baseline.end(); ++entry)
+	{
+		file << entry->first << " " << entry->second.milliseconds << " "
+			<< entry->second.drawCalls << " " << entry->second.triangles << std::endl;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  CreateTarget()
+ ***********************************************************/
+bool GoldenImageCheck::CreateTarget(int imageSize)
+{
+	if ((m_framebuffer != 0) && (imageSize == m_targetSize))
+	{
+		return true;
+	}
+
+	DestroyTarget();
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, imageSize, imageSize);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, imageSize, imageSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Could not create the " << imageSize << "x" << imageSize << " golden image framebuffer" << std::endl;
+		DestroyTarget();
+		return false;
+	}
+
+	m_targetSize = imageSize;
+	return true;
+}
+
+/***********************************************************
+ *  DestroyTarget()
+ ***********************************************************/
+void GoldenImageCheck::DestroyTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+
+	m_targetSize = 0;
+}
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////
+// GoldenImageCheck.h
+// ==================
+// regression check of rendered views against stored reference images and timings
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "RenderStats.h"
+#include "SceneManager.h"
+#include "SoftwareRasterizer.h"
+#include "ViewManager.h"
+
+/***********************************************************
+ *  GoldenImageCheck
+ *
+ *  Renders each camera pose offscreen, several times, and
+ *  compares the image with <folder>/<name>.qoi. A pixel
+ *  differs when any channel is further off than the channel
+ *  tolerance, and a view fails when more than a small share
+ *  of its pixels differ, so driver rounding does not fail a
+ *  run but a missing object or wrong lighting does. Failed
+ *  views get <name>.actual.png and <name>.diff.png written
+ *  next to the reference.
+ *
+ *  The median render time and the draw counters of each view
+ *  are compared with <folder>/baseline.txt. Missing reference
+ *  images and baseline entries are recorded from this run;
+ *  updating records all of them again.
+ ***********************************************************/
+class GoldenImageCheck
+{
+public:
+	GoldenImageCheck();
+	~GoldenImageCheck();
+
+	// channel difference, out of 255, below which pixels count as equal
+	void SetTolerance(int channelTolerance) { m_channelTolerance = channelTolerance; }
+	// render with the CPU rasterizer instead of OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pSoftwareRasterizer) { m_pSoftwareRasterizer = pSoftwareRasterizer; }
+
+	// check every pose at imageSize x imageSize; false if any view failed
+	bool Run(
+		SceneManager* pSceneManager,
+		const std::vector<CAMERA_POSE>& poses,
+		int imageSize,
+		const std::string& goldenFolder,
+		bool bUpdate);
+
+private:
+	// timing and draw counters of one view
+	struct VIEW_BASELINE
+	{
+		double milliseconds = 0.0;
+		uint64_t drawCalls = 0;
+		uint64_t triangles = 0;
+	};
+
+	int m_channelTolerance;
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_targetSize;
+	// the last rendered view, top row first
+	std::vector<uint8_t> m_pixels;
+	std::vector<uint8_t> m_readback;
+
+	// render a pose several times into m_pixels, timing each render
+	bool RenderPose(SceneManager* pSceneManager, const CAMERA_POSE& pose, int imageSize, VIEW_BASELINE& measured);
+	// count the pixels of m_pixels further from the reference than the tolerance
+	size_t CountDifferentPixels(const std::vector<uint8_t>& reference, int& maxDifference) const;
+	// write the render and a map of the differing pixels next to the reference
+	void WriteFailureImages(const std::string& basePath, const std::vector<uint8_t>& reference, int imageSize) const;
+
+	static bool LoadBaseline(const std::string& filename, std::map<std::string, VIEW_BASELINE>& baseline);
+	static bool SaveBaseline(const std::string& filename, const std::map<std::string, VIEW_BASELINE>& baseline);
+
+	bool CreateTarget(int imageSize);
+	void DestroyTarget();
+};
@@ -0,0 +1,370 @@
+/////////////////////////////////////////////////////////////////////////////////
+// GpuTimer.cpp
+// ============
+// per render pass GPU timing with timestamp queries
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "GpuTimer.h"
+
+#include <cstring>
+
+namespace
+{
+	// weight of the newest frame in the smoothed pass times
+	const double g_AverageWeight = 0.1;
+}
+
+/***********************************************************
+ *  GpuTimer()
+ ***********************************************************/
+GpuTimer::GpuTimer()
+	: m_currentFrame(0),
+	m_bInitialized(false),
+	m_resolvedPassCount(0),
+	m_resolvedFrameCount(0),
+	m_newFrameCount(0)
+{
+	memset(m_frames, 0, sizeof(m_frames));
+	memset(m_newFrames, 0, sizeof(m_newFrames));
+
+	for (int i = 0; i < MAX_PASSES; i++)
+	{
+		m_resolvedNames[i] = "";
+		m_resolvedMilliseconds[i] = 0.0;
+		m_averageMilliseconds[i] = 0.0;
+	}
+}
+
+/***********************************************************
+ *  ~GpuTimer()
+ ***********************************************************/
+GpuTimer::~GpuTimer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating two timestamp queries for
+ *  every pass slot of every frame in the ring.
+ ***********************************************************/
+bool GpuTimer::Initialize()
+{
+	if (m_bInitialized)
+	{
+		return true;
+	}
+
+	for (int frame = 0; frame < FRAME_LATENCY; frame++)
+	{
+		for (int pass = 0; pass < MAX_PASSES; pass++)
+		{
+			glGenQueries(1, &m_frames[frame].passes[pass].beginQuery);
+			glGenQueries(1, &m_frames[frame].passes[pass].endQuery);
+		}
+		m_frames[frame].passCount = 0;
+		m_frames[frame].bPending = false;
+	}
+
+	m_currentFrame = 0;
+	m_bInitialized = true;
+
+	return (glGetError() == GL_NO_ERROR);
+}
+
+/***********************************************************
+ *  Destroy()
+ ***********************************************************/
+void GpuTimer::Destroy()
+{
+	if (m_bInitialized == false)
+	{
+		return;
+	}
+
+	for (int frame = 0; frame < FRAME_LATENCY; frame++)
+	{
+		for (int pass = 0; pass < MAX_PASSES; pass++)
+		{
+			glDeleteQueries(1, &m_frames[frame].passes[pass].beginQuery);
+			glDeleteQueries(1, &m_frames[frame].passes[pass].endQuery);
+		}
+	}
+
+	m_bInitialized = false;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving to the next frame in the
+ *  ring and reading back every pending frame that is ready,
+ *  oldest first, so the latest results and the smoothed
+ *  times end on the newest frame. The slot
+ *  being reused holds the oldest frame, from FRAME_LATENCY
+ *  frames ago; if it is not ready it is dropped rather than
+ *  waiting on the GPU.
+ ***********************************************************/
+void GpuTimer::BeginFrame()
+{
+	if (m_bInitialized == false)
+	{
+		return;
+	}
+
+	m_currentFrame = (m_currentFrame + 1) % FRAME_LATENCY;
+	m_newFrameCount = 0;
+
+	for (int i = 0; i < FRAME_LATENCY; i++)
+	{
+		FRAME_QUERIES& frame = m_frames[(m_currentFrame + i) % FRAME_LATENCY];
+		if (frame.bPending == false)
+		{
+			continue;
+		}
+
+		// the GPU finishes frames in order, so the newer ones are not ready either
+		if (ResolveFrame(frame) == false)
+		{
+			break;
+		}
+	}
+
+	m_frames[m_currentFrame].passCount = 0;
+	m_frames[m_currentFrame].bPending = false;
+}
+
+/***********************************************************
+ *  EndFrame()
+ ***********************************************************/
+void GpuTimer::EndFrame()
+{
+	if (m_bInitialized == false)
+	{
+		return;
+	}
+
+	m_frames[m_currentFrame].bPending = (m_frames[m_currentFrame].passCount > 0);
+}
+
+/***********************************************************
+ *  BeginPass()
+ ***********************************************************/
+void GpuTimer::BeginPass(const char* passName)
+{
+	FRAME_QUERIES& frame = m_frames[m_currentFrame];
+
+	if ((m_bInitialized == false) || (frame.passCount >= MAX_PASSES))
+	{
+		return;
+	}
+
+	PASS_QUERIES& pass = frame.passes[frame.passCount];
+	pass.name = passName;
+	pass.bEnded = false;
+	glQueryCounter(pass.beginQuery, GL_TIMESTAMP);
+
+	frame.passCount++;
+}
+
+/***********************************************************
+ *  EndPass()
+ ***********************************************************/
+void GpuTimer::EndPass(const char* passName)
+{
+	FRAME_QUERIES& frame = m_frames[m_currentFrame];
+
+	if (m_bInitialized == false)
+	{
+		return;
+	}
+
+	// close the most recent open pass with this name
+	for (int i = frame.passCount - 1; i >= 0; i--)
+	{
+		PASS_QUERIES& pass = frame.passes[i];
+		if ((pass.bEnded == false) && (strcmp(pass.name, passName) == 0))
+		{
+			glQueryCounter(pass.endQuery, GL_TIMESTAMP);
+			pass.bEnded = true;
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  ResolveFrame()
+ *
+ *  This method is used for reading back the timestamps of a
+ *  frame. The last query of a frame is issued last, so if it
+ *  is available all the earlier ones are as well.
+ ***********************************************************/
+bool GpuTimer::ResolveFrame(FRAME_QUERIES& frame)
+{
+	if (frame.passCount == 0)
+	{
+		frame.bPending = false;
+		return false;
+	}
+
+	GLint available = 0;
+	const PASS_QUERIES& lastPass = frame.passes[frame.passCount - 1];
+	glGetQueryObjectiv(
+		lastPass.bEnded ? lastPass.endQuery : lastPass.beginQuery,
+		GL_QUERY_RESULT_AVAILABLE,
+		&available);
+
+	if (available == 0)
+	{
+		return false;
+	}
+
+	// the first pass ends last when passes nest, so check every end
+	for (int i = 0; i < frame.passCount; i++)
+	{
+		if (frame.passes[i].bEnded)
+		{
+			glGetQueryObjectiv(frame.passes[i].endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available == 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	RESOLVED_FRAME& newFrame = m_newFrames[m_newFrameCount++];
+	newFrame.passCount = 0;
+
+	m_resolvedPassCount = 0;
+	for (int i = 0; i < frame.passCount; i++)
+	{
+		const PASS_QUERIES& pass = frame.passes[i];
+		if (pass.bEnded == false)
+		{
+			continue;
+		}
+
+		GLuint64 beginTime = 0;
+		GLuint64 endTime = 0;
+		glGetQueryObjectui64v(pass.beginQuery, GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(pass.endQuery, GL_QUERY_RESULT, &endTime);
+
+		int slot = m_resolvedPassCount++;
+		double milliseconds = (endTime > beginTime) ? (endTime - beginTime) / 1.0e6 : 0.0;
+
+		// restart the average if a different pass lands in this slot
+		if ((m_resolvedNames[slot] == NULL) || (strcmp(m_resolvedNames[slot], pass.name) != 0))
+		{
+			m_averageMilliseconds[slot] = milliseconds;
+		}
+		else
+		{
+			m_averageMilliseconds[slot] += (milliseconds - m_averageMilliseconds[slot]) * g_AverageWeight;
+		}
+
+		m_resolvedNames[slot] = pass.name;
+		m_resolvedMilliseconds[slot] = milliseconds;
+		newFrame.names[slot] = pass.name;
+		newFrame.milliseconds[slot] = milliseconds;
+		newFrame.passCount++;
+	}
+
+	frame.bPending = false;
+	m_resolvedFrameCount++;
+	return true;
+}
+
+/***********************************************************
+ *  GetPassName()
+ ***********************************************************/
+const char* GpuTimer::GetPassName(int passIndex) const
+{
+	if ((passIndex < 0) || (passIndex >= m_resolvedPassCount))
+	{
+		return "";
+	}
+
+	return m_resolvedNames[passIndex];
+}
+
+/***********************************************************
+ *  GetPassMilliseconds()
+ ***********************************************************/
+double GpuTimer::GetPassMilliseconds(int passIndex) const
+{
+	if ((passIndex < 0) || (passIndex >= m_resolvedPassCount))
+	{
+		return 0.0;
+	}
+
+	return m_resolvedMilliseconds[passIndex];
+}
+
+/***********************************************************
+ *  GetAveragePassMilliseconds()
+ ***********************************************************/
+double GpuTimer::GetAveragePassMilliseconds(int passIndex) const
+{
+	if ((passIndex < 0) || (passIndex >= m_resolvedPassCount))
+	{
+		return 0.0;
+	}
+
+	return m_averageMilliseconds[passIndex];
+}
+
+/***********************************************************
+ *  GetAveragePassMilliseconds()
+ ***********************************************************/
+double GpuTimer::GetAveragePassMilliseconds(const char* passName) const
+{
+	for (int i = 0; i < m_resolvedPassCount; i++)
+	{
+		if (strcmp(m_resolvedNames[i], passName) == 0)
+		{
+			return m_averageMilliseconds[i];
+		}
+	}
+
+	return 0.0;
+}
+
+/***********************************************************
+ *  GetNewFramePassCount()
+ ***********************************************************/
+int GpuTimer::GetNewFramePassCount(int frameIndex) const
+{
+	if ((frameIndex < 0) || (frameIndex >= m_newFrameCount))
+	{
+		return 0;
+	}
+
+	return m_newFrames[frameIndex].passCount;
+}
+
+/***********************************************************
+ *  GetNewFramePassName()
+ ***********************************************************/
+const char* GpuTimer::GetNewFramePassName(int frameIndex, int passIndex) const
+{
+	if ((passIndex < 0) || (passIndex >= GetNewFramePassCount(frameIndex)))
+	{
+		return "";
+	}
+
+	return m_newFrames[frameIndex].names[passIndex];
+}
+
+/***********************************************************
+ *  GetNewFramePassMilliseconds()
+ ***********************************************************/
+double GpuTimer::GetNewFramePassMilliseconds(int frameIndex, int passIndex) const
+{
+	if ((passIndex < 0) || (passIndex >= GetNewFramePassCount(frameIndex)))
+	{
+		return 0.0;
+	}
+
+	return m_newFrames[frameIndex].milliseconds[passIndex];
+}
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////
+// GpuTimer.h
+// ==========
+// per render pass GPU timing with timestamp queries
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GpuTimer
+ *
+ *  Each pass records a GL_TIMESTAMP query where it begins and
+ *  ends, so passes may nest. Queries go into a ring of frames
+ *  and are only read back once the GPU reports them ready, a
+ *  few frames later, so timing never stalls the pipeline.
+ ***********************************************************/
+class GpuTimer
+{
+public:
+	// most passes that can be timed in one frame
+	static const int MAX_PASSES = 8;
+	// frames in flight before a frame's queries are read back
+	static const int FRAME_LATENCY = 4;
+
+	GpuTimer();
+	~GpuTimer();
+
+	// create the query objects; needs a current GL context
+	bool Initialize();
+	// delete the query objects
+	void Destroy();
+
+	// start a new frame, reading back any frame whose results are ready
+	void BeginFrame();
+	void EndFrame();
+
+	// mark the start and end of a named pass; the name must stay valid
+	void BeginPass(const char* passName);
+	void EndPass(const char* passName);
+
+	// passes seen in the last frame that was read back
+	int GetPassCount() const { return m_resolvedPassCount; }
+	const char* GetPassName(int passIndex) const;
+	// GPU time of the pass in the last frame that was read back
+	double GetPassMilliseconds(int passIndex) const;
+	// GPU time of the pass, smoothed over recent frames
+	double GetAveragePassMilliseconds(int passIndex) const;
+	// GPU time of a pass found by name, or 0 if it was not seen
+	double GetAveragePassMilliseconds(const char* passName) const;
+	// number of frames that have been read back so far
+	unsigned int GetResolvedFrameCount() const { return m_resolvedFrameCount; }
+
+	// frames read back by the last BeginFrame(), oldest first; several can
+	// come back at once, so totals must add up each of them
+	int GetNewFrameCount() const { return m_newFrameCount; }
+	int GetNewFramePassCount(int frameIndex) const;
+	const char* GetNewFramePassName(int frameIndex, int passIndex) const;
+	double GetNewFramePassMilliseconds(int frameIndex, int passIndex) const;
+
+private:
+	struct PASS_QUERIES
+	{
+		const char* name;
+		GLuint beginQuery;
+		GLuint endQuery;
+		bool bEnded;
+	};
+
+	struct FRAME_QUERIES
+	{
+		PASS_QUERIES passes[MAX_PASSES];
+		int passCount;
+		bool bPending;
+	};
+
+	struct RESOLVED_FRAME
+	{
+		const char* names[MAX_PASSES];
+		double milliseconds[MAX_PASSES];
+		int passCount;
+	};
+
+	FRAME_QUERIES m_frames[FRAME_LATENCY];
+	int m_currentFrame;
+	bool m_bInitialized;
+
+	// results of the last frame read back
+	const char* m_resolvedNames[MAX_PASSES];
+	double m_resolvedMilliseconds[MAX_PASSES];
+	double m_averageMilliseconds[MAX_PASSES];
+	int m_resolvedPassCount;
+	unsigned int m_resolvedFrameCount;
+	// every frame read back by the last BeginFrame(), oldest first
+	RESOLVED_FRAME m_newFrames[FRAME_LATENCY];
+	int m_newFrameCount;
+
+	// read back a frame if all of its queries are available
+	bool ResolveFrame(FRAME_QUERIES& frame);
+};
@@ -0,0 +1,455 @@
+/////////////////////////////////////////////////////////////////////////////////
+// ImageWriter.cpp
+// ===============
+// PNG and QOI encoders for rendered RGBA images, and a QOI decoder
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// largest block of a stored (uncompressed) deflate stream
+	const size_t g_MaxStoredBlock = 65535;
+
+	/***********************************************************
+	 *  AppendBigEndian32()
+	 ***********************************************************/
+	void AppendBigEndian32(std::vector<uint8_t>& output, uint32_t value)
+	{
+		output.push_back((uint8_t)(value >> 24));
+		output.push_back((uint8_t)(value >> 16));
+		output.push_back((uint8_t)(value >> 8));
+		output.push_back((uint8_t)value);
+	}
+
+	/***********************************************************
+	 *  GetCRC32()
+	 *
+	 *  CRC-32 as used by PNG chunks, built on a table computed
+	 *  the first time it is needed.
+	 ***********************************************************/
+	uint32_t GetCRC32(const uint8_t* pData, size_t length)
+	{
+		static uint32_t table[256];
+		static bool bTableReady = false;
+
+		if (bTableReady == false)
+		{
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				table[n] = c;
+			}
+			bTableReady = true;
+		}
+
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = 0; i < length; i++)
+		{
+			crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	/***********************************************************
+	 *  ReadBigEndian32()
+	 ***********************************************************/
+	uint32_t ReadBigEndian32(const uint8_t* pData)
+	{
+		return ((uint32_t)pData[0] << 24) | ((uint32_t)pData[1] << 16) | ((uint32_t)pData[2] << 8) | (uint32_t)pData[3];
+	}
+
+	/***********************************************************
+	 *  AppendPNGChunk()
+	 ***********************************************************/
+	void AppendPNGChunk(std::vector<uint8_t>& output, const char* type, const uint8_t* pData, size_t length)
+	{
+		AppendBigEndian32(output, (uint32_t)length);
+
+		size_t typeOffset = output.size();
+		output.insert(output.end(), type, type + 4);
+		if (length > 0)
+		{
+			output.insert(output.end(), pData, pData + length);
+		}
+
+		AppendBigEndian32(output, GetCRC32(&output[typeOffset], length + 4));
+	}
+}
+
+/***********************************************************
+ *  EncodeQOI()
+ *
+ *  This method is used for encoding with the "Quite OK Image"
+ *  format: each pixel becomes a run, an index into the 64
+ *  most recently hashed colors, a small difference from the
+ *  previous pixel, or the full color.
+ ***********************************************************/
+void ImageWriter::EncodeQOI(int width, int height, const uint8_t* pTopRow, ptrdiff_t rowStride, std::vector<uint8_t>& output)
+{
+	output.clear();
+	output.reserve(14 + (size_t)width * height * 2 + 8);
+
+	// header: magic, size, 4 channels, sRGB with linear alpha
+	const char magic[4] = { 'q', 'o', 'i', 'f' };
+	output.insert(output.end(), magic, magic + 4);
+	AppendBigEndian32(output, (uint32_t)width);
+	AppendBigEndian32(output, (uint32_t)height);
+	output.push_back(4);
+	output.push_back(0);
+
+	uint8_t seen[64][4];
+	memset(seen, 0, sizeof(seen));
+	uint8_t previous[4] = { 0, 0, 0, 255 };
+	int run = 0;
+
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t* pRow = pTopRow + y * rowStride;
+
+		for (int x = 0; x < width; x++)
+		{
+			const uint8_t* pixel = pRow + x * 4;
+			bool bLastPixel = (y == height - 1) && (x == width - 1);
+
+			if (memcmp(pixel, previous, 4) == 0)
+			{
+				run++;
+				if ((run == 62) || bLastPixel)
+				{
+					output.push_back((uint8_t)(0xC0 | (run - 1)));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				output.push_back((uint8_t)(0xC0 | (run - 1)));
+				run = 0;
+			}
+
+			int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+
+			if (memcmp(seen[hash], pixel, 4) == 0)
+			{
+				output.push_back((uint8_t)hash);
+			}
+			else
+			{
+				memcpy(seen[hash], pixel, 4);
+
+				if (pixel[3] == previous[3])
+				{
+					int8_t dr = (int8_t)(pixel[0] - previous[0]);
+					int8_t dg = (int8_t)(pixel[1] - previous[1]);
+					int8_t db = (int8_t)(pixel[2] - previous[2]);
+					int8_t drdg = (int8_t)(dr - dg);
+					int8_t dbdg = (int8_t)(db - dg);
+
+					if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1))
+					{
+						output.push_back((uint8_t)(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+					}
+					else if ((dg >= -32) && (dg <= 31) && (drdg >= -8) && (drdg <= 7) && (dbdg >= -8) && (dbdg <= 7))
+					{
+						output.push_back((uint8_t)(0x80 | (dg + 32)));
+						output.push_back((uint8_t)(((drdg + 8) << 4) | (dbdg + 8)));
+					}
+					else
+					{
+						output.push_back(0xFE);
+						output.insert(output.end(), pixel, pixel + 3);
+					}
+				}
+				else
+				{
+					output.push_back(0xFF);
+					output.insert(output.end(), pixel, pixel + 4);
+				}
+			}
+
+			memcpy(previous, pixel, 4);
+		}
+	}
+
+	// end marker
+	const uint8_t padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	output.insert(output.end(), padding, padding + 8);
+}
+
+/***********************************************************
+ *  EncodePNG()
+ *
+ *  This method is used for encoding an RGBA PNG. The image
+ *  data is a zlib stream of stored deflate blocks, so there
+ *  is no compression, but every decoder can read it and it
+ *  costs little more than a copy to write.
+ ***********************************************************/
+void ImageWriter::EncodePNG(int width, int height, const uint8_t* pTopRow, ptrdiff_t rowStride, std::vector<uint8_t>& output)
+{
+	output.clear();
+
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	output.insert(output.end(), signature, signature + 8);
+
+	// 8 bits per channel, RGBA, no interlacing
+	std::vector<uint8_t> header;
+	AppendBigEndian32(header, (uint32_t)width);
+	AppendBigEndian32(header, (uint32_t)height);
+	header.push_back(8);
+	header.push_back(6);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	AppendPNGChunk(output, "IHDR", &header[0], header.size());
+
+	// scanlines with the "none" filter
+	size_t rowBytes = (size_t)width * 4;
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((rowBytes + 1) * height);
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t* pRow = pTopRow + y * rowStride;
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), pRow, pRow + rowBytes);
+	}
+
+	// zlib header, stored blocks, then the Adler-32 of the scanlines
+	std::vector<uint8_t> zlibData;
+	zlibData.reserve(scanlines.size() + scanlines.size() / g_MaxStoredBlock * 5 + 16);
+	zlibData.push_back(0x78);
+	zlibData.push_back(0x01);
+
+	size_t offset = 0;
+	do
+	{
+		size_t blockLength = std::min(g_MaxStoredBlock, scanlines.size() - offset);
+		bool bFinal = (offset + blockLength == scanlines.size());
+
+		zlibData.push_back(bFinal ? 1 : 0);
+		zlibData.push_back((uint8_t)(blockLength & 0xFF));
+		zlibData.push_back((uint8_t)(blockLength >> 8));
+		zlibData.push_back((uint8_t)(~blockLength & 0xFF));
+		zlibData.push_back((uint8_t)((~blockLength >> 8) & 0xFF));
+		zlibData.insert(zlibData.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockLength);
+
+		offset += blockLength;
+	} while (offset < scanlines.size());
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	for (size_t i = 0; i < scanlines.size(); i++)
+	{
+		adlerA = (adlerA + scanlines[i]) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	AppendBigEndian32(zlibData, (adlerB << 16) | adlerA);
+
+	AppendPNGChunk(output, "IDAT", &zlibData[0], zlibData.size());
+	AppendPNGChunk(output, "IEND", NULL, 0);
+}
+
+/***********************************************************
+ *  WriteImage()
+ ***********************************************************/
+bool ImageWriter::WriteImage(
+	const char* filename,
+	IMAGE_FORMAT format,
+	int width,
+	int height,
+	const uint8_t* pTopRow,
+	ptrdiff_t rowStride)
+{
+	std::vector<uint8_t> encoded;
+	if (format == IMAGE_FORMAT_PNG)
+	{
+		EncodePNG(width, height, pTopRow, rowStride, encoded);
+	}
+	else
+	{
+		EncodeQOI(width, height, pTopRow, rowStride, encoded);
+	}
+
+	FILE* file = fopen(filename, "wb");
+	if (NULL == file)
+	{
+		std::cout << "Could not open image file for writing: " << filename << std::endl;
+		return false;
+	}
+
+	bool bWritten = (fwrite(&encoded[0], 1, encoded.size(), file) == encoded.size());
+	fclose(file);
+
+	if (bWritten == false)
+	{
+		std::cout << "Could not write image file: " << filename << std::endl;
+	}
+	return bWritten;
+}
+
+/***********************************************************
+ *  ReadQOI()
+ ***********************************************************/
+bool ImageWriter::ReadQOI(const char* filename, int& width, int& height, std::vector<uint8_t>& pixels)
+{
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> encoded;
+	uint8_t buffer[65536];
+	size_t bytesRead;
+	while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		encoded.insert(encoded.end(), buffer, buffer + bytesRead);
+	}
+	fclose(file);
+
+	if (encoded.empty() || (DecodeQOI(&encoded[0], encoded.size(), width, height, pixels) == false))
+	{
+		std::cout << "Not a valid QOI image: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  DecodeQOI()
+ *
+ *  This method is used for reversing EncodeQOI(), and reads
+ *  any QOI stream with three or four channels. Three channel
+ *  images are given an alpha of 255.
+ ***********************************************************/
+bool ImageWriter::DecodeQOI(const uint8_t* pData, size_t length, int& width, int& height, std::vector<uint8_t>& pixels)
+{
+	// header plus the 8 byte end marker
+	if ((length < 22) || (memcmp(pData, "qoif", 4) != 0))
+	{
+		return false;
+	}
+
+	uint32_t imageWidth = ReadBigEndian32(pData + 4);
+	uint32_t imageHeight = ReadBigEndian32(pData + 8);
+	if ((imageWidth == 0) || (imageHeight == 0) || (imageWidth > 65536) || (imageHeight > 65536))
+	{
+		return false;
+	}
+
+	size_t pixelCount = (size_t)imageWidth * imageHeight;
+	pixels.resize(pixelCount * 4);
+
+	uint8_t seen[64][4];
+	memset(seen, 0, sizeof(seen));
+	uint8_t pixel[4] = { 0, 0, 0, 255 };
+	size_t position = 14;
+	size_t end = length - 8;
+	int run = 0;
+
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		if (run > 0)
+		{
+			run--;
+		}
+		else if (position < end)
+		{
+			uint8_t tag = pData[position++];
+
+			if (tag == 0xFE)
+			{
+				if (position + 3 > end)
+				{
+					return false;
+				}
+				memcpy(pixel, pData + position, 3);
+				position += 3;
+			}
+			else if (tag == 0xFF)
+			{
+				if (position + 4 > end)
+				{
+					return false;
+				}
+				memcpy(pixel, pData + position, 4);
+				position += 4;
+			}
+			else if ((tag & 0xC0) == 0x00)
+			{
+				memcpy(pixel, seen[tag], 4);
+			}
+			else if ((tag & 0xC0) == 0x40)
+			{
+				pixel[0] += ((tag >> 4) & 0x03) - 2;
+				pixel[1] += ((tag >> 2) & 0x03) - 2;
+				pixel[2] += (tag & 0x03) - 2;
+			}
+			else if ((tag & 0xC0) == 0x80)
+			{
+				if (position >= end)
+				{
+					return false;
+				}
+				uint8_t next = pData[position++];
+				int greenDifference = (tag & 0x3F) - 32;
+				pixel[0] += greenDifference - 8 + ((next >> 4) & 0x0F);
+				pixel[1] += greenDifference;
+				pixel[2] += greenDifference - 8 + (next & 0x0F);
+			}
+			else
+			{
+				run = tag & 0x3F;
+			}
+
+			int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+			memcpy(seen[hash], pixel, 4);
+		}
+		else
+		{
+			return false;
+		}
+
+		memcpy(&pixels[i * 4], pixel, 4);
+	}
+
+	width = (int)imageWidth;
+	height = (int)imageHeight;
+	return true;
+}
+
+/***********************************************************
+ *  GetExtension()
+ ***********************************************************/
+const char* ImageWriter::GetExtension(IMAGE_FORMAT format)
+{
+	return (format == IMAGE_FORMAT_PNG) ? "png" : "qoi";
+}
+
+/***********************************************************
+ *  ParseFormat()
+ ***********************************************************/
+bool ImageWriter::ParseFormat(const char* name, IMAGE_FORMAT& format)
+{
+	if (strcmp(name, "qoi") == 0)
+	{
+		format = IMAGE_FORMAT_QOI;
+		return true;
+	}
+	if (strcmp(name, "png") == 0)
+	{
+		format = IMAGE_FORMAT_PNG;
+		return true;
+	}
+	return false;
+}
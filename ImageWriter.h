@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////////////////////
+// ImageWriter.h
+// =============
+// PNG and QOI encoders for rendered RGBA images, and a QOI decoder
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum IMAGE_FORMAT
+{
+	// lossless and compact, quick to encode
+	IMAGE_FORMAT_QOI,
+	// opened by everything; stored without deflate compression
+	IMAGE_FORMAT_PNG
+};
+
+/***********************************************************
+ *  ImageWriter
+ *
+ *  Encodes 8-bit RGBA pixels to a file. Rows are read from a
+ *  pointer to the top row and a byte stride between rows, so
+ *  a bottom-up OpenGL readback, or one tile of a larger image,
+ *  is written without copying it first: pass the address of
+ *  its top row and a negative or wider stride. QOI files can
+ *  also be read back, for comparing against stored images.
+ ***********************************************************/
+class ImageWriter
+{
+public:
+	// encode and write an image, choosing the encoder by format
+	static bool WriteImage(
+		const char* filename,
+		IMAGE_FORMAT format,
+		int width,
+		int height,
+		const uint8_t* pTopRow,
+		ptrdiff_t rowStride);
+
+	// encode into memory
+	static void EncodeQOI(int width, int height, const uint8_t* pTopRow, ptrdiff_t rowStride, std::vector<uint8_t>& output);
+	static void EncodePNG(int width, int height, const uint8_t* pTopRow, ptrdiff_t rowStride, std::vector<uint8_t>& output);
+
+	// read a QOI file into 8-bit RGBA pixels, top row first
+	static bool ReadQOI(const char* filename, int& width, int& height, std::vector<uint8_t>& pixels);
+	static bool DecodeQOI(const uint8_t* pData, size_t length, int& width, int& height, std::vector<uint8_t>& pixels);
+
+	// file extension for a format, without the dot
+	static const char* GetExtension(IMAGE_FORMAT format);
+	// parse "qoi" or "png", false if the name is not a format
+	static bool ParseFormat(const char* name, IMAGE_FORMAT& format);
+};
@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////
+// InputQueue.cpp
+// ==============
+// lock-free single producer, single consumer queue of raw input events
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "InputQueue.h"
+
+/***********************************************************
+ *  InputQueue()
+ ***********************************************************/
+InputQueue::InputQueue()
+	: m_readIndex(0),
+	m_writeIndex(0),
+	m_droppedCount(0)
+{
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for adding an event at the write
+ *  index. The indexes only ever grow, so the queue is full
+ *  when they are a whole ring apart.
+ ***********************************************************/
+bool InputQueue::Push(const INPUT_EVENT& event)
+{
+	size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+	size_t readIndex = m_readIndex.load(std::memory_order_acquire);
+
+	if (writeIndex - readIndex >= CAPACITY)
+	{
+		m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_events[writeIndex & (CAPACITY - 1)] = event;
+	m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+
+	return true;
+}
+
+/***********************************************************
+ *  Pop()
+ ***********************************************************/
+bool InputQueue::Pop(INPUT_EVENT& event)
+{
+	size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+	size_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+
+	if (readIndex == writeIndex)
+	{
+		return false;
+	}
+
+	event = m_events[readIndex & (CAPACITY - 1)];
+	m_readIndex.store(readIndex + 1, std::memory_order_release);
+
+	return true;
+}
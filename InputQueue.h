@@ -0,0 +1,69 @@
+/////////////////////////////////////////////////////////////////////////////////
+// InputQueue.h
+// ============
+// lock-free single producer, single consumer queue of raw input events
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  INPUT_EVENT
+ *
+ *  One raw window event as GLFW reported it.
+ ***********************************************************/
+enum INPUT_EVENT_TYPE
+{
+	INPUT_EVENT_KEY,
+	INPUT_EVENT_MOUSE_POSITION,
+	INPUT_EVENT_MOUSE_SCROLL,
+	INPUT_EVENT_MOUSE_BUTTON
+};
+
+struct INPUT_EVENT
+{
+	INPUT_EVENT_TYPE type;
+	// key and mouse button events: GLFW key or button and action
+	int key;
+	int action;
+	// mouse events: cursor position or scroll offset
+	double x;
+	double y;
+};
+
+/***********************************************************
+ *  InputQueue
+ *
+ *  Fixed size ring buffer written by the window callbacks and
+ *  read by the update step. Each side only writes its own
+ *  index, publishing it with release order after touching the
+ *  slot, so neither side ever waits on the other. When the
+ *  ring is full new events are dropped and counted.
+ ***********************************************************/
+class InputQueue
+{
+public:
+	// slots in the ring; a power of two so indexes wrap with a mask
+	static const size_t CAPACITY = 1024;
+
+	InputQueue();
+
+	// producer side: add an event, false if the queue was full
+	bool Push(const INPUT_EVENT& event);
+	// consumer side: take the oldest event, false if the queue was empty
+	bool Pop(INPUT_EVENT& event);
+
+	// events dropped because the queue was full
+	unsigned int GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+	INPUT_EVENT m_events[CAPACITY];
+
+	// next slot to read, written only by the consumer
+	alignas(64) std::atomic<size_t> m_readIndex;
+	// next slot to write, written only by the producer
+	alignas(64) std::atomic<size_t> m_writeIndex;
+	std::atomic<unsigned int> m_droppedCount;
+};
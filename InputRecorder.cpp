@@ -0,0 +1,334 @@
+/////////////////////////////////////////////////////////////////////////////////
+// InputRecorder.cpp
+// =================
+// record input events and frame times to a binary log and replay them
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "InputRecorder.h"
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	const char g_LogMagic[4] = { 'I', 'R', 'E', 'C' };
+	const uint32_t g_LogVersion = 1;
+
+	/***********************************************************
+	 *  WriteValue()
+	 ***********************************************************/
+	template <typename T>
+	void WriteValue(FILE* file, T value)
+	{
+		fwrite(&value, sizeof(T), 1, file);
+	}
+
+	/***********************************************************
+	 *  ReadValue()
+	 *
+	 *  Copies a value out of the loaded log, returning false if
+	 *  the log ends first.
+	 ***********************************************************/
+	template <typename T>
+	bool ReadValue(const std::vector<uint8_t>& data, size_t& offset, T& value)
+	{
+		if (offset + sizeof(T) > data.size())
+		{
+			return false;
+		}
+
+		memcpy(&value, &data[offset], sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+}
+
+/***********************************************************
+ *  InputRecorder()
+ ***********************************************************/
+InputRecorder::InputRecorder()
+	: m_updateStepSeconds(0.0),
+	m_startTime(0.0),
+	m_pFile(NULL),
+	m_recordedFrames(0),
+	m_recordedEvents(0),
+	m_bReplaying(false),
+	m_replayTiming(REPLAY_ORIGINAL),
+	m_nextReplayFrame(0)
+{
+}
+
+/***********************************************************
+ *  ~InputRecorder()
+ ***********************************************************/
+InputRecorder::~InputRecorder()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  StartRecording()
+ ***********************************************************/
+bool InputRecorder::StartRecording(const char* filename, double updateStepSeconds, double startTime)
+{
+	Stop();
+
+	m_pFile = fopen(filename, "wb");
+	if (NULL == m_pFile)
+	{
+		std::cout << "Could not open input log for writing: " << filename << std::endl;
+		return false;
+	}
+
+	m_updateStepSeconds = updateStepSeconds;
+	m_startTime = startTime;
+	m_frameEvents.clear();
+	m_recordedFrames = 0;
+	m_recordedEvents = 0;
+
+	fwrite(g_LogMagic, 1, sizeof(g_LogMagic), m_pFile);
+	WriteValue<uint32_t>(m_pFile, g_LogVersion);
+	WriteValue<double>(m_pFile, updateStepSeconds);
+	WriteValue<double>(m_pFile, startTime);
+
+	return true;
+}
+
+/***********************************************************
+ *  RecordEvent()
+ ***********************************************************/
+void InputRecorder::RecordEvent(const INPUT_EVENT& event)
+{
+	if (NULL != m_pFile)
+	{
+		m_frameEvents.push_back(event);
+	}
+}
+
+/***********************************************************
+ *  RecordFrame()
+ *
+ *  This method is used for writing one frame: its update
+ *  clock time and the events applied before it, using only
+ *  the fields each event type needs.
+ ***********************************************************/
+void InputRecorder::RecordFrame(double updateTime)
+{
+	if (NULL == m_pFile)
+	{
+		return;
+	}
+
+	WriteValue<double>(m_pFile, updateTime);
+	WriteValue<uint32_t>(m_pFile, (uint32_t)m_frameEvents.size());
+
+	for (size_t i = 0; i < m_frameEvents.size(); i++)
+	{
+		const INPUT_EVENT& event = m_frameEvents[i];
+
+		WriteValue<uint8_t>(m_pFile, (uint8_t)event.type);
+		if ((event.type == INPUT_EVENT_KEY) || (event.type == INPUT_EVENT_MOUSE_BUTTON))
+		{
+			WriteValue<int16_t>(m_pFile, (int16_t)event.key);
+			WriteValue<uint8_t>(m_pFile, (uint8_t)event.action);
+		}
+		else
+		{
+			WriteValue<double>(m_pFile, event.x);
+			WriteValue<double>(m_pFile, event.y);
+		}
+	}
+
+	m_recordedFrames++;
+	m_recordedEvents += m_frameEvents.size();
+	m_frameEvents.clear();
+}
+
+/***********************************************************
+ *  StartReplay()
+ ***********************************************************/
+bool InputRecorder::StartReplay(const char* filename, REPLAY_TIMING timing)
+{
+	Stop();
+
+	FILE* file = fopen(filename, "rb");
+	if (NULL == file)
+	{
+		std::cout << "Could not open input log: " << filename << std::endl;
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	uint8_t buffer[4096];
+	size_t bytesRead = 0;
+	while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + bytesRead);
+	}
+	fclose(file);
+
+	size_t offset = 0;
+	char magic[4] = {};
+	uint32_t version = 0;
+	if ((data.size() < sizeof(magic)) || (memcmp(&data[0], g_LogMagic, sizeof(magic)) != 0))
+	{
+		std::cout << "Not an input log: " << filename << std::endl;
+		return false;
+	}
+	offset += sizeof(magic);
+
+	if ((ReadValue(data, offset, version) == false) || (version != g_LogVersion) ||
+		(ReadValue(data, offset, m_updateStepSeconds) == false) ||
+		(ReadValue(data, offset, m_startTime) == false) ||
+		(m_updateStepSeconds <= 0.0))
+	{
+		std::cout << "Unsupported input log version or header: " << filename << std::endl;
+		return false;
+	}
+
+	m_replayFrames.clear();
+	m_replayEvents.clear();
+
+	while (offset < data.size())
+	{
+		REPLAY_FRAME frame;
+		uint32_t eventCount = 0;
+		if ((ReadValue(data, offset, frame.updateTime) == false) ||
+			(ReadValue(data, offset, eventCount) == false))
+		{
+			std::cout << "Input log is truncated: " << filename << std::endl;
+			return false;
+		}
+
+		frame.firstEvent = m_replayEvents.size();
+		frame.eventCount = eventCount;
+
+		for (uint32_t i = 0; i < eventCount; i++)
+		{
+			INPUT_EVENT event = {};
+			uint8_t type = 0;
+			bool bRead = ReadValue(data, offset, type);
+			event.type = (INPUT_EVENT_TYPE)type;
+
+			if ((event.type == INPUT_EVENT_KEY) || (event.type == INPUT_EVENT_MOUSE_BUTTON))
+			{
+				int16_t key = 0;
+				uint8_t action = 0;
+				bRead = bRead && ReadValue(data, offset, key) && ReadValue(data, offset, action);
+				event.key = key;
+				event.action = action;
+			}
+			else
+			{
+				bRead = bRead && ReadValue(data, offset, event.x) && ReadValue(data, offset, event.y);
+			}
+
+			if (bRead == false)
+			{
+				std::cout << "Input log is truncated: " << filename << std::endl;
+				return false;
+			}
+			m_replayEvents.push_back(event);
+		}
+
+		m_replayFrames.push_back(frame);
+	}
+
+	m_replayTiming = timing;
+	m_nextReplayFrame = 0;
+	m_bReplaying = true;
+
+	std::cout << "INFO: Replaying " << m_replayFrames.size() << " frames and "
+		<< m_replayEvents.size() << " input events from " << filename
+		<< ((timing == REPLAY_FIXED) ? " with fixed timing" : " with original timing") << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  BeginReplayFrame()
+ ***********************************************************/
+bool InputRecorder::BeginReplayFrame()
+{
+	if ((m_bReplaying == false) || (m_nextReplayFrame >= m_replayFrames.size()))
+	{
+		return false;
+	}
+
+	m_nextReplayFrame++;
+
+	if (m_replayTiming == REPLAY_ORIGINAL)
+	{
+		// hold the frame until as much time has passed as when it was recorded
+		if (m_nextReplayFrame == 1)
+		{
+			m_replayWallStart = Clock::now();
+		}
+		double offsetSeconds = m_replayFrames[m_nextReplayFrame - 1].updateTime - m_replayFrames[0].updateTime;
+		std::this_thread::sleep_until(m_replayWallStart +
+			std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(offsetSeconds)));
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  GetReplayEventCount()
+ ***********************************************************/
+size_t InputRecorder::GetReplayEventCount() const
+{
+	if (m_nextReplayFrame == 0)
+	{
+		return 0;
+	}
+
+	return m_replayFrames[m_nextReplayFrame - 1].eventCount;
+}
+
+/***********************************************************
+ *  GetReplayEvent()
+ ***********************************************************/
+const INPUT_EVENT& InputRecorder::GetReplayEvent(size_t eventIndex) const
+{
+	return m_replayEvents[m_replayFrames[m_nextReplayFrame - 1].firstEvent + eventIndex];
+}
+
+/***********************************************************
+ *  GetReplayFrameTime()
+ ***********************************************************/
+double InputRecorder::GetReplayFrameTime() const
+{
+	if (m_nextReplayFrame == 0)
+	{
+		return m_startTime;
+	}
+
+	if (m_replayTiming == REPLAY_FIXED)
+	{
+		return m_startTime + m_nextReplayFrame * m_updateStepSeconds;
+	}
+
+	return m_replayFrames[m_nextReplayFrame - 1].updateTime;
+}
+
+/***********************************************************
+ *  Stop()
+ ***********************************************************/
+void InputRecorder::Stop()
+{
+	if (NULL != m_pFile)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+		std::cout << "INFO: Recorded " << m_recordedFrames << " frames and "
+			<< m_recordedEvents << " input events" << std::endl;
+	}
+
+	if (m_bReplaying)
+	{
+		std::cout << "INFO: Replayed " << m_nextReplayFrame << " of "
+			<< m_replayFrames.size() << " recorded frames" << std::endl;
+		m_bReplaying = false;
+	}
+}
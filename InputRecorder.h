@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////////////
+// InputRecorder.h
+// ===============
+// record input events and frame times to a binary log and replay them
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "InputQueue.h"
+
+/***********************************************************
+ *  InputRecorder
+ *
+ *  While recording, every input event the view manager
+ *  applies is written to the log together with the time each
+ *  frame passed to the fixed update clock. Replaying feeds the
+ *  same events to the same frames and the same clock times, so
+ *  the update steps, and with them the rendered frames, come
+ *  out the same on every run.
+ *
+ *  Log layout (native byte order):
+ *    header  "IREC", uint32 version, double update step
+ *            seconds, double update clock start time
+ *    frame   double update clock time, uint32 event count,
+ *            then the events
+ *    event   uint8 type, then int16 key and uint8 action for
+ *            key events, or two doubles for mouse events
+ ***********************************************************/
+class InputRecorder
+{
+public:
+	enum REPLAY_TIMING
+	{
+		// frames use the recorded clock times and are held until
+		// the same time has passed as in the recording
+		REPLAY_ORIGINAL,
+		// every frame advances the clock by exactly one update
+		// step, and frames run as fast as pacing allows
+		REPLAY_FIXED
+	};
+
+	InputRecorder();
+	~InputRecorder();
+
+	// start writing a new log; the start time is the update clock's reset time
+	bool StartRecording(const char* filename, double updateStepSeconds, double startTime);
+	// add an event applied during the current frame
+	void RecordEvent(const INPUT_EVENT& event);
+	// write the current frame's clock time and events
+	void RecordFrame(double updateTime);
+
+	// load a log for replay
+	bool StartReplay(const char* filename, REPLAY_TIMING timing);
+	// move to the next recorded frame, waiting for it in original timing;
+	// false once every frame has been replayed
+	bool BeginReplayFrame();
+	// events of the current replay frame
+	size_t GetReplayEventCount() const;
+	const INPUT_EVENT& GetReplayEvent(size_t eventIndex) const;
+	// update clock time of the current replay frame
+	double GetReplayFrameTime() const;
+	// update step and clock start time the log was recorded with
+	double GetReplayStepSeconds() const { return m_updateStepSeconds; }
+	double GetReplayStartTime() const { return m_startTime; }
+
+	bool IsRecording() const { return (NULL != m_pFile); }
+	bool IsReplaying() const { return m_bReplaying; }
+
+	// finish the log or the replay and print what was covered
+	void Stop();
+
+private:
+	struct REPLAY_FRAME
+	{
+		double updateTime;
+		size_t firstEvent;
+		size_t eventCount;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	double m_updateStepSeconds;
+	double m_startTime;
+
+	// recording
+	FILE* m_pFile;
+	std::vector<INPUT_EVENT> m_frameEvents;
+	unsigned int m_recordedFrames;
+	size_t m_recordedEvents;
+
+	// replay
+	bool m_bReplaying;
+	REPLAY_TIMING m_replayTiming;
+	std::vector<REPLAY_FRAME> m_replayFrames;
+	std::vector<INPUT_EVENT> m_replayEvents;
+	// index of the current frame plus one, so zero means not started
+	size_t m_nextReplayFrame;
+	Clock::time_point m_replayWallStart;
+};
@@ -0,0 +1,377 @@
+/////////////////////////////////////////////////////////////////////////////////
+// JobSystem.cpp
+// =============
+// work-stealing job scheduler shared by every parallel part of the program
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	// how long a thread waiting for a job sleeps before it looks for work again
+	const std::chrono::microseconds g_WaitRetryInterval(500);
+
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JobSystem::JOB_HANDLE> jobs;
+	};
+
+	// one queue per worker, then the shared queue for threads outside the pool
+	std::vector<std::unique_ptr<JOB_QUEUE>> g_Queues;
+	std::vector<std::thread> g_Workers;
+	// jobs in any queue; workers sleep while it is zero
+	std::atomic<int> g_QueuedJobs(0);
+	std::atomic<int> g_SleepingWorkers(0);
+	std::mutex g_SleepMutex;
+	std::condition_variable g_WorkAvailable;
+	bool g_bStopping = false;
+
+	// queue of the calling thread, -1 outside the pool
+	thread_local int t_WorkerIndex = -1;
+
+	// joins the workers when the program exits without calling Stop(),
+	// since destroying a running std::thread ends the program
+	struct JOB_SYSTEM_GUARD
+	{
+		~JOB_SYSTEM_GUARD() { JobSystem::Stop(); }
+	};
+	JOB_SYSTEM_GUARD g_JobSystemGuard;
+
+	void RunJob(const JobSystem::JOB_HANDLE& job);
+
+	/***********************************************************
+	 *  EnqueueJob()
+	 *
+	 *  Puts a job whose dependencies have all finished on the
+	 *  calling worker's own deque, or on the shared queue, and
+	 *  wakes a worker if any are asleep.
+	 ***********************************************************/
+	void EnqueueJob(const JobSystem::JOB_HANDLE& job)
+	{
+		if (g_Workers.empty())
+		{
+			RunJob(job);
+			return;
+		}
+
+		int queueIndex = (t_WorkerIndex >= 0) ? t_WorkerIndex : (int)g_Workers.size();
+		{
+			std::lock_guard<std::mutex> lock(g_Queues[queueIndex]->mutex);
+			g_Queues[queueIndex]->jobs.push_back(job);
+		}
+		g_QueuedJobs.fetch_add(1);
+
+		// a worker counts itself as sleeping before it checks the queued count,
+		// so either it sees this job or this sees it sleeping
+		if (g_SleepingWorkers.load() > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(g_SleepMutex);
+			}
+			g_WorkAvailable.notify_one();
+		}
+	}
+
+	/***********************************************************
+	 *  TakeJob()
+	 *
+	 *  Takes the newest job of the calling worker's own deque,
+	 *  or else the oldest job of the shared queue or of another
+	 *  worker's deque.
+	 ***********************************************************/
+	bool TakeJob(JobSystem::JOB_HANDLE& job)
+	{
+		int queueCount = (int)g_Queues.size();
+		if (queueCount == 0)
+		{
+			return false;
+		}
+
+		if (t_WorkerIndex >= 0)
+		{
+			JOB_QUEUE& ownQueue = *g_Queues[t_WorkerIndex];
+			std::lock_guard<std::mutex> lock(ownQueue.mutex);
+			if (ownQueue.jobs.empty() == false)
+			{
+				job = ownQueue.jobs.back();
+				ownQueue.jobs.pop_back();
+				g_QueuedJobs.fetch_sub(1);
+				return true;
+			}
+		}
+
+		// start with the shared queue, then steal round the other workers
+		int firstQueue = queueCount - 1;
+		for (int i = 0; i < queueCount; i++)
+		{
+			int queueIndex = (firstQueue + i) % queueCount;
+			if (queueIndex == t_WorkerIndex)
+			{
+				continue;
+			}
+
+			JOB_QUEUE& queue = *g_Queues[queueIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.jobs.empty() == false)
+			{
+				job = queue.jobs.front();
+				queue.jobs.pop_front();
+				g_QueuedJobs.fetch_sub(1);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/***********************************************************
+	 *  RunJob()
+	 *
+	 *  Runs a job, marks it finished, and queues each job that
+	 *  was only waiting for this one.
+	 ***********************************************************/
+	void RunJob(const JobSystem::JOB_HANDLE& job)
+	{
+		job->work();
+		// let go of anything the work captured
+		job->work = nullptr;
+
+		std::vector<JobSystem::JOB_HANDLE> continuations;
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->bFinished.store(true, std::memory_order_release);
+			continuations.swap(job->continuations);
+		}
+		job->finished.notify_all();
+
+		for (size_t i = 0; i < continuations.size(); i++)
+		{
+			if (continuations[i]->unfinishedDependencies.fetch_sub(1) == 1)
+			{
+				EnqueueJob(continuations[i]);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  WorkerLoop()
+	 *
+	 *  Runs jobs until the system is stopped and every queue is
+	 *  empty, sleeping while there is nothing to take.
+	 ***********************************************************/
+	void WorkerLoop(int workerIndex)
+	{
+		t_WorkerIndex = workerIndex;
+
+		char threadName[32];
+		snprintf(threadName, sizeof(threadName), "Job worker %d", workerIndex);
+		Profiler::SetThreadName(threadName);
+
+		for (;;)
+		{
+			JobSystem::JOB_HANDLE job;
+			if (TakeJob(job))
+			{
+				RunJob(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(g_SleepMutex);
+			g_SleepingWorkers.fetch_add(1);
+			g_WorkAvailable.wait(lock, [] { return g_bStopping || (g_QueuedJobs.load() > 0); });
+			g_SleepingWorkers.fetch_sub(1);
+			if (g_bStopping && (g_QueuedJobs.load() == 0))
+			{
+				return;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  Start()
+ ***********************************************************/
+void JobSystem::Start(int workerCount)
+{
+	if (g_Workers.empty() == false)
+	{
+		return;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	g_Queues.clear();
+	for (int i = 0; i <= workerCount; i++)
+	{
+		g_Queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+	}
+
+	g_bStopping = false;
+	for (int i = 0; i < workerCount; i++)
+	{
+		g_Workers.push_back(std::thread(WorkerLoop, i));
+	}
+
+	std::cout << "INFO: Job system using " << workerCount << " worker thread" << ((workerCount == 1) ? "" : "s") << std::endl;
+}
+
+/***********************************************************
+ *  Stop()
+ ***********************************************************/
+void JobSystem::Stop()
+{
+	if (g_Workers.empty())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(g_SleepMutex);
+		g_bStopping = true;
+	}
+	g_WorkAvailable.notify_all();
+
+	for (size_t i = 0; i < g_Workers.size(); i++)
+	{
+		g_Workers[i].join();
+	}
+	g_Workers.clear();
+	g_Queues.clear();
+}
+
+/***********************************************************
+ *  GetWorkerCount()
+ ***********************************************************/
+int JobSystem::GetWorkerCount()
+{
+	return (int)g_Workers.size();
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for creating a job and queueing it as
+ *  soon as its dependencies allow. Each unfinished dependency
+ *  keeps the job in its continuation list, and the last one
+ *  to finish queues it.
+ ***********************************************************/
+JobSystem::JOB_HANDLE JobSystem::Submit(
+	const std::function<void()>& work,
+	const JOB_HANDLE* pDependencies,
+	int dependencyCount)
+{
+	JOB_HANDLE job = std::make_shared<JOB>();
+	job->work = work;
+	job->bFinished.store(false);
+	// held until every dependency is registered, so none can queue the job early
+	job->unfinishedDependencies.store(1);
+
+	for (int i = 0; i < dependencyCount; i++)
+	{
+		const JOB_HANDLE& dependency = pDependencies[i];
+		if (NULL == dependency)
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (dependency->bFinished.load(std::memory_order_acquire) == false)
+		{
+			job->unfinishedDependencies.fetch_add(1);
+			dependency->continuations.push_back(job);
+		}
+	}
+
+	if (job->unfinishedDependencies.fetch_sub(1) == 1)
+	{
+		EnqueueJob(job);
+	}
+	return job;
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for blocking until a job is finished.
+ *  Queued jobs are run while waiting; with nothing to run the
+ *  thread sleeps, looking again every so often in case the
+ *  job it waits for depends on work queued meanwhile.
+ ***********************************************************/
+void JobSystem::Wait(const JOB_HANDLE& job)
+{
+	if (NULL == job)
+	{
+		return;
+	}
+
+	while (IsFinished(job) == false)
+	{
+		JOB_HANDLE otherJob;
+		if (TakeJob(otherJob))
+		{
+			RunJob(otherJob);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->finished.wait_for(lock, g_WaitRetryInterval, [&job] { return IsFinished(job); });
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for spreading a set of tasks over the
+ *  pool. Helper jobs and the calling thread all take indices
+ *  from one counter; a helper that starts after the tasks
+ *  have run out simply returns.
+ ***********************************************************/
+void JobSystem::ParallelFor(int taskCount, const std::function<void(int)>& task, int maxThreads)
+{
+	if (taskCount <= 0)
+	{
+		return;
+	}
+
+	int helperCount = std::min(GetWorkerCount(), taskCount - 1);
+	if ((maxThreads > 0) && (helperCount > maxThreads - 1))
+	{
+		helperCount = maxThreads - 1;
+	}
+
+	std::atomic<int> nextTask(0);
+	auto runTasks = [&nextTask, taskCount, &task]()
+		{
+			int taskIndex;
+			while ((taskIndex = nextTask.fetch_add(1)) < taskCount)
+			{
+				task(taskIndex);
+			}
+		};
+
+	std::vector<JOB_HANDLE> helpers;
+	helpers.reserve(std::max(helperCount, 0));
+	for (int i = 0; i < helperCount; i++)
+	{
+		helpers.push_back(Submit(runTasks));
+	}
+
+	runTasks();
+
+	for (size_t i = 0; i < helpers.size(); i++)
+	{
+		Wait(helpers[i]);
+	}
+}
@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////////
+// JobSystem.h
+// ===========
+// work-stealing job scheduler shared by every parallel part of the program
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  One pool of worker threads runs the jobs of the whole
+ *  program, instead of each feature starting threads of its
+ *  own. Every worker has its own deque: it pushes and pops
+ *  its newest jobs at the back, where their data is still in
+ *  cache, and an idle worker steals the oldest job from the
+ *  front of another's deque. Jobs submitted from threads
+ *  outside the pool go to a shared queue the workers also
+ *  take from. Each deque has its own lock, held only for the
+ *  push or pop, so workers rarely contend.
+ *
+ *  A job can wait on other jobs; it is only queued once all
+ *  of them have finished. A thread waiting for a job runs
+ *  queued jobs in the meantime, so jobs may wait for jobs
+ *  they start without tying up a worker.
+ *
+ *  Without Start(), or with no workers, jobs run at once on
+ *  the submitting thread.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	struct JOB
+	{
+		std::function<void()> work;
+		// dependencies not yet finished, plus one while the job is being submitted
+		std::atomic<int> unfinishedDependencies;
+		std::atomic<bool> bFinished;
+		// guards the continuations and the wake-up of threads waiting for the job
+		std::mutex mutex;
+		std::condition_variable finished;
+		// jobs waiting for this one
+		std::vector<std::shared_ptr<JOB>> continuations;
+	};
+	typedef std::shared_ptr<JOB> JOB_HANDLE;
+
+	// start the workers; workerCount 0 uses one per core less one for the main thread
+	static void Start(int workerCount);
+	// run the jobs already queued, then stop and join the workers
+	static void Stop();
+	static int GetWorkerCount();
+
+	// queue work to run once every job in pDependencies has finished
+	static JOB_HANDLE Submit(
+		const std::function<void()>& work,
+		const JOB_HANDLE* pDependencies = NULL,
+		int dependencyCount = 0);
+	// return once the job has finished, running other jobs meanwhile
+	static void Wait(const JOB_HANDLE& job);
+	static bool IsFinished(const JOB_HANDLE& job) { return job->bFinished.load(std::memory_order_acquire); }
+
+	// run task(i) for i in [0, taskCount) and return when all are done; the
+	// calling thread and up to maxThreads - 1 workers take the next index from
+	// one counter, so fast threads pick up the slack of slow ones. maxThreads
+	// 0 allows every worker.
+	static void ParallelFor(int taskCount, const std::function<void(int)>& task, int maxThreads = 0);
+};
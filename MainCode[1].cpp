@@ -1,182 +1,1637 @@
-/////////////////////////////////////////////////////////////////////////////////
-// MainCode.cpp
-// Entry point for 7-1 Final Project
-/////////////////////////////////////////////////////////////////////////////////
-
-#include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
-
-#include <GL/glew.h>        // GLEW library
-#include "GLFW/glfw3.h"     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-
-// Namespace for declaring global variables
-namespace
-{
-	// Macro for window title
-	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones";
-
-	// Main GLFW window
-	GLFWwindow* g_Window = nullptr;
-
-	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
-	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
-	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
-}
-
-// Function declarations - all functions that are called manually
-// need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
-
-
-/***********************************************************
- *  main(int, char*)
- *
- *  This function gets called after the application has been
- *  launched.
- ***********************************************************/
-int main(int argc, char* argv[])
-{
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
-
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
-	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
-	}
-
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
-	}
-	if (NULL != g_ViewManager)
-	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
-	}
-	if (NULL != g_ShaderManager)
-	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
-	}
-
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS);
-}
-
-/***********************************************************
- *	InitializeGLFW()
- *
- *  This function is used to initialize the GLFW library.
- ***********************************************************/
-bool InitializeGLFW()
-{
-	// GLFW: initialize and configure library
-	// --------------------------------------
-	glfwInit();
-
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-	// GLFW: end -------------------------------
-
-	return(true);
-}
-
-/***********************************************************
- *	InitializeGLEW()
- *
- *  This function is used to initialize the GLEW library.
- ***********************************************************/
-bool InitializeGLEW()
-{
-	// GLEW: initialize
-	// -----------------------------------------
-	GLenum GLEWInitResult = GLEW_OK;
-
-	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
-	if (GLEW_OK != GLEWInitResult)
-	{
-		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-		return false;
-	}
-	// GLEW: end -------------------------------
-
-	// Displays a successful OpenGL initialization message
-	std::cout << "INFO: OpenGL Successfully Initialized\n";
-	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
-
-	return(true);
+/////////////////////////////////////////////////////////////////////////////////
+// MainCode.cpp
+// Entry point for 7-1 Final Project
+/////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <cstdio>           // snprintf, sscanf
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShapeMeshes.h"
+#include "ShaderManager.h"
+#include "GpuTimer.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "PerfOverlay.h"
+#include "StartupReport.h"
+#include "FrameCache.h"
+#include "FramePacer.h"
+#include "FixedTimestep.h"
+#include "InputRecorder.h"
+#include "BatchRenderer.h"
+#include "ImageWriter.h"
+#include "FrameCapture.h"
+#include "TiledRenderer.h"
+#include "RenderServer.h"
+#include "SoftwareRasterizer.h"
+#include "GoldenImageCheck.h"
+#include "Microbenchmark.h"
+#include "RenderThread.h"
+#include "JobSystem.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// Macro for window title
+	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones";
+
+	// Main GLFW window
+	GLFWwindow* g_Window = nullptr;
+
+	// scene manager object for managing the 3D scene prepare and render
+	SceneManager* g_SceneManager = nullptr;
+	// shader manager object for dynamic interaction with the shader code
+	ShaderManager* g_ShaderManager = nullptr;
+	// view manager object for managing the 3D view setup and projection to 2D
+	ViewManager* g_ViewManager = nullptr;
+	// GPU timer for the clear and scene passes of each frame
+	GpuTimer* g_GpuTimer = nullptr;
+	// performance HUD drawn over the scene when toggled on
+	PerfOverlay* g_PerfOverlay = nullptr;
+
+	// number of frames to time before printing a report and exiting, 0 to run normally
+	int g_BenchmarkFrames = 0;
+	// frames rendered before benchmark timing starts
+	const int g_BenchmarkWarmupFrames = 30;
+	// show the latest GPU pass times in the window title
+	bool g_bShowGpuTimes = false;
+	// seconds between window title updates
+	const double g_TitleUpdateInterval = 0.5;
+	// file the CPU profiler events are written to at exit, empty for none
+	std::string g_TraceFilename;
+	// decode the scene textures on worker threads while the window and context are created
+	bool g_bFastStart = false;
+	// only redraw when the view, scene or lights change, sleeping in between
+	bool g_bOnDemand = false;
+	// longest time to sleep waiting for events while idle in on-demand mode
+	const double g_IdleWaitSeconds = 0.5;
+	// last rendered frame, presented again when the idle window needs refreshing
+	FrameCache* g_FrameCache = nullptr;
+	// swap interval and frame rate limiter
+	FramePacer* g_FramePacer = nullptr;
+	// pacing mode from the command line; benchmarks run uncapped unless one was given
+	FramePacer::PACING_MODE g_PacingMode = FramePacer::PACING_VSYNC;
+	bool g_bPacingModeSet = false;
+	// frame rate held by the limiter in the limited pacing mode
+	double g_TargetFramesPerSecond = 60.0;
+	// fixed update steps for camera movement, independent of the frame rate
+	FixedTimestep* g_UpdateTimestep = nullptr;
+	double g_UpdatesPerSecond = 120.0;
+	// most update steps run in one frame; a longer stall drops the extra time
+	const int g_MaxUpdateStepsPerFrame = 8;
+	// input log written with --record or played back with --replay
+	InputRecorder* g_InputRecorder = nullptr;
+	std::string g_RecordFilename;
+	std::string g_ReplayFilename;
+	InputRecorder::REPLAY_TIMING g_ReplayTiming = InputRecorder::REPLAY_ORIGINAL;
+	// views drawn each frame: the interactive camera alone, or with fixed cameras
+	ViewManager::VIEW_LAYOUT g_ViewLayout = ViewManager::VIEW_LAYOUT_SINGLE;
+	// camera pose list rendered to images in a hidden window, empty for the interactive app
+	std::string g_BatchPosesFilename;
+	std::string g_BatchOutputFolder = ".";
+	int g_BatchTileSize = 256;
+	IMAGE_FORMAT g_ImageFormat = IMAGE_FORMAT_PNG;
+	// single image rendered in tiles at any size, empty for the interactive app
+	std::string g_HiresFilename;
+	int g_HiresWidth = 16384;
+	int g_HiresHeight = 16384;
+	// pose fields for the large image, empty to use the start camera
+	std::string g_HiresCamera;
+	// socket the render server listens on, empty for the interactive app
+	RenderServer* g_RenderServer = nullptr;
+	std::string g_ServerSocketPath;
+	// worker processes, each with its own GL context, 0 for one per two cores
+	int g_ServerWorkers = 0;
+	// every rendered frame is read back and written to this folder, empty for none
+	FrameCapture* g_FrameCapture = nullptr;
+	std::string g_CaptureFolder;
+	// most captured frames encoded at once, 0 for one per job worker
+	int g_CaptureThreads = 0;
+	// batch and server images drawn on the CPU instead of through OpenGL
+	SoftwareRasterizer* g_SoftwareRasterizer = nullptr;
+	bool g_bSoftwareRender = false;
+	// rasterizer threads, 0 for every job worker and the calling thread
+	int g_SoftwareThreads = 0;
+	// job system worker threads, 0 for one per core less one, shared between server workers
+	int g_JobThreads = 0;
+	// camera pose list checked against reference images, empty for the interactive app
+	std::string g_GoldenPosesFilename;
+	std::string g_GoldenFolder = "golden";
+	// record the reference images and timings again instead of checking them
+	bool g_bGoldenUpdate = false;
+	int g_GoldenTolerance = 8;
+	// time the scene's CPU hot paths one function at a time instead of running the app
+	bool g_bMicrobenchmark = false;
+	// only the microbenchmarks whose name contains this text, empty for all
+	std::string g_MicrobenchmarkFilter;
+	// objects in a generated stress scene used instead of the desk scene, 0 for the desk
+	int g_StressObjectCount = 0;
+	unsigned int g_StressSeed = 1;
+	// time stress scenes of growing size up to the stress object count, then exit
+	bool g_bStressSweep = false;
+	// frames per object count when --benchmark does not give them, and untimed frames before them
+	const int g_StressSweepDefaultFrames = 30;
+	const int g_StressSweepWarmupFrames = 5;
+	// draw on a render thread fed with snapshots built by the main thread
+	bool g_bRenderThread = false;
+
+	// GPU time of one pass summed over the benchmark frames
+	struct PASS_TOTAL
+	{
+		std::string name;
+		double totalMilliseconds = 0.0;
+		double maxMilliseconds = 0.0;
+		int frameCount = 0;
+	};
+
+	// frame counting and benchmark results, kept by whichever thread presents the frames
+	struct FRAME_LOOP_STATE
+	{
+		int frameNumber = 0;
+		double lastFrameTime = 0.0;
+		std::vector<double> benchmarkFrameTimes;
+		std::vector<PASS_TOTAL> benchmarkPassTotals;
+	};
+}
+
+// Function declarations - all functions that are called manually
+// need to be pre-declared at the beginning of the source code.
+bool InitializeGLFW();
+bool InitializeGLEW();
+bool ParseCommandLine(int argc, char* argv[]);
+void AccumulatePassTimes(std::vector<PASS_TOTAL>& passTotals);
+void PrintBenchmarkReport(const std::vector<double>& frameTimes, const std::vector<PASS_TOTAL>& passTotals);
+void ShowGpuTimesInTitle();
+void PrintFrameStatsJSON(int frameNumber, double frameMilliseconds);
+void RenderFrame(const RENDER_SNAPSHOT* pSnapshot);
+void PresentFrame(int frameNumber);
+void CountFrame(FRAME_LOOP_STATE& loopState);
+void PickObjectAtCrosshair();
+void RunRenderThreadLoop(FRAME_LOOP_STATE& loopState);
+int RunFrameLoop();
+void RunStressSweep(int maxObjectCount, int frameCount);
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the application has been
+ *  launched.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	// read the benchmark and display options
+	if (ParseCommandLine(argc, argv) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// record startup and frame phases when a trace file was requested
+	if (g_TraceFilename.empty() == false)
+	{
+		Profiler::SetEnabled(true);
+		Profiler::SetThreadName("main");
+	}
+	StartupReport::Begin();
+
+	// the render server forks its workers before GLFW is set up, since
+	// a GL context cannot cross fork(); only the workers go on from here
+	if (g_ServerSocketPath.empty() == false)
+	{
+		g_RenderServer = new RenderServer();
+		if (g_RenderServer->Listen(g_ServerSocketPath.c_str()) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+
+		if (g_ServerWorkers <= 0)
+		{
+			g_ServerWorkers = std::max(1, (int)std::thread::hardware_concurrency() / 2);
+		}
+		if (g_RenderServer->ForkWorkers(g_ServerWorkers) == false)
+		{
+			delete g_RenderServer;
+			g_RenderServer = NULL;
+			return(EXIT_SUCCESS);
+		}
+
+		if (g_JobThreads <= 0)
+		{
+			g_JobThreads = std::max(1, (int)std::thread::hardware_concurrency() / g_ServerWorkers - 1);
+		}
+	}
+
+	// threads do not survive fork(), so the job workers start after it
+	JobSystem::Start(g_JobThreads);
+
+	// if GLFW fails initialization, then terminate the application
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// try to create a new shader manager object
+	g_ShaderManager = new ShaderManager();
+	// try to create a new view manager object
+	g_ViewManager = new ViewManager(
+		g_ShaderManager);
+	g_ViewManager->SetViewLayout(g_ViewLayout);
+
+	// in fast-start mode the scene manager is created early so the texture
+	// decodes run alongside window creation, GLEW and shader compilation
+	if (g_bFastStart)
+	{
+		g_SceneManager = new SceneManager(g_ShaderManager);
+		g_SceneManager->BeginTextureDecodes();
+	}
+
+	// batch, tiled, server and golden image rendering only draw offscreen, and the
+	// microbenchmarks draw nothing, so the window stays hidden and no frames run
+	bool bOfflineMode = (g_BatchPosesFilename.empty() == false) ||
+		(g_HiresFilename.empty() == false) ||
+		(g_ServerSocketPath.empty() == false) ||
+		(g_GoldenPosesFilename.empty() == false) ||
+		g_bMicrobenchmark;
+	if (bOfflineMode)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	}
+
+	// try to create the main display window
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+
+	// if GLEW fails initialization, then terminate the application
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// load the shader code from the external GLSL files
+	{
+		STARTUP_PHASE("LoadShaders");
+		g_ShaderManager->LoadShaders(
+			"../../Utilities/shaders/vertexShader.glsl",
+			"../../Utilities/shaders/fragmentShader.glsl");
+		g_ShaderManager->use();
+	}
+
+	// try to create a new scene manager object and prepare the 3D scene
+	if (NULL == g_SceneManager)
+	{
+		g_SceneManager = new SceneManager(g_ShaderManager);
+	}
+	if ((g_StressObjectCount > 0) && (g_bStressSweep == false))
+	{
+		g_SceneManager->PrepareStressScene(g_StressObjectCount, g_StressSeed);
+	}
+	else
+	{
+		g_SceneManager->PrepareScene();
+	}
+
+	// the software rasterizer keeps its own copy of the textures just loaded
+	if (g_bSoftwareRender)
+	{
+		g_SoftwareRasterizer = new SoftwareRasterizer();
+		g_SoftwareRasterizer->Start(g_SoftwareThreads);
+		g_SoftwareRasterizer->LoadTextures(g_SceneManager);
+	}
+
+	// render the batch of camera poses with the prepared scene, then exit
+	int exitCode = EXIT_SUCCESS;
+	if (g_BatchPosesFilename.empty() == false)
+	{
+		BatchRenderer batchRenderer;
+		batchRenderer.SetSoftwareRasterizer(g_SoftwareRasterizer);
+		if ((batchRenderer.LoadPoses(g_BatchPosesFilename.c_str()) == false) ||
+			(batchRenderer.RenderAll(g_SceneManager, g_BatchTileSize, g_BatchOutputFolder, g_ImageFormat) == false))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	// compare the views of the pose list with the reference images and timings, then exit
+	if (g_GoldenPosesFilename.empty() == false)
+	{
+		BatchRenderer goldenPoses;
+		GoldenImageCheck goldenImageCheck;
+		goldenImageCheck.SetTolerance(g_GoldenTolerance);
+		goldenImageCheck.SetSoftwareRasterizer(g_SoftwareRasterizer);
+		if ((goldenPoses.LoadPoses(g_GoldenPosesFilename.c_str()) == false) ||
+			(goldenImageCheck.Run(g_SceneManager, goldenPoses.GetPoses(), g_BatchTileSize, g_GoldenFolder, g_bGoldenUpdate) == false))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	// time the scene's hot paths against the prepared scene, then exit
+	if (g_bMicrobenchmark)
+	{
+		Microbenchmark microbenchmark;
+		microbenchmark.SetFilter(g_MicrobenchmarkFilter);
+		if (microbenchmark.Run(g_SceneManager) == false)
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	// a render worker keeps the prepared scene and takes jobs until it is stopped
+	if (NULL != g_RenderServer)
+	{
+		g_RenderServer->SetSoftwareRasterizer(g_SoftwareRasterizer);
+		g_RenderServer->ServeJobs(g_SceneManager);
+	}
+
+	// render one image larger than the framebuffer allows, tile by tile, then exit
+	if (g_HiresFilename.empty() == false)
+	{
+		CAMERA_POSE hiresPose = g_ViewManager->GetCameraPose();
+		if ((g_HiresCamera.empty() == false) && (BatchRenderer::ParsePose(g_HiresCamera, hiresPose) == false))
+		{
+			std::cout << "--hires-camera expects \"x y z yaw pitch [zoom] [ortho]\"" << std::endl;
+			exitCode = EXIT_FAILURE;
+		}
+		else
+		{
+			TiledRenderer tiledRenderer;
+			if (tiledRenderer.RenderImage(g_SceneManager, hiresPose, g_HiresWidth, g_HiresHeight, g_HiresFilename.c_str()) == false)
+			{
+				exitCode = EXIT_FAILURE;
+			}
+		}
+	}
+
+	// the offline modes are done; only the window runs the frame loop
+	if (bOfflineMode == false)
+	{
+		exitCode = RunFrameLoop();
+	}
+
+	// write the recorded profiler events for chrome://tracing or Perfetto
+	if (g_TraceFilename.empty() == false)
+	{
+		Profiler::WriteChromeTrace(g_TraceFilename.c_str());
+	}
+
+	// clear the allocated manager objects from memory
+	if (NULL != g_RenderServer)
+	{
+		delete g_RenderServer;
+		g_RenderServer = NULL;
+	}
+	if (NULL != g_FrameCapture)
+	{
+		delete g_FrameCapture;
+		g_FrameCapture = NULL;
+	}
+	if (NULL != g_SoftwareRasterizer)
+	{
+		delete g_SoftwareRasterizer;
+		g_SoftwareRasterizer = NULL;
+	}
+	if (NULL != g_InputRecorder)
+	{
+		delete g_InputRecorder;
+		g_InputRecorder = NULL;
+	}
+	if (NULL != g_UpdateTimestep)
+	{
+		delete g_UpdateTimestep;
+		g_UpdateTimestep = NULL;
+	}
+	if (NULL != g_FramePacer)
+	{
+		delete g_FramePacer;
+		g_FramePacer = NULL;
+	}
+	if (NULL != g_FrameCache)
+	{
+		delete g_FrameCache;
+		g_FrameCache = NULL;
+	}
+	if (NULL != g_PerfOverlay)
+	{
+		delete g_PerfOverlay;
+		g_PerfOverlay = NULL;
+	}
+	if (NULL != g_GpuTimer)
+	{
+		delete g_GpuTimer;
+		g_GpuTimer = NULL;
+	}
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+
+	JobSystem::Stop();
+
+	// Terminates the program successfully
+	exit(exitCode);
+}
+
+/***********************************************************
+ *	RunFrameLoop()
+ *
+ *  This function is used to set up the state only the window
+ *  needs, like the GPU timer, HUD, frame pacing, input log and
+ *  frame capture, and to draw frames until the window is
+ *  closed. The offline modes never get here. The managers
+ *  created here are deleted by main() on every return path.
+ ***********************************************************/
+int RunFrameLoop()
+{
+	// create the GPU pass timer and hand it to the scene
+	g_GpuTimer = new GpuTimer();
+	if (g_GpuTimer->Initialize() == false)
+	{
+		std::cout << "Could not create the GPU timer queries" << std::endl;
+	}
+	g_SceneManager->SetGpuTimer(g_GpuTimer);
+
+	// create the performance HUD, shown with the H key
+	g_PerfOverlay = new PerfOverlay();
+	if (g_PerfOverlay->Initialize() == false)
+	{
+		std::cout << "Could not create the performance overlay" << std::endl;
+	}
+
+	// keep the startup uploads out of the first frame's counters
+	RenderStats::EndFrame();
+
+	g_FrameCache = new FrameCache();
+	bool bOverlayWasVisible = false;
+
+	// set the swap interval explicitly rather than relying on the driver default,
+	// and let a benchmark run as fast as the GPU allows
+	g_FramePacer = new FramePacer();
+	if (((g_BenchmarkFrames > 0) || g_bStressSweep) && (g_bPacingModeSet == false))
+	{
+		g_PacingMode = FramePacer::PACING_UNCAPPED;
+	}
+	g_FramePacer->SetMode(g_PacingMode, g_TargetFramesPerSecond);
+
+	// chart frame time against the object count of generated scenes, then exit
+	if (g_bStressSweep)
+	{
+		int maxObjectCount = (g_StressObjectCount > 0) ? g_StressObjectCount : SceneManager::MAX_STRESS_OBJECTS;
+		int frameCount = (g_BenchmarkFrames > 0) ? g_BenchmarkFrames : g_StressSweepDefaultFrames;
+		RunStressSweep(maxObjectCount, frameCount);
+		return(EXIT_SUCCESS);
+	}
+
+	// a replay runs the update clock from the recorded start time and step
+	g_InputRecorder = new InputRecorder();
+	g_ViewManager->SetInputRecorder(g_InputRecorder);
+	if (g_ReplayFilename.empty() == false)
+	{
+		if (g_InputRecorder->StartReplay(g_ReplayFilename.c_str(), g_ReplayTiming) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		g_UpdateTimestep = new FixedTimestep(g_InputRecorder->GetReplayStepSeconds(), g_MaxUpdateStepsPerFrame);
+		g_UpdateTimestep->Reset(g_InputRecorder->GetReplayStartTime());
+	}
+	else
+	{
+		double startTime = glfwGetTime();
+		g_UpdateTimestep = new FixedTimestep(1.0 / g_UpdatesPerSecond, g_MaxUpdateStepsPerFrame);
+		g_UpdateTimestep->Reset(startTime);
+
+		if (g_RecordFilename.empty() == false)
+		{
+			g_InputRecorder->StartRecording(g_RecordFilename.c_str(), g_UpdateTimestep->GetStepSeconds(), startTime);
+		}
+	}
+
+	// read back and encode every frame in the background
+	g_FrameCapture = new FrameCapture();
+	if (g_CaptureFolder.empty() == false)
+	{
+		g_FrameCapture->Start(g_CaptureFolder, g_ImageFormat, g_CaptureThreads);
+	}
+
+	FRAME_LOOP_STATE loopState;
+	loopState.lastFrameTime = glfwGetTime();
+
+	// with a render thread, the main thread only handles input and builds
+	// the snapshots until the application is closed
+	if (g_bRenderThread)
+	{
+		RunRenderThreadLoop(loopState);
+	}
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		PROFILE_SCOPE("Frame");
+
+		// a replay takes the clock time and input of each frame from the log
+		double updateTime = glfwGetTime();
+		if (g_InputRecorder->IsReplaying())
+		{
+			if (g_InputRecorder->BeginReplayFrame() == false)
+			{
+				glfwSetWindowShouldClose(g_Window, GL_TRUE);
+				break;
+			}
+			updateTime = g_InputRecorder->GetReplayFrameTime();
+		}
+
+		// read the input for this frame and run the fixed update steps it covers
+		g_ViewManager->ProcessInputEvents();
+		{
+			PROFILE_SCOPE("FixedUpdate");
+			int updateSteps = g_UpdateTimestep->Advance(updateTime);
+			for (int step = 0; step < updateSteps; step++)
+			{
+				g_ViewManager->FixedUpdate((float)g_UpdateTimestep->GetStepSeconds());
+			}
+		}
+		g_InputRecorder->RecordFrame(updateTime);
+
+		// blend the camera between the last two steps and find out whether the view moved
+		g_ViewManager->UpdateView(g_UpdateTimestep->GetInterpolation());
+		PickObjectAtCrosshair();
+
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		glfwGetFramebufferSize(g_Window, &framebufferWidth, &framebufferHeight);
+
+		// the HUD redraws every frame, and once more when it is hidden;
+		// recorded and replayed sessions draw every frame of the log
+		bool bOverlayVisible = g_ViewManager->IsPerfOverlayVisible();
+		bool bRedraw = (g_bOnDemand == false) ||
+			(loopState.frameNumber == 0) ||
+			(g_BenchmarkFrames > 0) ||
+			g_InputRecorder->IsRecording() ||
+			g_InputRecorder->IsReplaying() ||
+			g_FrameCapture->IsCapturing() ||
+			g_ViewManager->HasViewChanged() ||
+			g_SceneManager->NeedsRedraw() ||
+			bOverlayVisible ||
+			(bOverlayVisible != bOverlayWasVisible);
+		bOverlayWasVisible = bOverlayVisible;
+
+		if (bRedraw == false)
+		{
+			// show the cached frame again if the window was exposed or resized,
+			// and render a new one if the cache no longer matches the window
+			if (g_ViewManager->ConsumeRefreshRequest())
+			{
+				if (g_FrameCache->Present(framebufferWidth, framebufferHeight))
+				{
+					glfwSwapBuffers(g_Window);
+				}
+				else
+				{
+					bRedraw = true;
+				}
+			}
+		}
+
+		if (bRedraw == false)
+		{
+			// nothing changed, so sleep until input arrives instead of spinning
+			{
+				PROFILE_SCOPE("WaitEvents");
+				glfwWaitEventsTimeout(g_IdleWaitSeconds);
+			}
+
+			// the time spent asleep is neither movement nor frame time
+			g_UpdateTimestep->SkipTo(glfwGetTime());
+			g_FramePacer->ResetTiming();
+			loopState.lastFrameTime = glfwGetTime();
+			continue;
+		}
+
+		RenderFrame(NULL);
+
+		// start the readback of this frame; it is collected a few frames later
+		g_FrameCapture->CaptureFrame(framebufferWidth, framebufferHeight);
+
+		// keep a copy of the frame for refreshing the window while idle
+		if (g_bOnDemand)
+		{
+			g_FrameCache->Capture(framebufferWidth, framebufferHeight);
+		}
+
+		PresentFrame(loopState.frameNumber);
+
+		// query the latest GLFW events
+		{
+			PROFILE_SCOPE("PollEvents");
+			glfwPollEvents();
+		}
+
+		CountFrame(loopState);
+
+		if (g_bShowGpuTimes)
+		{
+			ShowGpuTimesInTitle();
+		}
+	}
+
+	// a replay can end before the benchmark frame count is reached
+	if ((g_BenchmarkFrames > 0) && (loopState.frameNumber < g_BenchmarkWarmupFrames + g_BenchmarkFrames))
+	{
+		PrintBenchmarkReport(loopState.benchmarkFrameTimes, loopState.benchmarkPassTotals);
+	}
+
+	// the frame time spread of the pacing mode over the run
+	g_FramePacer->PrintStats();
+
+	// close the input log
+	g_InputRecorder->Stop();
+
+	// write out the frames still being read back and encoded
+	g_FrameCapture->Finish();
+
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *	RunStressSweep()
+ *
+ *  This function is used to find the object counts where the
+ *  frame time stops growing linearly. Stress scenes of 10,
+ *  30, 100, 300, ... objects, up to the largest count, are
+ *  each drawn from the start camera for a few untimed frames
+ *  and then the timed ones, and one line is printed per count.
+ *  The meshes and textures are loaded once, into a scene
+ *  manager of its own, and only the object list is replaced
+ *  for each count, so the setup time and memory of one count
+ *  do not carry the mesh loads of the ones before it.
+ ***********************************************************/
+void RunStressSweep(int maxObjectCount, int frameCount)
+{
+	// the scene loads below would otherwise pile up as startup phases
+	StartupReport::StopRecording();
+
+	char line[256];
+	std::cout << "STRESS SWEEP: " << frameCount << " frames per object count, seed " << g_StressSeed << std::endl;
+	snprintf(line, sizeof(line), "  %8s %8s %10s %10s %10s %9s %9s %9s",
+		"objects", "visible", "draws", "triangles", "setup ms", "avg ms", "p50 ms", "p99 ms");
+	std::cout << line << std::endl;
+
+	int objectCount = SceneManager::MIN_STRESS_OBJECTS;
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+	}
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->PrepareStressScene(objectCount, g_StressSeed);
+	g_SceneManager->SetGpuTimer(g_GpuTimer);
+
+	bool bTripleNext = true;
+	while (glfwWindowShouldClose(g_Window) == false)
+	{
+		double setupBeginTime = glfwGetTime();
+		g_SceneManager->ReplaceStressObjects(objectCount, g_StressSeed);
+		double setupMilliseconds = (glfwGetTime() - setupBeginTime) * 1000.0;
+
+		// keep the scene uploads out of the first frame's counters
+		RenderStats::EndFrame();
+
+		std::vector<double> frameTimes;
+		double lastFrameTime = glfwGetTime();
+		for (int frame = 0; frame < g_StressSweepWarmupFrames + frameCount; frame++)
+		{
+			g_ViewManager->UpdateView(1.0f);
+			RenderFrame(NULL);
+			glfwSwapBuffers(g_Window);
+			glfwPollEvents();
+
+			double currentTime = glfwGetTime();
+			if (frame >= g_StressSweepWarmupFrames)
+			{
+				frameTimes.push_back((currentTime - lastFrameTime) * 1000.0);
+			}
+			lastFrameTime = currentTime;
+		}
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		double totalMilliseconds = 0.0;
+		for (size_t i = 0; i < frameTimes.size(); i++)
+		{
+			totalMilliseconds += frameTimes[i];
+		}
+		const RENDER_STATS& stats = RenderStats::GetFrameStats();
+
+		snprintf(line, sizeof(line), "  %8d %8zu %10llu %10llu %10.1f %9.3f %9.3f %9.3f",
+			objectCount,
+			g_SceneManager->GetVisibleObjectCount(),
+			(unsigned long long)stats.drawCalls,
+			(unsigned long long)stats.triangles,
+			setupMilliseconds,
+			totalMilliseconds / frameTimes.size(),
+			frameTimes[frameTimes.size() / 2],
+			frameTimes[(frameTimes.size() - 1) * 99 / 100]);
+		std::cout << line << std::endl;
+
+		if (objectCount >= maxObjectCount)
+		{
+			break;
+		}
+
+		// 10, 30, 100, 300, ... spaces the counts evenly on a log scale
+		objectCount = bTripleNext ? objectCount * 3 : objectCount * 10 / 3;
+		objectCount = std::min(objectCount, maxObjectCount);
+		bTripleNext = !bTripleNext;
+	}
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to draw one frame into the back
+ *  buffer: the clear, the 3D scene and the optional HUD, with
+ *  each pass timed on the GPU. Without a snapshot, the view
+ *  must already have been updated for this frame and the
+ *  scene is culled here; a snapshot from the update thread
+ *  brings its views and draw lists already culled.
+ ***********************************************************/
+void RenderFrame(const RENDER_SNAPSHOT* pSnapshot)
+{
+	g_GpuTimer->BeginFrame();
+
+	// Enable z-depth
+	glEnable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	{
+		PROFILE_SCOPE("Clear");
+		g_GpuTimer->BeginPass("clear");
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		g_GpuTimer->EndPass("clear");
+	}
+
+	g_GpuTimer->BeginPass("scene");
+
+	if (NULL != pSnapshot)
+	{
+		// the update thread culled and sorted every view of the snapshot
+		double sceneBeginTime = glfwGetTime();
+		g_SceneManager->RenderSnapshotViews(
+			&pSnapshot->views[0],
+			&pSnapshot->viewPackets[0],
+			(int)pSnapshot->views.size(),
+			pSnapshot->framebufferWidth,
+			pSnapshot->framebufferHeight);
+		double sceneEndTime = glfwGetTime();
+
+		g_GpuTimer->EndPass("scene");
+
+		g_PerfOverlay->SetCpuPassTime("snapshot", pSnapshot->buildMilliseconds);
+		g_PerfOverlay->SetCpuPassTime("scene", (sceneEndTime - sceneBeginTime) * 1000.0);
+
+		if (pSnapshot->bShowPerfOverlay)
+		{
+			PROFILE_SCOPE("PerfOverlay");
+			g_GpuTimer->BeginPass("overlay");
+
+			g_PerfOverlay->Render(
+				pSnapshot->framebufferWidth,
+				pSnapshot->framebufferHeight,
+				RenderStats::GetFrameStats(),
+				g_GpuTimer);
+
+			g_GpuTimer->EndPass("overlay");
+		}
+
+		g_GpuTimer->EndFrame();
+		RenderStats::EndFrame();
+		return;
+	}
+
+	// convert from 3D object space to 2D view
+	double viewBeginTime = glfwGetTime();
+	g_ViewManager->ApplyViewToShader();
+
+	// cull the scene against the current view
+	g_SceneManager->SetCullingView(
+		g_ViewManager->GetViewFrustum(),
+		g_ViewManager->GetViewProjection());
+
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(g_Window, &framebufferWidth, &framebufferHeight);
+
+	// refresh the 3D scene, drawing every view of a multi-view layout
+	// from one culled and sorted draw list
+	double sceneBeginTime = glfwGetTime();
+	if (g_ViewManager->GetViewCount() > 1)
+	{
+		g_SceneManager->RenderSceneViews(
+			&g_ViewManager->GetSceneView(0),
+			g_ViewManager->GetViewCount(),
+			framebufferWidth,
+			framebufferHeight);
+	}
+	else
+	{
+		g_SceneManager->RenderScene();
+	}
+	double sceneEndTime = glfwGetTime();
+
+	g_GpuTimer->EndPass("scene");
+
+	g_PerfOverlay->SetCpuPassTime("view", (sceneBeginTime - viewBeginTime) * 1000.0);
+	g_PerfOverlay->SetCpuPassTime("scene", (sceneEndTime - sceneBeginTime) * 1000.0);
+
+	// draw the performance HUD over the scene
+	if (g_ViewManager->IsPerfOverlayVisible())
+	{
+		PROFILE_SCOPE("PerfOverlay");
+		g_GpuTimer->BeginPass("overlay");
+
+		g_PerfOverlay->Render(
+			framebufferWidth,
+			framebufferHeight,
+			RenderStats::GetFrameStats(),
+			g_GpuTimer);
+
+		g_GpuTimer->EndPass("overlay");
+	}
+
+	g_GpuTimer->EndFrame();
+	RenderStats::EndFrame();
+}
+
+/***********************************************************
+ *	PresentFrame()
+ *
+ *  This function is used to show the frame just rendered,
+ *  holding it until its deadline first when a frame rate
+ *  limit is set.
+ ***********************************************************/
+void PresentFrame(int frameNumber)
+{
+	// hold the frame until its deadline when a frame rate limit is set
+	{
+		PROFILE_SCOPE("FrameLimiter");
+		g_FramePacer->WaitForFrameDeadline();
+	}
+
+	// Flips the the back buffer with the front buffer every frame.
+	{
+		PROFILE_SCOPE("SwapBuffers");
+		glfwSwapBuffers(g_Window);
+	}
+	g_FramePacer->FramePresented();
+
+	// the first frame has been presented, so startup is over
+	if (frameNumber == 0)
+	{
+		StartupReport::PrintReport();
+	}
+}
+
+/***********************************************************
+ *	CountFrame()
+ *
+ *  This function is used to record the time of the frame just
+ *  presented for the HUD and the benchmark, and to end the
+ *  benchmark once all of its frames are timed.
+ ***********************************************************/
+void CountFrame(FRAME_LOOP_STATE& loopState)
+{
+	double currentTime = glfwGetTime();
+	double frameMilliseconds = (currentTime - loopState.lastFrameTime) * 1000.0;
+	loopState.lastFrameTime = currentTime;
+	loopState.frameNumber++;
+	g_PerfOverlay->AddFrameTime(frameMilliseconds);
+
+	if (g_BenchmarkFrames <= 0)
+	{
+		return;
+	}
+
+	// keep the warmup frames out of the pacing statistics
+	if (loopState.frameNumber == g_BenchmarkWarmupFrames)
+	{
+		g_FramePacer->ResetStats();
+	}
+
+	if (loopState.frameNumber > g_BenchmarkWarmupFrames)
+	{
+		loopState.benchmarkFrameTimes.push_back(frameMilliseconds);
+		PrintFrameStatsJSON(loopState.frameNumber - g_BenchmarkWarmupFrames, frameMilliseconds);
+
+		// each frame is read back a few frames late, so add the ones that came back
+		AccumulatePassTimes(loopState.benchmarkPassTotals);
+	}
+
+	if (loopState.frameNumber >= g_BenchmarkWarmupFrames + g_BenchmarkFrames)
+	{
+		PrintBenchmarkReport(loopState.benchmarkFrameTimes, loopState.benchmarkPassTotals);
+		glfwSetWindowShouldClose(g_Window, GL_TRUE);
+		// wake the main thread if it is waiting for events
+		glfwPostEmptyEvent();
+	}
+}
+
+/***********************************************************
+ *	PickObjectAtCrosshair()
+ *
+ *  This function is used to report the scene object a left
+ *  click picked, along the camera ray through the crosshair.
+ ***********************************************************/
+void PickObjectAtCrosshair()
+{
+	glm::vec3 rayOrigin;
+	glm::vec3 rayDirection;
+	if (false == g_ViewManager->ConsumePickRequest(rayOrigin, rayDirection))
+	{
+		return;
+	}
+
+	int objectIndex = g_SceneManager->PickObject(rayOrigin, rayDirection);
+	if (objectIndex < 0)
+	{
+		std::cout << "INFO: No scene object under the crosshair" << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: Picked scene object " << objectIndex
+			<< " of " << g_SceneManager->GetSceneObjectCount() << std::endl;
+	}
+}
+
+/***********************************************************
+ *	RunRenderThreadLoop()
+ *
+ *  This function is used to run the frame loop split over two
+ *  threads. The main thread keeps the GLFW events, which must
+ *  stay on it, runs the fixed update steps, and culls every
+ *  view into a snapshot of draw packets; the render thread
+ *  draws, captures and presents the newest snapshot. Culling
+ *  the next frame overlaps drawing the last one, and a slow
+ *  swap never holds up the input.
+ *
+ *  One snapshot is built per fixed update step, or as often
+ *  as possible when uncapped, so the update rate also bounds
+ *  the frame rate.
+ ***********************************************************/
+void RunRenderThreadLoop(FRAME_LOOP_STATE& loopState)
+{
+	if (glfwWindowShouldClose(g_Window))
+	{
+		return;
+	}
+
+	RenderThread renderThread;
+	renderThread.Start(g_Window, [&loopState](const RENDER_SNAPSHOT& snapshot)
+		{
+			PROFILE_SCOPE("Frame");
+
+			RenderFrame(&snapshot);
+			g_FrameCapture->CaptureFrame(snapshot.framebufferWidth, snapshot.framebufferHeight);
+			PresentFrame(loopState.frameNumber);
+			CountFrame(loopState);
+		});
+
+	bool bUncapped = (g_FramePacer->GetMode() == FramePacer::PACING_UNCAPPED);
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		PROFILE_SCOPE("Update");
+
+		// read the input and run the fixed update steps it covers
+		double updateTime = glfwGetTime();
+		g_ViewManager->ProcessInputEvents();
+		{
+			PROFILE_SCOPE("FixedUpdate");
+			int updateSteps = g_UpdateTimestep->Advance(updateTime);
+			for (int step = 0; step < updateSteps; step++)
+			{
+				g_ViewManager->FixedUpdate((float)g_UpdateTimestep->GetStepSeconds());
+			}
+		}
+		g_ViewManager->UpdateView(g_UpdateTimestep->GetInterpolation());
+		PickObjectAtCrosshair();
+
+		// cull every view into the free snapshot and hand it to the render thread
+		double buildBeginTime = glfwGetTime();
+		RENDER_SNAPSHOT& snapshot = renderThread.GetWriteSnapshot();
+		glfwGetFramebufferSize(g_Window, &snapshot.framebufferWidth, &snapshot.framebufferHeight);
+
+		int viewCount = g_ViewManager->GetViewCount();
+		snapshot.views.resize(viewCount);
+		snapshot.viewPackets.resize(viewCount);
+		for (int v = 0; v < viewCount; v++)
+		{
+			snapshot.views[v] = g_ViewManager->GetSceneView(v);
+			g_SceneManager->BuildDrawPackets(snapshot.views[v], snapshot.viewPackets[v]);
+		}
+		snapshot.bShowPerfOverlay = g_ViewManager->IsPerfOverlayVisible();
+		snapshot.buildMilliseconds = (glfwGetTime() - buildBeginTime) * 1000.0;
+		renderThread.PublishSnapshot();
+
+		// sleep until the next update step is due, waking early for input
+		double waitSeconds = (1.0 - g_UpdateTimestep->GetInterpolation()) * g_UpdateTimestep->GetStepSeconds() -
+			(glfwGetTime() - updateTime);
+		if (bUncapped || (waitSeconds <= 0.0))
+		{
+			PROFILE_SCOPE("PollEvents");
+			glfwPollEvents();
+		}
+		else
+		{
+			PROFILE_SCOPE("WaitEvents");
+			glfwWaitEventsTimeout(waitSeconds);
+		}
+	}
+
+	renderThread.Stop();
+	renderThread.PrintStats();
+}
+
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the command line options.
+ *
+ *  --benchmark <frames>   time the given number of frames,
+ *                         print a report and exit
+ *  --gpu-times            show the GPU pass times in the
+ *                         window title
+ *  --trace <file>         write the CPU profiler events to
+ *                         a Chrome trace JSON file at exit
+ *  --fast-start           decode textures on worker threads
+ *                         while the window is created
+ *  --on-demand            redraw only when something changed
+ *                         and sleep waiting for input otherwise
+ *  --vsync                wait for the display refresh on
+ *                         every swap (the default)
+ *  --uncapped             swap without waiting, the default
+ *                         for benchmarks
+ *  --fps <rate>           limit the frame rate to the given
+ *                         number of frames per second
+ *  --update-rate <rate>   fixed update steps per second for
+ *                         camera movement (default 120)
+ *  --record <file>        write every input event and frame
+ *                         time to a binary input log
+ *  --replay <file>        play back an input log instead of
+ *                         the live input, then exit
+ *  --views <layout>       single (default), split, pip,
+ *                         ortho-inset or quad views of the
+ *                         scene in one window
+ *  --batch <poses>        render each camera pose in the
+ *                         file to an image, then exit
+ *  --batch-output <dir>   folder the batch images go to
+ *  --tile-size <pixels>   size of each batch image (256)
+ *  --image-format <png|qoi>
+ *                         format of the written images
+ *  --hires <file.ppm>     render one image in tiles at the
+ *                         --hires-size, then exit
+ *  --hires-size <WxH>     size of the tiled image (16384x16384)
+ *  --hires-camera "<x y z yaw pitch [zoom] [ortho]>"
+ *                         camera of the tiled image (the
+ *                         start camera)
+ *  --server <socket>      run render worker processes that take
+ *                         jobs over a Unix domain socket
+ *  --server-workers <n>   worker processes (one per two cores)
+ *  --capture <dir>        write every rendered frame to the
+ *                         folder as a numbered image
+ *  --capture-threads <n>  most frames encoded at once (one
+ *                         per job worker)
+ *  --software             draw batch and server images with
+ *                         the CPU rasterizer
+ *  --software-threads <n> rasterizer threads (one per core)
+ *  --job-threads <n>      job system worker threads (one per
+ *                         core, less one)
+ *  --golden <poses>       check each camera pose in the file
+ *                         against its reference image and
+ *                         time, then exit
+ *  --golden-dir <dir>     folder of the reference images and
+ *                         timings (golden)
+ *  --golden-update        record the references again
+ *  --golden-tolerance <n> channel difference allowed per
+ *                         pixel, out of 255 (8)
+ *  --microbench           time the scene's CPU hot paths one
+ *                         function at a time, then exit
+ *  --microbench-filter <text>
+ *                         run only the benchmarks whose name
+ *                         contains the text
+ *  --stress <objects>     draw a generated scene of 10 to
+ *                         1000000 random objects instead
+ *  --stress-seed <n>      seed of the generated scene (1)
+ *  --stress-sweep         time generated scenes of 10, 30,
+ *                         100, ... objects up to the --stress
+ *                         count, for --benchmark frames each,
+ *                         then exit
+ *  --render-thread        draw on a separate thread from
+ *                         scene snapshots built by the main
+ *                         thread
+ *  --replay-timing <original|fixed>
+ *                         hold replayed frames to their
+ *                         recorded times (default), or give
+ *                         every frame one update step
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--benchmark") == 0) && (i + 1 < argc))
+		{
+			g_BenchmarkFrames = atoi(argv[++i]);
+			if (g_BenchmarkFrames <= 0)
+			{
+				std::cout << "--benchmark needs a frame count above zero" << std::endl;
+				return(false);
+			}
+		}
+		else if (strcmp(argv[i], "--gpu-times") == 0)
+		{
+			g_bShowGpuTimes = true;
+		}
+		else if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+		{
+			g_TraceFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--fast-start") == 0)
+		{
+			g_bFastStart = true;
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			g_bOnDemand = true;
+		}
+		else if (strcmp(argv[i], "--vsync") == 0)
+		{
+			g_PacingMode = FramePacer::PACING_VSYNC;
+			g_bPacingModeSet = true;
+		}
+		else if (strcmp(argv[i], "--uncapped") == 0)
+		{
+			g_PacingMode = FramePacer::PACING_UNCAPPED;
+			g_bPacingModeSet = true;
+		}
+		else if ((strcmp(argv[i], "--fps") == 0) && (i + 1 < argc))
+		{
+			g_TargetFramesPerSecond = atof(argv[++i]);
+			if (g_TargetFramesPerSecond <= 0.0)
+			{
+				std::cout << "--fps needs a frame rate above zero" << std::endl;
+				return(false);
+			}
+			g_PacingMode = FramePacer::PACING_LIMITED;
+			g_bPacingModeSet = true;
+		}
+		else if ((strcmp(argv[i], "--record") == 0) && (i + 1 < argc))
+		{
+			g_RecordFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--replay") == 0) && (i + 1 < argc))
+		{
+			g_ReplayFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--views") == 0) && (i + 1 < argc))
+		{
+			i++;
+			if (strcmp(argv[i], "single") == 0)
+			{
+				g_ViewLayout = ViewManager::VIEW_LAYOUT_SINGLE;
+			}
+			else if (strcmp(argv[i], "split") == 0)
+			{
+				g_ViewLayout = ViewManager::VIEW_LAYOUT_SPLIT;
+			}
+			else if (strcmp(argv[i], "pip") == 0)
+			{
+				g_ViewLayout = ViewManager::VIEW_LAYOUT_PICTURE_IN_PICTURE;
+			}
+			else if (strcmp(argv[i], "ortho-inset") == 0)
+			{
+				g_ViewLayout = ViewManager::VIEW_LAYOUT_ORTHO_INSET;
+			}
+			else if (strcmp(argv[i], "quad") == 0)
+			{
+				g_ViewLayout = ViewManager::VIEW_LAYOUT_QUAD;
+			}
+			else
+			{
+				std::cout << "--views must be single, split, pip, ortho-inset or quad" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--batch") == 0) && (i + 1 < argc))
+		{
+			g_BatchPosesFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--batch-output") == 0) && (i + 1 < argc))
+		{
+			g_BatchOutputFolder = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--tile-size") == 0) && (i + 1 < argc))
+		{
+			g_BatchTileSize = atoi(argv[++i]);
+			if (g_BatchTileSize <= 0)
+			{
+				std::cout << "--tile-size needs a size above zero" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--image-format") == 0) && (i + 1 < argc))
+		{
+			if (ImageWriter::ParseFormat(argv[++i], g_ImageFormat) == false)
+			{
+				std::cout << "--image-format must be png or qoi" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--hires") == 0) && (i + 1 < argc))
+		{
+			g_HiresFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--hires-size") == 0) && (i + 1 < argc))
+		{
+			if ((sscanf(argv[++i], "%dx%d", &g_HiresWidth, &g_HiresHeight) != 2) ||
+				(g_HiresWidth <= 0) || (g_HiresHeight <= 0))
+			{
+				std::cout << "--hires-size expects WIDTHxHEIGHT" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--hires-camera") == 0) && (i + 1 < argc))
+		{
+			g_HiresCamera = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--server") == 0) && (i + 1 < argc))
+		{
+			g_ServerSocketPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--server-workers") == 0) && (i + 1 < argc))
+		{
+			g_ServerWorkers = atoi(argv[++i]);
+			if (g_ServerWorkers <= 0)
+			{
+				std::cout << "--server-workers needs a count above zero" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--capture") == 0) && (i + 1 < argc))
+		{
+			g_CaptureFolder = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--capture-threads") == 0) && (i + 1 < argc))
+		{
+			g_CaptureThreads = atoi(argv[++i]);
+			if (g_CaptureThreads <= 0)
+			{
+				std::cout << "--capture-threads needs a count above zero" << std::endl;
+				return(false);
+			}
+		}
+		else if (strcmp(argv[i], "--software") == 0)
+		{
+			g_bSoftwareRender = true;
+		}
+		else if ((strcmp(argv[i], "--software-threads") == 0) && (i + 1 < argc))
+		{
+			g_SoftwareThreads = atoi(argv[++i]);
+			if (g_SoftwareThreads <= 0)
+			{
+				std::cout << "--software-threads needs a count above zero" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--job-threads") == 0) && (i + 1 < argc))
+		{
+			g_JobThreads = atoi(argv[++i]);
+			if (g_JobThreads <= 0)
+			{
+				std::cout << "--job-threads needs a count above zero" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--golden") == 0) && (i + 1 < argc))
+		{
+			g_GoldenPosesFilename = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--golden-dir") == 0) && (i + 1 < argc))
+		{
+			g_GoldenFolder = argv[++i];
+		}
+		else if (strcmp(argv[i], "--golden-update") == 0)
+		{
+			g_bGoldenUpdate = true;
+		}
+		else if ((strcmp(argv[i], "--golden-tolerance") == 0) && (i + 1 < argc))
+		{
+			g_GoldenTolerance = atoi(argv[++i]);
+			if ((g_GoldenTolerance < 0) || (g_GoldenTolerance > 255))
+			{
+				std::cout << "--golden-tolerance must be from 0 to 255" << std::endl;
+				return(false);
+			}
+		}
+		else if (strcmp(argv[i], "--microbench") == 0)
+		{
+			g_bMicrobenchmark = true;
+		}
+		else if ((strcmp(argv[i], "--microbench-filter") == 0) && (i + 1 < argc))
+		{
+			g_MicrobenchmarkFilter = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--stress") == 0) && (i + 1 < argc))
+		{
+			g_StressObjectCount = atoi(argv[++i]);
+			if ((g_StressObjectCount < SceneManager::MIN_STRESS_OBJECTS) || (g_StressObjectCount > SceneManager::MAX_STRESS_OBJECTS))
+			{
+				std::cout << "--stress needs from " << SceneManager::MIN_STRESS_OBJECTS << " to " << SceneManager::MAX_STRESS_OBJECTS << " objects" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--stress-seed") == 0) && (i + 1 < argc))
+		{
+			g_StressSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--stress-sweep") == 0)
+		{
+			g_bStressSweep = true;
+		}
+		else if (strcmp(argv[i], "--render-thread") == 0)
+		{
+			g_bRenderThread = true;
+		}
+		else if ((strcmp(argv[i], "--replay-timing") == 0) && (i + 1 < argc))
+		{
+			i++;
+			if (strcmp(argv[i], "original") == 0)
+			{
+				g_ReplayTiming = InputRecorder::REPLAY_ORIGINAL;
+			}
+			else if (strcmp(argv[i], "fixed") == 0)
+			{
+				g_ReplayTiming = InputRecorder::REPLAY_FIXED;
+			}
+			else
+			{
+				std::cout << "--replay-timing must be original or fixed" << std::endl;
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--update-rate") == 0) && (i + 1 < argc))
+		{
+			g_UpdatesPerSecond = atof(argv[++i]);
+			if (g_UpdatesPerSecond <= 0.0)
+			{
+				std::cout << "--update-rate needs a rate above zero" << std::endl;
+				return(false);
+			}
+		}
+		else
+		{
+			std::cout << "Unknown option: " << argv[i] << std::endl;
+			std::cout << "Usage: " << argv[0] << " [--benchmark <frames>] [--gpu-times] [--trace <file>] [--fast-start] [--on-demand] [--vsync | --uncapped | --fps <rate>] [--update-rate <rate>] [--views single|split|pip|ortho-inset|quad] [--record <file> | --replay <file> [--replay-timing original|fixed]] [--batch <poses> [--batch-output <dir>] [--tile-size <pixels>] [--image-format png|qoi]] [--hires <file.ppm> [--hires-size WxH] [--hires-camera \"x y z yaw pitch\"]] [--server <socket> [--server-workers <n>]] [--capture <dir> [--capture-threads <n>]] [--software [--software-threads <n>]] [--job-threads <n>] [--golden <poses> [--golden-dir <dir>] [--golden-update] [--golden-tolerance <n>]] [--microbench [--microbench-filter <text>]] [--stress <objects>] [--stress-seed <n>] [--stress-sweep] [--render-thread]" << std::endl;
+			return(false);
+		}
+	}
+
+	if ((g_RecordFilename.empty() == false) && (g_ReplayFilename.empty() == false))
+	{
+		std::cout << "--record and --replay cannot be used together" << std::endl;
+		return(false);
+	}
+
+	// on-demand redraws and input logs need the single-threaded frame loop,
+	// and the window title can only be set from the main thread
+	if (g_bRenderThread &&
+		(g_bOnDemand || g_bShowGpuTimes || (g_RecordFilename.empty() == false) || (g_ReplayFilename.empty() == false)))
+	{
+		std::cout << "--render-thread cannot be used with --on-demand, --gpu-times, --record or --replay" << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	AccumulatePassTimes()
+ *
+ *  This function is used to add the GPU pass times of every
+ *  frame read back at the start of this frame to the
+ *  benchmark totals. Several frames can come back at once.
+ ***********************************************************/
+void AccumulatePassTimes(std::vector<PASS_TOTAL>& passTotals)
+{
+	for (int frame = 0; frame < g_GpuTimer->GetNewFrameCount(); frame++)
+	{
+		for (int i = 0; i < g_GpuTimer->GetNewFramePassCount(frame); i++)
+		{
+			const char* passName = g_GpuTimer->GetNewFramePassName(frame, i);
+			double milliseconds = g_GpuTimer->GetNewFramePassMilliseconds(frame, i);
+
+			size_t index = 0;
+			while ((index < passTotals.size()) && (passTotals[index].name != passName))
+			{
+				index++;
+			}
+			if (index == passTotals.size())
+			{
+				passTotals.push_back(PASS_TOTAL());
+				passTotals[index].name = passName;
+			}
+
+			passTotals[index].totalMilliseconds += milliseconds;
+			passTotals[index].maxMilliseconds = std::max(passTotals[index].maxMilliseconds, milliseconds);
+			passTotals[index].frameCount++;
+		}
+	}
+}
+
+/***********************************************************
+ *	PrintBenchmarkReport()
+ *
+ *  This function is used to print the CPU frame times and
+ *  the average GPU time of each pass.
+ ***********************************************************/
+void PrintBenchmarkReport(const std::vector<double>& frameTimes, const std::vector<PASS_TOTAL>& passTotals)
+{
+	if (frameTimes.empty())
+	{
+		return;
+	}
+
+	std::vector<double> sortedTimes = frameTimes;
+	std::sort(sortedTimes.begin(), sortedTimes.end());
+
+	double totalMilliseconds = 0.0;
+	for (size_t i = 0; i < sortedTimes.size(); i++)
+	{
+		totalMilliseconds += sortedTimes[i];
+	}
+	double averageMilliseconds = totalMilliseconds / sortedTimes.size();
+
+	double squaredDeviations = 0.0;
+	for (size_t i = 0; i < sortedTimes.size(); i++)
+	{
+		squaredDeviations += (sortedTimes[i] - averageMilliseconds) * (sortedTimes[i] - averageMilliseconds);
+	}
+	double standardDeviation = (sortedTimes.size() > 1) ? sqrt(squaredDeviations / (sortedTimes.size() - 1)) : 0.0;
+	double p99Milliseconds = sortedTimes[(sortedTimes.size() - 1) * 99 / 100];
+
+	char line[256];
+	std::cout << "BENCHMARK: " << sortedTimes.size() << " frames" << std::endl;
+	snprintf(line, sizeof(line), "  frame  avg %8.3f ms  stddev %8.3f ms  min %8.3f ms  p99 %8.3f ms  max %8.3f ms  (%.1f fps)",
+		averageMilliseconds, standardDeviation, sortedTimes.front(), p99Milliseconds, sortedTimes.back(),
+		1000.0 / averageMilliseconds);
+	std::cout << line << std::endl;
+
+	for (size_t i = 0; i < passTotals.size(); i++)
+	{
+		const PASS_TOTAL& pass = passTotals[i];
+		snprintf(line, sizeof(line), "  gpu %-8s avg %8.3f ms  max %8.3f ms  (%d frames)",
+			pass.name.c_str(), pass.totalMilliseconds / pass.frameCount, pass.maxMilliseconds, pass.frameCount);
+		std::cout << line << std::endl;
+	}
+}
+
+/***********************************************************
+ *	PrintFrameStatsJSON()
+ *
+ *  This function is used to print one JSON line with the CPU
+ *  frame time, the render counters of the frame, and the GPU
+ *  pass times of the latest frame read back from the GPU.
+ ***********************************************************/
+void PrintFrameStatsJSON(int frameNumber, double frameMilliseconds)
+{
+	std::string line = "{\"frame\":" + std::to_string(frameNumber);
+
+	char number[32];
+	snprintf(number, sizeof(number), "%.3f", frameMilliseconds);
+	line += ",\"cpu_ms\":";
+	line += number;
+
+	line += "," + RenderStats::FormatJSONFields(RenderStats::GetFrameStats());
+
+	line += ",\"gpu_ms\":{";
+	for (int i = 0; i < g_GpuTimer->GetPassCount(); i++)
+	{
+		snprintf(number, sizeof(number), "%.3f", g_GpuTimer->GetPassMilliseconds(i));
+		line += (i > 0) ? ",\"" : "\"";
+		line += g_GpuTimer->GetPassName(i);
+		line += "\":";
+		line += number;
+	}
+	line += "}}";
+
+	std::cout << line << "\n";
+}
+
+/***********************************************************
+ *	ShowGpuTimesInTitle()
+ *
+ *  This function is used to put the smoothed GPU pass times
+ *  in the window title a couple of times a second.
+ ***********************************************************/
+void ShowGpuTimesInTitle()
+{
+	static double lastUpdateTime = 0.0;
+
+	double currentTime = glfwGetTime();
+	if (currentTime - lastUpdateTime < g_TitleUpdateInterval)
+	{
+		return;
+	}
+	lastUpdateTime = currentTime;
+
+	std::string title = WINDOW_TITLE;
+	char passText[64];
+	for (int i = 0; i < g_GpuTimer->GetPassCount(); i++)
+	{
+		snprintf(passText, sizeof(passText), "  |  %s %.3f ms",
+			g_GpuTimer->GetPassName(i), g_GpuTimer->GetAveragePassMilliseconds(i));
+		title += passText;
+	}
+
+	glfwSetWindowTitle(g_Window, title.c_str());
+}
+
+/***********************************************************
+ *	InitializeGLFW()
+ *
+ *  This function is used to initialize the GLFW library.
+ ***********************************************************/
+bool InitializeGLFW()
+{
+	STARTUP_PHASE("InitializeGLFW");
+
+	// GLFW: initialize and configure library
+	// --------------------------------------
+	glfwInit();
+
+#ifdef __APPLE__
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+	// GLFW: end -------------------------------
+
+	return(true);
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ ***********************************************************/
+bool InitializeGLEW()
+{
+	STARTUP_PHASE("InitializeGLEW");
+
+	// GLEW: initialize
+	// -----------------------------------------
+	GLenum GLEWInitResult = GLEW_OK;
+
+	// try to initialize the GLEW library
+	GLEWInitResult = glewInit();
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		return false;
+	}
+	// GLEW: end -------------------------------
+
+	// Displays a successful OpenGL initialization message
+	std::cout << "INFO: OpenGL Successfully Initialized\n";
+	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+	return(true);
 }
\ No newline at end of file
@@ -0,0 +1,520 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Microbenchmark.cpp
+// ==================
+// timing and heap allocation counts of the CPU hot paths of the scene
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "Microbenchmark.h"
+#include "AllocationCounter.h"
+#include "Profiler.h"
+#include "ShapeGeometry.h"
+#include "ShapeMeshes.h"
+#include "StartupReport.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <GL/glew.h>
+
+namespace
+{
+	// each measured batch of cheap calls runs at least this long
+	const uint64_t g_MinBatchNanoseconds = 20000000;
+	// batches the median is taken over
+	const int g_MeasuredBatches = 5;
+	// expensive calls are repeated until both the count and the total time are reached
+	const size_t g_MinSingleCalls = 5;
+	const size_t g_MaxSingleCalls = 200;
+	const uint64_t g_MinSingleNanoseconds = 200000000;
+
+	// counts the scaling benchmarks run with; powers of two, so an index
+	// wraps with a mask instead of a division inside the timed loop
+	const int g_ObjectCounts[] = { 1, 16, 256, 4096 };
+	const int g_TextureCounts[] = { 2, 8, 16 };
+	const int g_MaterialCounts[] = { 4, 64, 1024 };
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  A fixed sequence, so every run measures the same calls.
+	 ***********************************************************/
+	float NextRandom(uint32_t& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (float)(state >> 8) / 16777216.0f;
+	}
+
+	/***********************************************************
+	 *  Median()
+	 ***********************************************************/
+	double Median(std::vector<double> values)
+	{
+		if (values.empty())
+		{
+			return 0.0;
+		}
+
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+	/***********************************************************
+	 *  DeleteBoundMesh()
+	 *
+	 *  Frees the vertex array a Load...Mesh() call leaves bound,
+	 *  along with its vertex and index buffers.
+	 ***********************************************************/
+	void DeleteBoundMesh()
+	{
+		GLint vertexArray = 0;
+		GLint arrayBuffer = 0;
+		GLint elementBuffer = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+		glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// names of zero are ignored
+		GLuint buffers[2] = { (GLuint)arrayBuffer, (GLuint)elementBuffer };
+		glDeleteBuffers(2, buffers);
+		GLuint vertexArrayName = (GLuint)vertexArray;
+		glDeleteVertexArrays(1, &vertexArrayName);
+	}
+}
+
+/***********************************************************
+ *  Microbenchmark()
+ ***********************************************************/
+Microbenchmark::Microbenchmark()
+	: m_sink(0.0f)
+{
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for running every selected benchmark
+ *  in turn. Lookups run on a scene of their own filled with
+ *  made-up entries, so the scene being rendered keeps its
+ *  textures and materials.
+ ***********************************************************/
+bool Microbenchmark::Run(SceneManager* pSceneManager)
+{
+	if (NULL == pSceneManager)
+	{
+		return false;
+	}
+
+	// the loads below would otherwise be added to the startup phases
+	StartupReport::StopRecording();
+
+	// the rest of the program runs without the cost of counting
+	AllocationCounter::SetEnabled(true);
+	m_results.clear();
+	RunTransformBenchmarks(pSceneManager);
+	RunLookupBenchmarks(pSceneManager);
+	RunMeshBenchmarks();
+	RunTextureBenchmarks(pSceneManager);
+	AllocationCounter::SetEnabled(false);
+
+	if (m_results.empty())
+	{
+		std::cout << "No microbenchmark matches \"" << m_filter << "\"" << std::endl;
+		return false;
+	}
+
+	PrintResults();
+	return true;
+}
+
+/***********************************************************
+ *  IsSelected()
+ ***********************************************************/
+bool Microbenchmark::IsSelected(const std::string& name) const
+{
+	return m_filter.empty() || (name.find(m_filter) != std::string::npos);
+}
+
+/***********************************************************
+ *  MeasureBatches()
+ *
+ *  This method is used for timing a call too cheap for the
+ *  clock on its own. The batch grows until it runs for the
+ *  minimum batch time, which also warms the caches, then the
+ *  median time per call over the measured batches is kept.
+ ***********************************************************/
+template <typename OPERATION>
+void Microbenchmark::MeasureBatches(const std::string& name, int count, OPERATION operation)
+{
+	if (IsSelected(name) == false)
+	{
+		return;
+	}
+
+	uint64_t iterations = 1;
+	uint64_t index = 0;
+	for (;;)
+	{
+		uint64_t startTime = Profiler::Now();
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			operation(index++);
+		}
+		uint64_t elapsed = Profiler::Now() - startTime;
+		if (elapsed >= g_MinBatchNanoseconds)
+		{
+			break;
+		}
+
+		// aim a little past the minimum, growing at most tenfold a step
+		uint64_t target = iterations * 10;
+		if (elapsed > 0)
+		{
+			target = std::min(target, iterations * g_MinBatchNanoseconds * 5 / 4 / elapsed + 1);
+		}
+		iterations = std::max(target, iterations + 1);
+	}
+
+	std::vector<double> batchTimes;
+	batchTimes.reserve(g_MeasuredBatches);
+	uint64_t allocationsBefore = AllocationCounter::GetAllocationCount();
+	uint64_t bytesBefore = AllocationCounter::GetAllocatedBytes();
+	for (int batch = 0; batch < g_MeasuredBatches; batch++)
+	{
+		uint64_t startTime = Profiler::Now();
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			operation(index++);
+		}
+		batchTimes.push_back((double)(Profiler::Now() - startTime) / (double)iterations);
+	}
+	double measuredCalls = (double)iterations * g_MeasuredBatches;
+
+	BENCHMARK_RESULT result;
+	result.name = name;
+	result.count = count;
+	result.iterations = iterations * g_MeasuredBatches;
+	result.nanosecondsPerOp = Median(batchTimes);
+	result.allocationsPerOp = (double)(AllocationCounter::GetAllocationCount() - allocationsBefore) / measuredCalls;
+	result.bytesPerOp = (double)(AllocationCounter::GetAllocatedBytes() - bytesBefore) / measuredCalls;
+	m_results.push_back(result);
+}
+
+/***********************************************************
+ *  MeasureEach()
+ *
+ *  This method is used for timing a call long enough to be
+ *  timed on its own. One untimed call comes first, so costs
+ *  paid only on first use stay out of the median.
+ ***********************************************************/
+template <typename OPERATION, typename RESET>
+void Microbenchmark::MeasureEach(const std::string& name, int count, OPERATION operation, RESET reset)
+{
+	if (IsSelected(name) == false)
+	{
+		return;
+	}
+
+	operation();
+	reset();
+
+	std::vector<double> callTimes;
+	callTimes.reserve(g_MaxSingleCalls);
+	uint64_t totalTime = 0;
+	uint64_t allocations = 0;
+	uint64_t bytes = 0;
+	while ((callTimes.size() < g_MaxSingleCalls) &&
+		((callTimes.size() < g_MinSingleCalls) || (totalTime < g_MinSingleNanoseconds)))
+	{
+		uint64_t allocationsBefore = AllocationCounter::GetAllocationCount();
+		uint64_t bytesBefore = AllocationCounter::GetAllocatedBytes();
+		uint64_t startTime = Profiler::Now();
+		operation();
+		uint64_t elapsed = Profiler::Now() - startTime;
+		allocations += AllocationCounter::GetAllocationCount() - allocationsBefore;
+		bytes += AllocationCounter::GetAllocatedBytes() - bytesBefore;
+
+		totalTime += elapsed;
+		callTimes.push_back((double)elapsed);
+		reset();
+	}
+
+	BENCHMARK_RESULT result;
+	result.name = name;
+	result.count = count;
+	result.iterations = callTimes.size();
+	result.nanosecondsPerOp = Median(callTimes);
+	result.allocationsPerOp = (double)allocations / (double)callTimes.size();
+	result.bytesPerOp = (double)bytes / (double)callTimes.size();
+	m_results.push_back(result);
+}
+
+/***********************************************************
+ *  RunTransformBenchmarks()
+ *
+ *  This method is used for timing the per-draw model matrix
+ *  and the per-frame light uniforms. The object count is the
+ *  number of different transforms the calls cycle through.
+ ***********************************************************/
+void Microbenchmark::RunTransformBenchmarks(SceneManager* pSceneManager)
+{
+	struct OBJECT_TRANSFORM
+	{
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+	};
+
+	uint32_t randomState = 1;
+	for (size_t c = 0; c < sizeof(g_ObjectCounts) / sizeof(g_ObjectCounts[0]); c++)
+	{
+		const int objectCount = g_ObjectCounts[c];
+		const uint64_t indexMask = (uint64_t)objectCount - 1;
+
+		std::vector<OBJECT_TRANSFORM> transforms(objectCount);
+		for (int i = 0; i < objectCount; i++)
+		{
+			transforms[i].scaleXYZ = glm::vec3(0.5f + NextRandom(randomState), 0.5f + NextRandom(randomState), 0.5f + NextRandom(randomState));
+			transforms[i].rotationDegrees = glm::vec3(NextRandom(randomState), NextRandom(randomState), NextRandom(randomState)) * 360.0f;
+			transforms[i].positionXYZ = glm::vec3(NextRandom(randomState), NextRandom(randomState), NextRandom(randomState)) * 20.0f - 10.0f;
+		}
+
+		MeasureBatches("BuildModelMatrix", objectCount,
+			[&](uint64_t i)
+			{
+				const OBJECT_TRANSFORM& transform = transforms[i & indexMask];
+				glm::mat4 model = pSceneManager->BuildModelMatrix(
+					transform.scaleXYZ,
+					transform.rotationDegrees.x,
+					transform.rotationDegrees.y,
+					transform.rotationDegrees.z,
+					transform.positionXYZ);
+				m_sink = model[3][0];
+			});
+
+		MeasureBatches("SetTransformations", objectCount,
+			[&](uint64_t i)
+			{
+				const OBJECT_TRANSFORM& transform = transforms[i & indexMask];
+				pSceneManager->SetTransformations(
+					transform.scaleXYZ,
+					transform.rotationDegrees.x,
+					transform.rotationDegrees.y,
+					transform.rotationDegrees.z,
+					transform.positionXYZ);
+			});
+	}
+
+	MeasureBatches("SetShaderLights", 0,
+		[&](uint64_t)
+		{
+			pSceneManager->SetShaderLights();
+		});
+
+	// the uniform calls only queue work; let it drain before the next benchmark
+	glFinish();
+}
+
+/***********************************************************
+ *  RunLookupBenchmarks()
+ *
+ *  This method is used for timing the texture and material
+ *  lookups by tag with tables of different sizes. The calls
+ *  cycle through every tag, so on average half the table is
+ *  searched, as with a real scene's mix of objects.
+ ***********************************************************/
+void Microbenchmark::RunLookupBenchmarks(SceneManager* pSceneManager)
+{
+	SceneManager lookupScene(pSceneManager->m_pShaderManager);
+	char tag[32];
+
+	for (size_t c = 0; c < sizeof(g_TextureCounts) / sizeof(g_TextureCounts[0]); c++)
+	{
+		const int textureCount = g_TextureCounts[c];
+		const uint64_t indexMask = (uint64_t)textureCount - 1;
+
+		std::vector<std::string> tags(textureCount);
+		for (int i = 0; i < textureCount; i++)
+		{
+			snprintf(tag, sizeof(tag), "texture%d", i);
+			tags[i] = tag;
+			// no OpenGL texture behind the entry, so there is nothing to delete
+			lookupScene.m_textureIDs[i].ID = 0;
+			lookupScene.m_textureIDs[i].tag = tags[i];
+		}
+		lookupScene.m_loadedTextures = textureCount;
+
+		MeasureBatches("FindTextureSlot", textureCount,
+			[&](uint64_t i)
+			{
+				m_sink = (float)lookupScene.FindTextureSlot(tags[i & indexMask]);
+			});
+	}
+
+	uint32_t randomState = 2;
+	for (size_t c = 0; c < sizeof(g_MaterialCounts) / sizeof(g_MaterialCounts[0]); c++)
+	{
+		const int materialCount = g_MaterialCounts[c];
+		const uint64_t indexMask = (uint64_t)materialCount - 1;
+
+		std::vector<std::string> tags(materialCount);
+		lookupScene.m_objectMaterials.clear();
+		for (int i = 0; i < materialCount; i++)
+		{
+			snprintf(tag, sizeof(tag), "material%d", i);
+			tags[i] = tag;
+
+			SceneManager::OBJECT_MATERIAL material;
+			material.ambientStrength = NextRandom(randomState);
+			material.ambientColor = glm::vec3(NextRandom(randomState));
+			material.diffuseColor = glm::vec3(NextRandom(randomState));
+			material.specularColor = glm::vec3(NextRandom(randomState));
+			material.shininess = 1.0f + 63.0f * NextRandom(randomState);
+			material.tag = tags[i];
+			lookupScene.m_objectMaterials.push_back(material);
+		}
+
+		SceneManager::OBJECT_MATERIAL foundMaterial;
+		MeasureBatches("FindMaterial", materialCount,
+			[&](uint64_t i)
+			{
+				m_sink = lookupScene.FindMaterial(tags[i & indexMask], foundMaterial) ? foundMaterial.shininess : 0.0f;
+			});
+	}
+
+	lookupScene.m_loadedTextures = 0;
+}
+
+/***********************************************************
+ *  RunMeshBenchmarks()
+ *
+ *  This method is used for timing the generation and upload
+ *  of the procedural meshes. Each call makes a new vertex
+ *  array and CPU triangle list, which are freed again outside
+ *  the timed part, so every call is a load from scratch. The
+ *  meshes are loaded once more at the end, untimed, so the
+ *  scene's software rasterizer finds its triangles again.
+ ***********************************************************/
+void Microbenchmark::RunMeshBenchmarks()
+{
+	ShapeMeshes meshes;
+
+	MeasureEach("LoadTorusMesh", 0,
+		[&]()
+		{
+			meshes.LoadTorusMesh();
+		},
+		[]()
+		{
+			DeleteBoundMesh();
+			ClearShapeTriangles(SHAPE_TORUS);
+		});
+
+	MeasureEach("LoadSphereMesh", 0,
+		[&]()
+		{
+			meshes.LoadSphereMesh();
+		},
+		[]()
+		{
+			DeleteBoundMesh();
+			ClearShapeTriangles(SHAPE_SPHERE);
+		});
+
+	meshes.LoadTorusMesh();
+	DeleteBoundMesh();
+	meshes.LoadSphereMesh();
+	DeleteBoundMesh();
+}
+
+/***********************************************************
+ *  RunTextureBenchmarks()
+ *
+ *  This method is used for timing the decode of each scene
+ *  texture file on its own, and CreateGLTexture() with the
+ *  decode, upload and mipmap generation together. Uploads
+ *  go to a scene of their own and are deleted after each
+ *  call; the scene's textures are bound again at the end.
+ ***********************************************************/
+void Microbenchmark::RunTextureBenchmarks(SceneManager* pSceneManager)
+{
+	SceneManager textureScene(pSceneManager->m_pShaderManager);
+
+	for (int t = 0; NULL != SceneManager::GetSceneTextureFilename(t); t++)
+	{
+		const char* filename = SceneManager::GetSceneTextureFilename(t);
+		const char* baseName = strrchr(filename, '/');
+		baseName = (NULL != baseName) ? baseName + 1 : filename;
+
+		SceneManager::DECODED_IMAGE image;
+		MeasureEach(std::string("DecodeTextureImage ") + baseName, 0,
+			[&]()
+			{
+				image = SceneManager::DecodeTextureImage(filename);
+			},
+			[&]()
+			{
+				if (image.pixels)
+				{
+					stbi_image_free(image.pixels);
+					image.pixels = nullptr;
+				}
+			});
+
+		// every load prints a line, which would bury the table
+		std::cout.setstate(std::ios_base::badbit);
+		MeasureEach(std::string("CreateGLTexture ") + baseName, 0,
+			[&]()
+			{
+				textureScene.CreateGLTexture(filename, "benchmark");
+			},
+			[&]()
+			{
+				glFinish();
+				textureScene.DestroyGLTextures();
+			});
+		std::cout.clear();
+	}
+
+	// the uploads bound their textures to the scene's last texture unit
+	pSceneManager->BindGLTextures();
+}
+
+/***********************************************************
+ *  PrintResults()
+ ***********************************************************/
+void Microbenchmark::PrintResults() const
+{
+	printf("INFO: Microbenchmarks (median of %d batches of at least %.0f ms, or of single calls)\n",
+		g_MeasuredBatches,
+		g_MinBatchNanoseconds / 1.0e6);
+	printf("  %-32s %6s %11s %14s %10s %11s\n", "benchmark", "count", "iterations", "ns/op", "allocs/op", "bytes/op");
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const BENCHMARK_RESULT& result = m_results[i];
+		char count[16];
+		if (result.count > 0)
+		{
+			snprintf(count, sizeof(count), "%d", result.count);
+		}
+		else
+		{
+			snprintf(count, sizeof(count), "-");
+		}
+
+		printf("  %-32s %6s %11llu %14.1f %10.2f %11.1f\n",
+			result.name.c_str(),
+			count,
+			(unsigned long long)result.iterations,
+			result.nanosecondsPerOp,
+			result.allocationsPerOp,
+			result.bytesPerOp);
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Microbenchmark.h
+// ================
+// timing and heap allocation counts of the CPU hot paths of the scene
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SceneManager.h"
+
+/***********************************************************
+ *  Microbenchmark
+ *
+ *  Times single scene functions in isolation, so a change to
+ *  one of them can be measured on its own instead of through
+ *  the frame time. Cheap calls run in batches long enough for
+ *  the clock, and each is measured over several batches and
+ *  the median taken; expensive calls, like mesh generation
+ *  and texture loading, are timed one call at a time with
+ *  their cleanup left out of the time.
+ *
+ *  Benchmarks with a count run once per count, so the cost
+ *  can be seen growing with the number of objects, textures
+ *  or materials. Allocations are the calls to operator new,
+ *  counted by AllocationCounter only while the benchmarks
+ *  run.
+ ***********************************************************/
+class Microbenchmark
+{
+public:
+	Microbenchmark();
+
+	// run only the benchmarks whose name contains this text, empty for all
+	void SetFilter(const std::string& filter) { m_filter = filter; }
+
+	// run the benchmarks on the prepared scene and print a table of the
+	// results; the scene's GL state is put back afterwards
+	bool Run(SceneManager* pSceneManager);
+
+private:
+	struct BENCHMARK_RESULT
+	{
+		std::string name;
+		// objects, textures or materials the benchmark ran with, 0 for none
+		int count = 0;
+		uint64_t iterations = 0;
+		double nanosecondsPerOp = 0.0;
+		double allocationsPerOp = 0.0;
+		double bytesPerOp = 0.0;
+	};
+
+	std::string m_filter;
+	std::vector<BENCHMARK_RESULT> m_results;
+	// written with the results of pure calls so they are not optimized away
+	volatile float m_sink;
+
+	bool IsSelected(const std::string& name) const;
+
+	// time operation(i) over batches of growing size, then over several
+	// batches of the size that runs long enough, and record the median
+	template <typename OPERATION>
+	void MeasureBatches(const std::string& name, int count, OPERATION operation);
+	// time operation() one call at a time, running reset() untimed after each
+	template <typename OPERATION, typename RESET>
+	void MeasureEach(const std::string& name, int count, OPERATION operation, RESET reset);
+
+	void RunTransformBenchmarks(SceneManager* pSceneManager);
+	void RunLookupBenchmarks(SceneManager* pSceneManager);
+	void RunMeshBenchmarks();
+	void RunTextureBenchmarks(SceneManager* pSceneManager);
+
+	void PrintResults() const;
+};
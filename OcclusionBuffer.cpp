@@ -0,0 +1,392 @@
+/////////////////////////////////////////////////////////////////////////////////
+// OcclusionBuffer.cpp
+// ===================
+// low resolution CPU depth buffer for occlusion culling
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSIONBUFFER_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// clip space w below this is treated as behind the camera by TestBox()
+	const float g_NearClipW = 1.0e-3f;
+
+	// distance of a clip space position inside the near plane z = -w;
+	// negative is in front of it, where the depth would drop below 0
+	inline float NearPlaneDistance(const glm::vec4& clipPosition)
+	{
+		return clipPosition.z + clipPosition.w;
+	}
+
+	// corner order for the 12 triangles of a box
+	const int g_BoxTriangles[12][3] =
+	{
+		{ 0, 1, 3 }, { 0, 3, 2 },	// -X
+		{ 4, 6, 7 }, { 4, 7, 5 },	// +X
+		{ 0, 4, 5 }, { 0, 5, 1 },	// -Y
+		{ 2, 3, 7 }, { 2, 7, 6 },	// +Y
+		{ 0, 2, 6 }, { 0, 6, 4 },	// -Z
+		{ 1, 5, 7 }, { 1, 7, 3 }	// +Z
+	};
+
+	// the 8 corners of a box, bit 2 = x, bit 1 = y, bit 0 = z
+	inline glm::vec3 BoxCorner(const glm::vec3& minXYZ, const glm::vec3& maxXYZ, int corner)
+	{
+		return glm::vec3(
+			(corner & 4) ? maxXYZ.x : minXYZ.x,
+			(corner & 2) ? maxXYZ.y : minXYZ.y,
+			(corner & 1) ? maxXYZ.z : minXYZ.z);
+	}
+}
+
+/***********************************************************
+ *  OcclusionBuffer()
+ ***********************************************************/
+OcclusionBuffer::OcclusionBuffer()
+	: m_width(0),
+	m_height(0)
+{
+}
+
+/***********************************************************
+ *  Initialize()
+ ***********************************************************/
+void OcclusionBuffer::Initialize(int width, int height)
+{
+	m_width = (width + 3) & ~3;
+	m_height = height;
+	m_depth.assign(static_cast<size_t>(m_width) * m_height, 1.0f);
+}
+
+/***********************************************************
+ *  Clear()
+ ***********************************************************/
+void OcclusionBuffer::Clear()
+{
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+/***********************************************************
+ *  ClipToScreen()
+ ***********************************************************/
+glm::vec3 OcclusionBuffer::ClipToScreen(const glm::vec4& clipPosition) const
+{
+	float inverseW = 1.0f / clipPosition.w;
+
+	return glm::vec3(
+		((clipPosition.x * inverseW) * 0.5f + 0.5f) * m_width,
+		((clipPosition.y * inverseW) * 0.5f + 0.5f) * m_height,
+		(clipPosition.z * inverseW) * 0.5f + 0.5f);
+}
+
+/***********************************************************
+ *  RasterizeBox()
+ *
+ *  This method is used for drawing an occluder. Only boxes
+ *  and planes are drawn this way, since their bounds match
+ *  their surfaces and can never hide more than the real mesh.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeBox(
+	const glm::mat4& modelViewProjection,
+	const glm::vec3& minXYZ,
+	const glm::vec3& maxXYZ)
+{
+	if (m_depth.empty())
+	{
+		return;
+	}
+
+	glm::vec4 clipCorners[8];
+	for (int corner = 0; corner < 8; corner++)
+	{
+		clipCorners[corner] = modelViewProjection * glm::vec4(BoxCorner(minXYZ, maxXYZ, corner), 1.0f);
+	}
+
+	for (int i = 0; i < 12; i++)
+	{
+		glm::vec4 triangle[3] =
+		{
+			clipCorners[g_BoxTriangles[i][0]],
+			clipCorners[g_BoxTriangles[i][1]],
+			clipCorners[g_BoxTriangles[i][2]]
+		};
+
+		ClipAndRasterize(triangle);
+	}
+}
+
+/***********************************************************
+ *  ClipAndRasterize()
+ *
+ *  This method is used for cutting off the part of a triangle
+ *  in front of the near plane, which can leave a quad, before
+ *  it is rasterized. Skipping those triangles would lose the
+ *  desk whenever the camera looks down at it. The cut is at
+ *  the real near plane, the same one SoftwareRasterizer clips
+ *  against, so an occluder closer than the near plane writes
+ *  no depth the view itself would not draw.
+ ***********************************************************/
+void OcclusionBuffer::ClipAndRasterize(const glm::vec4 clipVertices[3])
+{
+	glm::vec4 polygon[4];
+	int vertexCount = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& current = clipVertices[i];
+		const glm::vec4& next = clipVertices[(i + 1) % 3];
+		float currentDistance = NearPlaneDistance(current);
+		float nextDistance = NearPlaneDistance(next);
+		bool bCurrentInside = currentDistance >= 0.0f;
+		bool bNextInside = nextDistance >= 0.0f;
+
+		if (bCurrentInside)
+		{
+			polygon[vertexCount++] = current;
+		}
+		if (bCurrentInside != bNextInside)
+		{
+			float t = currentDistance / (currentDistance - nextDistance);
+			polygon[vertexCount++] = current + (next - current) * t;
+		}
+	}
+
+	if (vertexCount < 3)
+	{
+		return;
+	}
+
+	glm::vec3 screen[4];
+	for (int i = 0; i < vertexCount; i++)
+	{
+		screen[i] = ClipToScreen(polygon[i]);
+	}
+
+	RasterizeTriangle(screen[0], screen[1], screen[2]);
+	if (vertexCount == 4)
+	{
+		RasterizeTriangle(screen[0], screen[2], screen[3]);
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for filling a triangle into the depth
+ *  buffer with edge functions, sampling pixel centers. Four
+ *  pixels of a row are evaluated together, and each pixel
+ *  keeps the nearer of its old depth and the triangle depth.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+{
+	// make the winding consistent so inside means all edges >= 0
+	float area = ((v1.x - v0.x) * (v2.y - v0.y)) - ((v1.y - v0.y) * (v2.x - v0.x));
+	if (fabsf(area) < 1.0e-6f)
+	{
+		return;
+	}
+	if (area < 0.0f)
+	{
+		glm::vec3 swap = v1;
+		v1 = v2;
+		v2 = swap;
+		area = -area;
+	}
+
+	int minX = static_cast<int>(floorf(glm::min(v0.x, glm::min(v1.x, v2.x))));
+	int maxX = static_cast<int>(ceilf(glm::max(v0.x, glm::max(v1.x, v2.x))));
+	int minY = static_cast<int>(floorf(glm::min(v0.y, glm::min(v1.y, v2.y))));
+	int maxY = static_cast<int>(ceilf(glm::max(v0.y, glm::max(v1.y, v2.y))));
+
+	minX = std::max(minX, 0) & ~3;
+	minY = std::max(minY, 0);
+	maxX = std::min(maxX, m_width - 1);
+	maxY = std::min(maxY, m_height - 1);
+
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+
+	// edge function e(x, y) = a*x + b*y + c for each edge, opposite a vertex
+	float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = (v1.x * v2.y) - (v1.y * v2.x);
+	float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = (v2.x * v0.y) - (v2.y * v0.x);
+	float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = (v0.x * v1.y) - (v0.y * v1.x);
+
+	float inverseArea = 1.0f / area;
+
+	// depth is linear in screen space, so it can be stepped like the edges
+	float depthDX = ((a0 * v0.z) + (a1 * v1.z) + (a2 * v2.z)) * inverseArea;
+	float depthDY = ((b0 * v0.z) + (b1 * v1.z) + (b2 * v2.z)) * inverseArea;
+	float depthC = ((c0 * v0.z) + (c1 * v1.z) + (c2 * v2.z)) * inverseArea;
+
+#ifdef OCCLUSIONBUFFER_USE_SSE
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 edgeA0 = _mm_set1_ps(a0);
+	const __m128 edgeA1 = _mm_set1_ps(a1);
+	const __m128 edgeA2 = _mm_set1_ps(a2);
+	const __m128 stepDepth = _mm_set1_ps(depthDX);
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		float pixelY = y + 0.5f;
+		float* row = &m_depth[static_cast<size_t>(y) * m_width];
+
+		__m128 rowE0 = _mm_set1_ps((b0 * pixelY) + c0);
+		__m128 rowE1 = _mm_set1_ps((b1 * pixelY) + c1);
+		__m128 rowE2 = _mm_set1_ps((b2 * pixelY) + c2);
+		__m128 rowDepth = _mm_set1_ps((depthDY * pixelY) + depthC);
+
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, pixelX), rowE0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, pixelX), rowE1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, pixelX), rowE2);
+
+			__m128 inside = _mm_and_ps(
+				_mm_cmpge_ps(e0, zero),
+				_mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(stepDepth, pixelX), rowDepth);
+			__m128 current = _mm_loadu_ps(row + x);
+			__m128 nearer = _mm_min_ps(current, depth);
+
+			// only pixels inside the triangle take the new depth
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; y++)
+	{
+		float pixelY = y + 0.5f;
+		float* row = &m_depth[static_cast<size_t>(y) * m_width];
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			float pixelX = x + 0.5f;
+
+			if (((a0 * pixelX) + (b0 * pixelY) + c0 < 0.0f) ||
+				((a1 * pixelX) + (b1 * pixelY) + c1 < 0.0f) ||
+				((a2 * pixelX) + (b2 * pixelY) + c2 < 0.0f))
+			{
+				continue;
+			}
+
+			float depth = (depthDX * pixelX) + (depthDY * pixelY) + depthC;
+			row[x] = glm::min(row[x], depth);
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  TestBox()
+ *
+ *  This method is used for checking a candidate object. The
+ *  box is reduced to its screen rectangle and nearest depth,
+ *  which is conservative: the object is kept if any pixel in
+ *  the rectangle is farther away than its nearest point.
+ ***********************************************************/
+bool OcclusionBuffer::TestBox(
+	const glm::mat4& viewProjection,
+	const glm::vec3& minXYZ,
+	const glm::vec3& maxXYZ) const
+{
+	if (m_depth.empty())
+	{
+		return true;
+	}
+
+	glm::vec3 screenMin(1.0e30f);
+	glm::vec3 screenMax(-1.0e30f);
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 clipPosition = viewProjection * glm::vec4(BoxCorner(minXYZ, maxXYZ, corner), 1.0f);
+
+		// a box crossing the near plane surrounds the camera, keep it
+		if (clipPosition.w < g_NearClipW)
+		{
+			return true;
+		}
+
+		glm::vec3 screen = ClipToScreen(clipPosition);
+		screenMin = glm::min(screenMin, screen);
+		screenMax = glm::max(screenMax, screen);
+	}
+
+	int minX = std::max(static_cast<int>(floorf(screenMin.x)), 0);
+	int maxX = std::min(static_cast<int>(ceilf(screenMax.x)), m_width - 1);
+	int minY = std::max(static_cast<int>(floorf(screenMin.y)), 0);
+	int maxY = std::min(static_cast<int>(ceilf(screenMax.y)), m_height - 1);
+
+	// off screen boxes were already handled by frustum culling
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return true;
+	}
+
+	float nearestDepth = screenMin.z;
+
+#ifdef OCCLUSIONBUFFER_USE_SSE
+	const __m128 nearest = _mm_set1_ps(nearestDepth);
+	int alignedMinX = minX & ~3;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		const float* row = &m_depth[static_cast<size_t>(y) * m_width];
+
+		for (int x = alignedMinX; x <= maxX; x += 4)
+		{
+			__m128 farther = _mm_cmplt_ps(nearest, _mm_loadu_ps(row + x));
+			int mask = _mm_movemask_ps(farther);
+
+			// drop lanes left of the rectangle or past its right edge
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int pixelX = x + lane;
+				if ((pixelX < minX) || (pixelX > maxX))
+				{
+					mask &= ~(1 << lane);
+				}
+			}
+
+			if (mask != 0)
+			{
+				return true;
+			}
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; y++)
+	{
+		const float* row = &m_depth[static_cast<size_t>(y) * m_width];
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			if (nearestDepth < row[x])
+			{
+				return true;
+			}
+		}
+	}
+#endif
+
+	return false;
+}
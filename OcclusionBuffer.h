@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////
+// OcclusionBuffer.h
+// =================
+// low resolution CPU depth buffer for occlusion culling
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  OcclusionBuffer
+ *
+ *  A few large occluders are rasterized into a small depth
+ *  buffer on the CPU each frame, then the screen rectangle of
+ *  each candidate object's box is checked against it. An
+ *  object is hidden only when every covered pixel already
+ *  holds something nearer than the object's nearest point.
+ ***********************************************************/
+class OcclusionBuffer
+{
+public:
+	OcclusionBuffer();
+
+	// set the buffer size; the width is rounded up to a multiple of 4
+	void Initialize(int width, int height);
+	// reset every pixel to the far plane
+	void Clear();
+
+	// draw the faces of an object space box as an occluder
+	void RasterizeBox(
+		const glm::mat4& modelViewProjection,
+		const glm::vec3& minXYZ,
+		const glm::vec3& maxXYZ);
+
+	// true if any part of the world space box may be visible
+	bool TestBox(
+		const glm::mat4& viewProjection,
+		const glm::vec3& minXYZ,
+		const glm::vec3& maxXYZ) const;
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	const float* GetDepthData() const { return m_depth.data(); }
+
+private:
+	int m_width;
+	int m_height;
+	// depth of the nearest occluder per pixel, 0 near to 1 far
+	std::vector<float> m_depth;
+
+	// clip a clip space triangle against the near plane and rasterize it
+	void ClipAndRasterize(const glm::vec4 clipVertices[3]);
+	// rasterize a triangle with x, y in pixels and z as depth
+	void RasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+	// convert a clip space position to pixel x, y and 0..1 depth
+	glm::vec3 ClipToScreen(const glm::vec4& clipPosition) const;
+};
@@ -0,0 +1,531 @@
+/////////////////////////////////////////////////////////////////////////////////
+// PerfOverlay.cpp
+// ===============
+// on-screen performance HUD drawn over the rendered scene
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "PerfOverlay.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+	// size of a glyph cell in font pixels, and the pixels per font pixel
+	const int g_GlyphColumns = 5;
+	const int g_GlyphRows = 7;
+	const float g_TextScale = 2.0f;
+	const float g_GlyphAdvance = (g_GlyphColumns + 1) * g_TextScale;
+	const float g_LineHeight = (g_GlyphRows + 3) * g_TextScale;
+
+	// layout of the HUD panel in pixels from the top left
+	const float g_PanelMargin = 8.0f;
+	const float g_PanelPadding = 8.0f;
+	const float g_GraphBarWidth = 2.0f;
+	const float g_GraphHeight = 60.0f;
+	// frame time at the top of the graph, and the budget line drawn in it
+	const double g_GraphMaxMilliseconds = 33.3;
+	const double g_FrameBudgetMilliseconds = 16.7;
+	// weight of the newest frame in the smoothed CPU pass times
+	const double g_AverageWeight = 0.1;
+
+	const glm::vec4 g_PanelColor(0.0f, 0.0f, 0.0f, 0.6f);
+	const glm::vec4 g_TextColor(1.0f, 1.0f, 1.0f, 1.0f);
+	const glm::vec4 g_LabelColor(0.6f, 0.8f, 1.0f, 1.0f);
+	const glm::vec4 g_FastColor(0.3f, 0.9f, 0.3f, 1.0f);
+	const glm::vec4 g_SlowColor(0.95f, 0.8f, 0.2f, 1.0f);
+	const glm::vec4 g_MissedColor(0.95f, 0.3f, 0.25f, 1.0f);
+	const glm::vec4 g_BudgetLineColor(1.0f, 1.0f, 1.0f, 0.35f);
+
+	// 5x7 glyph rows, top row first; bit 4 is the leftmost column
+	struct GLYPH_DEFINITION
+	{
+		char character;
+		uint8_t rows[g_GlyphRows];
+	};
+
+	const GLYPH_DEFINITION g_FontGlyphs[] =
+	{
+		{ '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+		{ '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+		{ ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+		{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+		{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+		{ '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+		{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+		{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+		{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+		{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+		{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+		{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+		{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+		{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+		{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+		{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+		{ 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+		{ 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+		{ 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+		{ 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+		{ 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+		{ 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+		{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+		{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+		{ 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+		{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+		{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+		{ 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+		{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+		{ 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+		{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+		{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+		{ 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+		{ 'Y', { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 } },
+		{ 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+	};
+
+	// bitmaps indexed by character, with bit (row * 5 + column) set for lit pixels
+	uint64_t g_GlyphBits[128] = {};
+	// every bit set, for solid rectangles
+	const uint64_t g_SolidBits = (1ull << (g_GlyphColumns * g_GlyphRows)) - 1;
+
+	const char* g_OverlayVertexShader =
+		"#version 330 core\n"
+		"layout(location = 0) in vec2 corner;\n"
+		"layout(location = 1) in vec4 rect;\n"
+		"layout(location = 2) in vec4 color;\n"
+		"layout(location = 3) in uvec2 glyphBits;\n"
+		"uniform vec2 viewportSize;\n"
+		"out vec2 glyphPosition;\n"
+		"out vec4 quadColor;\n"
+		"flat out uvec2 quadGlyphBits;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 pixel = rect.xy + corner * rect.zw;\n"
+		"	gl_Position = vec4(pixel.x / viewportSize.x * 2.0 - 1.0, 1.0 - pixel.y / viewportSize.y * 2.0, 0.0, 1.0);\n"
+		"	glyphPosition = corner * vec2(5.0, 7.0);\n"
+		"	quadColor = color;\n"
+		"	quadGlyphBits = glyphBits;\n"
+		"}\n";
+
+	const char* g_OverlayFragmentShader =
+		"#version 330 core\n"
+		"in vec2 glyphPosition;\n"
+		"in vec4 quadColor;\n"
+		"flat in uvec2 quadGlyphBits;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	int column = clamp(int(glyphPosition.x), 0, 4);\n"
+		"	int row = clamp(int(glyphPosition.y), 0, 6);\n"
+		"	int bit = row * 5 + column;\n"
+		"	uint word = (bit < 32) ? quadGlyphBits.x : quadGlyphBits.y;\n"
+		"	if (((word >> uint(bit & 31)) & 1u) == 0u)\n"
+		"	{\n"
+		"		discard;\n"
+		"	}\n"
+		"	fragmentColor = quadColor;\n"
+		"}\n";
+
+	/***********************************************************
+	 *  BuildGlyphBits()
+	 ***********************************************************/
+	void BuildGlyphBits()
+	{
+		for (size_t i = 0; i < sizeof(g_FontGlyphs) / sizeof(g_FontGlyphs[0]); i++)
+		{
+			uint64_t bits = 0;
+			for (int row = 0; row < g_GlyphRows; row++)
+			{
+				for (int column = 0; column < g_GlyphColumns; column++)
+				{
+					if (g_FontGlyphs[i].rows[row] & (0x10 >> column))
+					{
+						bits |= 1ull << (row * g_GlyphColumns + column);
+					}
+				}
+			}
+			g_GlyphBits[(int)g_FontGlyphs[i].character] = bits;
+		}
+	}
+
+	/***********************************************************
+	 *  CompileShader()
+	 ***********************************************************/
+	GLuint CompileShader(GLenum shaderType, const char* source)
+	{
+		GLuint shaderID = glCreateShader(shaderType);
+		glShaderSource(shaderID, 1, &source, NULL);
+		glCompileShader(shaderID);
+
+		GLint success = 0;
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[512];
+			glGetShaderInfoLog(shaderID, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Overlay shader compile failed: " << infoLog << std::endl;
+			glDeleteShader(shaderID);
+			return 0;
+		}
+
+		return shaderID;
+	}
+
+	/***********************************************************
+	 *  FrameTimeColor()
+	 ***********************************************************/
+	const glm::vec4& FrameTimeColor(double milliseconds)
+	{
+		if (milliseconds <= g_FrameBudgetMilliseconds)
+		{
+			return g_FastColor;
+		}
+		if (milliseconds <= g_FrameBudgetMilliseconds * 2.0)
+		{
+			return g_SlowColor;
+		}
+		return g_MissedColor;
+	}
+}
+
+/***********************************************************
+ *  PerfOverlay()
+ ***********************************************************/
+PerfOverlay::PerfOverlay()
+	: m_programID(0),
+	m_vao(0),
+	m_cornerBuffer(0),
+	m_instanceBuffer(0),
+	m_viewportSizeLocation(-1),
+	m_instanceCapacity(0),
+	m_nextFrameTime(0),
+	m_frameTimeCount(0),
+	m_cpuPassCount(0)
+{
+	for (int i = 0; i < GRAPH_SAMPLES; i++)
+	{
+		m_frameTimes[i] = 0.0;
+	}
+}
+
+/***********************************************************
+ *  ~PerfOverlay()
+ ***********************************************************/
+PerfOverlay::~PerfOverlay()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the overlay program and
+ *  setting up the vertex array: attribute 0 is the corner of
+ *  the unit quad, and attributes 1 to 3 advance once per quad.
+ ***********************************************************/
+bool PerfOverlay::Initialize()
+{
+	if (m_programID != 0)
+	{
+		return true;
+	}
+
+	BuildGlyphBits();
+
+	if (CreateProgram() == false)
+	{
+		return false;
+	}
+
+	const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_cornerBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_cornerBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glGenBuffers(1, &m_instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	GLsizei stride = sizeof(OVERLAY_QUAD);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(OVERLAY_QUAD, rect));
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(OVERLAY_QUAD, color));
+	glVertexAttribIPointer(3, 2, GL_UNSIGNED_INT, stride, (void*)offsetof(OVERLAY_QUAD, glyphBits));
+	for (GLuint attribute = 1; attribute <= 3; attribute++)
+	{
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return (glGetError() == GL_NO_ERROR);
+}
+
+/***********************************************************
+ *  Destroy()
+ ***********************************************************/
+void PerfOverlay::Destroy()
+{
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		glDeleteBuffers(1, &m_cornerBuffer);
+		glDeleteBuffers(1, &m_instanceBuffer);
+		glDeleteVertexArrays(1, &m_vao);
+		m_programID = 0;
+		m_instanceCapacity = 0;
+	}
+}
+
+/***********************************************************
+ *  CreateProgram()
+ ***********************************************************/
+bool PerfOverlay::CreateProgram()
+{
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, g_OverlayVertexShader);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, g_OverlayFragmentShader);
+
+	if ((vertexShader == 0) || (fragmentShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return false;
+	}
+
+	m_programID = glCreateProgram();
+	glAttachShader(m_programID, vertexShader);
+	glAttachShader(m_programID, fragmentShader);
+	glLinkProgram(m_programID);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint success = 0;
+	glGetProgramiv(m_programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[512];
+		glGetProgramInfoLog(m_programID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Overlay shader link failed: " << infoLog << std::endl;
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+		return false;
+	}
+
+	m_viewportSizeLocation = glGetUniformLocation(m_programID, "viewportSize");
+	return true;
+}
+
+/***********************************************************
+ *  AddFrameTime()
+ ***********************************************************/
+void PerfOverlay::AddFrameTime(double frameMilliseconds)
+{
+	m_frameTimes[m_nextFrameTime] = frameMilliseconds;
+	m_nextFrameTime = (m_nextFrameTime + 1) % GRAPH_SAMPLES;
+	if (m_frameTimeCount < GRAPH_SAMPLES)
+	{
+		m_frameTimeCount++;
+	}
+}
+
+/***********************************************************
+ *  SetCpuPassTime()
+ ***********************************************************/
+void PerfOverlay::SetCpuPassTime(const char* passName, double milliseconds)
+{
+	for (int i = 0; i < m_cpuPassCount; i++)
+	{
+		if (m_cpuPasses[i].name == passName)
+		{
+			m_cpuPasses[i].milliseconds += (milliseconds - m_cpuPasses[i].milliseconds) * g_AverageWeight;
+			return;
+		}
+	}
+
+	if (m_cpuPassCount < MAX_CPU_PASSES)
+	{
+		m_cpuPasses[m_cpuPassCount].name = passName;
+		m_cpuPasses[m_cpuPassCount].milliseconds = milliseconds;
+		m_cpuPassCount++;
+	}
+}
+
+/***********************************************************
+ *  AddQuad()
+ ***********************************************************/
+void PerfOverlay::AddQuad(float x, float y, float width, float height, const glm::vec4& color)
+{
+	OVERLAY_QUAD quad;
+	quad.rect = glm::vec4(x, y, width, height);
+	quad.color = color;
+	quad.glyphBits[0] = (uint32_t)g_SolidBits;
+	quad.glyphBits[1] = (uint32_t)(g_SolidBits >> 32);
+	m_quads.push_back(quad);
+}
+
+/***********************************************************
+ *  AddText()
+ ***********************************************************/
+float PerfOverlay::AddText(float x, float y, const std::string& text, const glm::vec4& color)
+{
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		int character = toupper((unsigned char)text[i]);
+		uint64_t bits = (character < 128) ? g_GlyphBits[character] : 0;
+
+		if (bits != 0)
+		{
+			OVERLAY_QUAD quad;
+			quad.rect = glm::vec4(x, y, g_GlyphColumns * g_TextScale, g_GlyphRows * g_TextScale);
+			quad.color = color;
+			quad.glyphBits[0] = (uint32_t)bits;
+			quad.glyphBits[1] = (uint32_t)(bits >> 32);
+			m_quads.push_back(quad);
+		}
+		x += g_GlyphAdvance;
+	}
+
+	return x;
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for laying out the HUD into quads on
+ *  the CPU, uploading them into the instance buffer and
+ *  drawing them with one instanced call. The shader program,
+ *  blending and depth test are put back the way they were
+ *  afterwards, so the next scene frame still blends its
+ *  translucent objects and its uniforms reach its shader.
+ ***********************************************************/
+void PerfOverlay::Render(
+	int viewportWidth,
+	int viewportHeight,
+	const RENDER_STATS& stats,
+	const GpuTimer* pGpuTimer)
+{
+	if ((m_programID == 0) || (viewportWidth <= 0) || (viewportHeight <= 0))
+	{
+		return;
+	}
+
+	m_quads.clear();
+
+	// reserve the background first so it is drawn under the rest
+	float panelX = g_PanelMargin;
+	float panelY = g_PanelMargin;
+	float panelWidth = GRAPH_SAMPLES * g_GraphBarWidth + g_PanelPadding * 2.0f;
+	AddQuad(panelX, panelY, panelWidth, 0.0f, g_PanelColor);
+
+	float x = panelX + g_PanelPadding;
+	float y = panelY + g_PanelPadding;
+	char text[64];
+
+	// average frame time and FPS over the graph history
+	double totalMilliseconds = 0.0;
+	for (int i = 0; i < m_frameTimeCount; i++)
+	{
+		totalMilliseconds += m_frameTimes[i];
+	}
+	double averageMilliseconds = (m_frameTimeCount > 0) ? totalMilliseconds / m_frameTimeCount : 0.0;
+	double framesPerSecond = (averageMilliseconds > 0.0) ? 1000.0 / averageMilliseconds : 0.0;
+
+	snprintf(text, sizeof(text), "%.1f FPS  %.2f MS", framesPerSecond, averageMilliseconds);
+	AddText(x, y, text, FrameTimeColor(averageMilliseconds));
+	y += g_LineHeight;
+
+	// frame time graph, oldest sample on the left
+	float graphBottom = y + g_GraphHeight;
+	for (int i = 0; i < m_frameTimeCount; i++)
+	{
+		int sample = (m_nextFrameTime - m_frameTimeCount + i + GRAPH_SAMPLES) % GRAPH_SAMPLES;
+		double milliseconds = m_frameTimes[sample];
+		float barHeight = (float)(std::min(milliseconds / g_GraphMaxMilliseconds, 1.0) * g_GraphHeight);
+		AddQuad(x + i * g_GraphBarWidth, graphBottom - barHeight, g_GraphBarWidth, barHeight, FrameTimeColor(milliseconds));
+	}
+	float budgetY = graphBottom - (float)(g_FrameBudgetMilliseconds / g_GraphMaxMilliseconds) * g_GraphHeight;
+	AddQuad(x, budgetY, GRAPH_SAMPLES * g_GraphBarWidth, 1.0f, g_BudgetLineColor);
+	y = graphBottom + g_LineHeight * 0.5f;
+
+	snprintf(text, sizeof(text), "%llu", (unsigned long long)stats.drawCalls);
+	AddText(AddText(x, y, "DRAWS ", g_LabelColor), y, text, g_TextColor);
+	y += g_LineHeight;
+	snprintf(text, sizeof(text), "%llu", (unsigned long long)stats.triangles);
+	AddText(AddText(x, y, "TRIS  ", g_LabelColor), y, text, g_TextColor);
+	y += g_LineHeight;
+
+	for (int i = 0; i < m_cpuPassCount; i++)
+	{
+		snprintf(text, sizeof(text), "%-7s %6.3f MS", m_cpuPasses[i].name, m_cpuPasses[i].milliseconds);
+		AddText(AddText(x, y, "CPU ", g_LabelColor), y, text, g_TextColor);
+		y += g_LineHeight;
+	}
+
+	if (NULL != pGpuTimer)
+	{
+		for (int i = 0; i < pGpuTimer->GetPassCount(); i++)
+		{
+			snprintf(text, sizeof(text), "%-7s %6.3f MS", pGpuTimer->GetPassName(i), pGpuTimer->GetAveragePassMilliseconds(i));
+			AddText(AddText(x, y, "GPU ", g_LabelColor), y, text, g_TextColor);
+			y += g_LineHeight;
+		}
+	}
+
+	m_quads[0].rect.w = y - panelY + g_PanelPadding - (g_LineHeight - g_GlyphRows * g_TextScale);
+
+	// upload the quads, growing the buffer only when it is too small
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (m_quads.size() > m_instanceCapacity)
+	{
+		m_instanceCapacity = m_quads.size() * 2;
+		glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(OVERLAY_QUAD), NULL, GL_STREAM_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_quads.size() * sizeof(OVERLAY_QUAD), m_quads.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	RenderStats::AddUploadBytes(m_quads.size() * sizeof(OVERLAY_QUAD));
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	GLboolean bBlendWasEnabled = glIsEnabled(GL_BLEND);
+	GLboolean bDepthTestWasEnabled = glIsEnabled(GL_DEPTH_TEST);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(m_programID);
+	glUniform2f(m_viewportSizeLocation, (float)viewportWidth, (float)viewportHeight);
+	RenderStats::AddUniformUpdates(1);
+
+	glBindVertexArray(m_vao);
+	RenderStats::AddVertexArrayBind();
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m_quads.size());
+	RenderStats::AddInstancedDrawCall(GL_TRIANGLE_STRIP, 4, (GLsizei)m_quads.size());
+	glBindVertexArray(0);
+
+	if (bBlendWasEnabled == GL_FALSE)
+	{
+		glDisable(GL_BLEND);
+	}
+	if (bDepthTestWasEnabled == GL_TRUE)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	glUseProgram((GLuint)previousProgram);
+}
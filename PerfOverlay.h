@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////
+// PerfOverlay.h
+// =============
+// on-screen performance HUD drawn over the rendered scene
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GpuTimer.h"
+#include "RenderStats.h"
+
+/***********************************************************
+ *  PerfOverlay
+ *
+ *  Shows a frame time graph, FPS, the render counters and the
+ *  CPU and GPU pass times. Every glyph and bar is one instance
+ *  of a unit quad; each glyph carries its 5x7 bitmap in the
+ *  instance data, so the whole HUD is one instanced draw with
+ *  no texture.
+ ***********************************************************/
+class PerfOverlay
+{
+public:
+	PerfOverlay();
+	~PerfOverlay();
+
+	// compile the overlay shaders and create the quad buffers
+	bool Initialize();
+	void Destroy();
+
+	// add the CPU time of the last frame to the graph
+	void AddFrameTime(double frameMilliseconds);
+	// set the CPU time of a named pass for the last frame; passes are
+	// matched by name pointer, so pass the same string literal each frame
+	void SetCpuPassTime(const char* passName, double milliseconds);
+
+	// draw the HUD over the current framebuffer
+	void Render(
+		int viewportWidth,
+		int viewportHeight,
+		const RENDER_STATS& stats,
+		const GpuTimer* pGpuTimer);
+
+private:
+	// one instance: pixel rectangle, color and glyph bitmap
+	struct OVERLAY_QUAD
+	{
+		glm::vec4 rect;
+		glm::vec4 color;
+		uint32_t glyphBits[2];
+	};
+
+	struct CPU_PASS_TIME
+	{
+		const char* name;
+		double milliseconds;
+	};
+
+	static const int MAX_CPU_PASSES = 8;
+	static const int GRAPH_SAMPLES = 120;
+
+	GLuint m_programID;
+	GLuint m_vao;
+	GLuint m_cornerBuffer;
+	GLuint m_instanceBuffer;
+	GLint m_viewportSizeLocation;
+	// instances the instance buffer has room for
+	size_t m_instanceCapacity;
+
+	std::vector<OVERLAY_QUAD> m_quads;
+
+	// ring of recent frame times for the graph
+	double m_frameTimes[GRAPH_SAMPLES];
+	int m_nextFrameTime;
+	int m_frameTimeCount;
+
+	CPU_PASS_TIME m_cpuPasses[MAX_CPU_PASSES];
+	int m_cpuPassCount;
+
+	// append a solid rectangle
+	void AddQuad(float x, float y, float width, float height, const glm::vec4& color);
+	// append the glyphs of a line of text, returning the x after it
+	float AddText(float x, float y, const std::string& text, const glm::vec4& color);
+	// compile and link the embedded overlay shaders
+	bool CreateProgram();
+};
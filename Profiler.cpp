@@ -0,0 +1,250 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Profiler.cpp
+// ============
+// scoped CPU timing markers with Chrome trace export
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// events kept per thread; a power of two so the ring index wraps with a mask.
+	// Once a thread fills its ring, each new event overwrites its oldest one
+	const size_t g_EventsPerThread = 1 << 16;
+
+	struct PROFILE_EVENT
+	{
+		const char* name;
+		uint64_t startTime;
+		uint64_t endTime;
+	};
+
+	// written only by its own thread; count is every event ever recorded, and the
+	// trace writer reads the last g_EventsPerThread of them from the ring
+	struct THREAD_BUFFER
+	{
+		std::atomic<size_t> count;
+		uint32_t threadID;
+		std::string threadName;
+		PROFILE_EVENT events[g_EventsPerThread];
+	};
+
+	std::atomic<bool> g_bProfilerEnabled(false);
+	const std::chrono::steady_clock::time_point g_ProfilerStartTime = std::chrono::steady_clock::now();
+
+	// every buffer ever registered; kept after its thread exits so the events survive
+	std::mutex g_ThreadBuffersMutex;
+	std::vector<std::unique_ptr<THREAD_BUFFER>> g_ThreadBuffers;
+
+	thread_local THREAD_BUFFER* t_pThreadBuffer = nullptr;
+
+	/***********************************************************
+	 *  GetThreadBuffer()
+	 *
+	 *  Returns the calling thread's buffer, registering a new one
+	 *  the first time the thread records an event.
+	 ***********************************************************/
+	THREAD_BUFFER* GetThreadBuffer()
+	{
+		if (NULL == t_pThreadBuffer)
+		{
+			std::unique_ptr<THREAD_BUFFER> buffer(new THREAD_BUFFER());
+			buffer->count.store(0);
+
+			std::lock_guard<std::mutex> lock(g_ThreadBuffersMutex);
+			buffer->threadID = (uint32_t)g_ThreadBuffers.size() + 1;
+			t_pThreadBuffer = buffer.get();
+			g_ThreadBuffers.push_back(std::move(buffer));
+		}
+
+		return t_pThreadBuffer;
+	}
+
+	/***********************************************************
+	 *  WriteJSONString()
+	 ***********************************************************/
+	void WriteJSONString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if ((*c == '"') || (*c == '\\'))
+			{
+				fputc('\\', file);
+			}
+			fputc(*c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+/***********************************************************
+ *  SetEnabled()
+ ***********************************************************/
+void Profiler::SetEnabled(bool bEnabled)
+{
+	g_bProfilerEnabled.store(bEnabled, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  IsEnabled()
+ ***********************************************************/
+bool Profiler::IsEnabled()
+{
+	return g_bProfilerEnabled.load(std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  SetThreadName()
+ ***********************************************************/
+void Profiler::SetThreadName(const char* threadName)
+{
+	THREAD_BUFFER* buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(g_ThreadBuffersMutex);
+	buffer->threadName = threadName;
+}
+
+/***********************************************************
+ *  Now()
+ ***********************************************************/
+uint64_t Profiler::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - g_ProfilerStartTime).count();
+}
+
+/***********************************************************
+ *  RecordEvent()
+ *
+ *  This method is used for appending an event to the calling
+ *  thread's ring, overwriting its oldest event once the ring
+ *  is full, so a long run keeps its latest frames. The count
+ *  is published with release order after the event is
+ *  written, so the trace writer never sees a half written
+ *  new event.
+ ***********************************************************/
+void Profiler::RecordEvent(const char* eventName, uint64_t startTime, uint64_t endTime)
+{
+	if (IsEnabled() == false)
+	{
+		return;
+	}
+
+	THREAD_BUFFER* buffer = GetThreadBuffer();
+	size_t count = buffer->count.load(std::memory_order_relaxed);
+	PROFILE_EVENT& event = buffer->events[count & (g_EventsPerThread - 1)];
+
+	event.name = eventName;
+	event.startTime = startTime;
+	event.endTime = endTime;
+	buffer->count.store(count + 1, std::memory_order_release);
+}
+
+/***********************************************************
+ *  WriteChromeTrace()
+ *
+ *  This method is used for writing the recorded events as
+ *  complete ("X") events with microsecond times, plus one
+ *  metadata event naming each thread. Recording is turned off
+ *  first, so no thread overwrites the ring while it is read;
+ *  the events each full ring lost are counted and reported.
+ ***********************************************************/
+bool Profiler::WriteChromeTrace(const char* filename)
+{
+	SetEnabled(false);
+
+	FILE* file = fopen(filename, "w");
+	if (NULL == file)
+	{
+		std::cout << "Could not open trace file: " << filename << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_ThreadBuffersMutex);
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	bool bFirstEvent = true;
+	size_t totalEvents = 0;
+	size_t totalOverwritten = 0;
+
+	for (size_t i = 0; i < g_ThreadBuffers.size(); i++)
+	{
+		const THREAD_BUFFER& buffer = *g_ThreadBuffers[i];
+		size_t recordedCount = buffer.count.load(std::memory_order_acquire);
+		size_t firstEvent = (recordedCount > g_EventsPerThread) ? (recordedCount - g_EventsPerThread) : 0;
+
+		// the thread name metadata event
+		std::string threadName = buffer.threadName;
+		if (threadName.empty())
+		{
+			threadName = "thread " + std::to_string(buffer.threadID);
+		}
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+			bFirstEvent ? "" : ",\n", buffer.threadID);
+		WriteJSONString(file, threadName.c_str());
+		fprintf(file, "}}");
+		bFirstEvent = false;
+
+		// oldest kept event first
+		for (size_t e = firstEvent; e < recordedCount; e++)
+		{
+			const PROFILE_EVENT& event = buffer.events[e & (g_EventsPerThread - 1)];
+			fprintf(file, ",\n{\"name\":");
+			WriteJSONString(file, event.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer.threadID,
+				event.startTime / 1000.0,
+				(event.endTime - event.startTime) / 1000.0);
+		}
+
+		totalEvents += recordedCount - firstEvent;
+		totalOverwritten += firstEvent;
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	std::cout << "INFO: Wrote " << totalEvents << " trace events to " << filename;
+	if (totalOverwritten > 0)
+	{
+		std::cout << " (" << totalOverwritten << " oldest overwritten, buffers full)";
+	}
+	std::cout << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  ProfileScope()
+ ***********************************************************/
+ProfileScope::ProfileScope(const char* eventName)
+	: m_eventName(eventName),
+	m_startTime(0)
+{
+	if (Profiler::IsEnabled())
+	{
+		m_startTime = Profiler::Now();
+	}
+}
+
+/***********************************************************
+ *  ~ProfileScope()
+ ***********************************************************/
+ProfileScope::~ProfileScope()
+{
+	if (Profiler::IsEnabled() && (m_startTime != 0))
+	{
+		Profiler::RecordEvent(m_eventName, m_startTime, Profiler::Now());
+	}
+}
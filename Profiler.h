@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Profiler.h
+// ==========
+// scoped CPU timing markers with Chrome trace export
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+/***********************************************************
+ *  Profiler
+ *
+ *  Timing events are appended to a fixed size ring owned by
+ *  the thread that records them, so recording takes no lock;
+ *  a full ring overwrites its oldest events.
+ *  Each thread registers its buffer once, the first time it
+ *  records anything. When the profiler is disabled a marker
+ *  costs one relaxed atomic load.
+ ***********************************************************/
+class Profiler
+{
+public:
+	// turn event recording on or off for every thread
+	static void SetEnabled(bool bEnabled);
+	static bool IsEnabled();
+
+	// name shown for the calling thread in the trace
+	static void SetThreadName(const char* threadName);
+
+	// nanoseconds since the profiler clock started
+	static uint64_t Now();
+	// record a finished event; the name must stay valid until the trace is written
+	static void RecordEvent(const char* eventName, uint64_t startTime, uint64_t endTime);
+
+	// stop recording and write the events still in the rings in the Chrome
+	// trace event JSON format, which chrome://tracing and ui.perfetto.dev both open
+	static bool WriteChromeTrace(const char* filename);
+};
+
+/***********************************************************
+ *  ProfileScope
+ *
+ *  Records one event covering the lifetime of the object.
+ ***********************************************************/
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* eventName);
+	~ProfileScope();
+
+private:
+	const char* m_eventName;
+	uint64_t m_startTime;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// time the rest of the enclosing block under the given name
+#define PROFILE_SCOPE(eventName) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(eventName)
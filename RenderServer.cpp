@@ -0,0 +1,599 @@
+/////////////////////////////////////////////////////////////////////////////////
+// RenderServer.cpp
+// ================
+// long-running render worker processes taking jobs over a Unix domain socket
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderServer.h"
+#include "BatchRenderer.h"
+#include "Profiler.h"
+#include "TiledRenderer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+#include "GLFW/glfw3.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// set by SIGINT or SIGTERM; blocking calls return early so the loops can see it
+	volatile sig_atomic_t g_bStopServer = 0;
+	// a worker that exits sooner than this after starting is not restarted
+	const time_t g_MinWorkerLifetimeSeconds = 2;
+	// largest side of a software rendered job; the color and depth buffers are
+	// held whole, so an unchecked size from the socket could exhaust the worker
+	const int g_MaxSoftwareImageSize = 8192;
+
+	/***********************************************************
+	 *  OnStopSignal()
+	 ***********************************************************/
+	void OnStopSignal(int)
+	{
+		g_bStopServer = 1;
+	}
+
+#ifndef _WIN32
+	/***********************************************************
+	 *  SetStopHandlers()
+	 *
+	 *  The handlers are installed without SA_RESTART so accept,
+	 *  recv and waitpid are interrupted rather than resumed.
+	 ***********************************************************/
+	void SetStopHandlers()
+	{
+		struct sigaction action = {};
+		action.sa_handler = OnStopSignal;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGINT, &action, NULL);
+		sigaction(SIGTERM, &action, NULL);
+	}
+
+	/***********************************************************
+	 *  SendReply()
+	 ***********************************************************/
+	bool SendReply(int clientSocket, const std::string& reply)
+	{
+		std::string line = reply + "\n";
+		size_t sent = 0;
+		while (sent < line.size())
+		{
+			ssize_t result = send(clientSocket, line.data() + sent, line.size() - sent, 0);
+			if (result < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			sent += (size_t)result;
+		}
+		return true;
+	}
+#endif
+}
+
+/***********************************************************
+ *  RenderServer()
+ ***********************************************************/
+RenderServer::RenderServer()
+	: m_listenSocket(-1),
+	m_workerIndex(0),
+	m_framebuffer(0),
+	m_colorBuffer(0),
+	m_depthBuffer(0),
+	m_targetWidth(0),
+	m_targetHeight(0),
+	m_pSoftwareRasterizer(NULL)
+{
+}
+
+/***********************************************************
+ *  ~RenderServer()
+ ***********************************************************/
+RenderServer::~RenderServer()
+{
+	DestroyTarget();
+
+#ifndef _WIN32
+	if (m_listenSocket >= 0)
+	{
+		close(m_listenSocket);
+		m_listenSocket = -1;
+	}
+#endif
+}
+
+/***********************************************************
+ *  Listen()
+ *
+ *  This method is used for creating the listening socket. A
+ *  socket file left behind by a server that is gone is
+ *  replaced, but one that still accepts connections is not.
+ ***********************************************************/
+bool RenderServer::Listen(const char* socketPath)
+{
+#ifdef _WIN32
+	std::cout << "The render server needs Unix domain sockets and fork(), which this platform does not provide" << std::endl;
+	return false;
+#else
+	struct sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		std::cout << "Render server socket path is too long: " << socketPath << std::endl;
+		return false;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listenSocket < 0)
+	{
+		std::cout << "Could not create the render server socket" << std::endl;
+		return false;
+	}
+
+	// a successful connection means another server owns the path
+	if (connect(m_listenSocket, (const struct sockaddr*)&address, sizeof(address)) == 0)
+	{
+		std::cout << "A render server is already listening on " << socketPath << std::endl;
+		close(m_listenSocket);
+		m_listenSocket = -1;
+		return false;
+	}
+	close(m_listenSocket);
+	unlink(socketPath);
+
+	m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if ((m_listenSocket < 0) ||
+		(bind(m_listenSocket, (const struct sockaddr*)&address, sizeof(address)) != 0) ||
+		(listen(m_listenSocket, SOMAXCONN) != 0))
+	{
+		std::cout << "Could not listen on render server socket: " << socketPath << std::endl;
+		if (m_listenSocket >= 0)
+		{
+			close(m_listenSocket);
+			m_listenSocket = -1;
+		}
+		return false;
+	}
+
+	m_socketPath = socketPath;
+	return true;
+#endif
+}
+
+/***********************************************************
+ *  ForkWorkers()
+ *
+ *  This method is used for starting the worker processes and
+ *  then supervising them. It must run before GLFW is set up,
+ *  since a window system connection or GL context cannot be
+ *  shared across fork(). A worker that dies is replaced,
+ *  unless it died while starting up, which would only repeat.
+ ***********************************************************/
+bool RenderServer::ForkWorkers(int workerCount)
+{
+#ifdef _WIN32
+	return false;
+#else
+	if ((m_listenSocket < 0) || (workerCount < 1))
+	{
+		return false;
+	}
+
+	SetStopHandlers();
+
+	std::vector<pid_t> workers(workerCount, 0);
+	std::vector<time_t> startTimes(workerCount, 0);
+
+	std::cout << "INFO: Render server listening on " << m_socketPath << " with "
+		<< workerCount << " worker" << ((workerCount == 1) ? "" : "s") << std::endl;
+
+	while (g_bStopServer == 0)
+	{
+		for (int i = 0; i < workerCount; i++)
+		{
+			if (workers[i] != 0)
+			{
+				continue;
+			}
+
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				m_workerIndex = i + 1;
+				signal(SIGPIPE, SIG_IGN);
+				return true;
+			}
+			if (pid < 0)
+			{
+				std::cout << "Could not start render worker " << i + 1 << std::endl;
+				g_bStopServer = 1;
+				break;
+			}
+
+			workers[i] = pid;
+			startTimes[i] = time(NULL);
+		}
+
+		int status = 0;
+		pid_t exitedPid = waitpid(-1, &status, 0);
+		if (exitedPid <= 0)
+		{
+			continue;
+		}
+
+		for (int i = 0; i < workerCount; i++)
+		{
+			if (workers[i] == exitedPid)
+			{
+				workers[i] = 0;
+				if (time(NULL) - startTimes[i] < g_MinWorkerLifetimeSeconds)
+				{
+					std::cout << "Render worker " << i + 1 << " exited while starting, stopping the server" << std::endl;
+					g_bStopServer = 1;
+				}
+				else
+				{
+					std::cout << "INFO: Render worker " << i + 1 << " exited, restarting it" << std::endl;
+				}
+			}
+		}
+	}
+
+	// let the workers finish the job they are on, then remove the socket
+	for (int i = 0; i < workerCount; i++)
+	{
+		if (workers[i] != 0)
+		{
+			kill(workers[i], SIGTERM);
+		}
+	}
+	for (int i = 0; i < workerCount; i++)
+	{
+		if (workers[i] != 0)
+		{
+			while ((waitpid(workers[i], NULL, 0) < 0) && (errno == EINTR))
+			{
+			}
+		}
+	}
+
+	close(m_listenSocket);
+	m_listenSocket = -1;
+	unlink(m_socketPath.c_str());
+	std::cout << "INFO: Render server stopped" << std::endl;
+
+	return false;
+#endif
+}
+
+/***********************************************************
+ *  ServeJobs()
+ *
+ *  This method is used for taking clients off the shared
+ *  accept queue one at a time until the worker is stopped.
+ ***********************************************************/
+void RenderServer::ServeJobs(SceneManager* pSceneManager)
+{
+#ifndef _WIN32
+	if ((m_listenSocket < 0) || (NULL == pSceneManager))
+	{
+		return;
+	}
+
+	std::cout << "INFO: Render worker " << m_workerIndex << " ready" << std::endl;
+
+	while (g_bStopServer == 0)
+	{
+		int clientSocket = accept(m_listenSocket, NULL, NULL);
+		if (clientSocket < 0)
+		{
+			continue;
+		}
+
+		HandleConnection(clientSocket, pSceneManager);
+		close(clientSocket);
+	}
+#endif
+}
+
+/***********************************************************
+ *  HandleConnection()
+ ***********************************************************/
+void RenderServer::HandleConnection(int clientSocket, SceneManager* pSceneManager)
+{
+#ifndef _WIN32
+	std::string received;
+	char buffer[4096];
+
+	while (g_bStopServer == 0)
+	{
+		ssize_t length = recv(clientSocket, buffer, sizeof(buffer), 0);
+		if (length < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return;
+		}
+		if (length == 0)
+		{
+			return;
+		}
+		received.append(buffer, (size_t)length);
+
+		size_t lineEnd = received.find('\n');
+		while (lineEnd != std::string::npos)
+		{
+			std::string line = received.substr(0, lineEnd);
+			received.erase(0, lineEnd + 1);
+			lineEnd = received.find('\n');
+
+			if ((line.empty() == false) && (line[line.size() - 1] == '\r'))
+			{
+				line.erase(line.size() - 1);
+			}
+			if (line.empty())
+			{
+				continue;
+			}
+
+			std::string reply;
+			RunJob(line, pSceneManager, reply);
+			if (SendReply(clientSocket, reply) == false)
+			{
+				return;
+			}
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running one job line. The scene is
+ *  the one this application builds; the jobs choose the
+ *  camera, the size and the output file.
+ ***********************************************************/
+bool RenderServer::RunJob(const std::string& line, SceneManager* pSceneManager, std::string& reply)
+{
+	PROFILE_SCOPE("RenderJob");
+
+	std::istringstream fields(line);
+	std::string command;
+	fields >> command;
+
+	if (command == "ping")
+	{
+		reply = "ok";
+		return true;
+	}
+	if (command != "render")
+	{
+		reply = "error unknown command: " + command;
+		return false;
+	}
+
+	std::string output;
+	std::string size;
+	int width = 0;
+	int height = 0;
+	if (!(fields >> output >> size) ||
+		(sscanf(size.c_str(), "%dx%d", &width, &height) != 2) ||
+		(width <= 0) || (height <= 0))
+	{
+		reply = "error expected: render <output> <width>x<height> <x y z yaw pitch [zoom] [ortho]>";
+		return false;
+	}
+
+	CAMERA_POSE pose;
+	pose.name = output;
+	std::string poseFields;
+	std::getline(fields, poseFields);
+	if (BatchRenderer::ParsePose(poseFields, pose) == false)
+	{
+		reply = "error expected a camera pose: x y z yaw pitch [zoom] [ortho]";
+		return false;
+	}
+
+	std::string extension;
+	size_t dot = output.find_last_of('.');
+	if (dot != std::string::npos)
+	{
+		extension = output.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	}
+
+	double startTime = glfwGetTime();
+	bool bRendered = false;
+
+	if (extension == "ppm")
+	{
+		TiledRenderer tiledRenderer;
+		bRendered = tiledRenderer.RenderImage(pSceneManager, pose, width, height, output.c_str());
+		if (bRendered == false)
+		{
+			reply = "error could not render " + output;
+		}
+	}
+	else
+	{
+		IMAGE_FORMAT format = IMAGE_FORMAT_PNG;
+		if (ImageWriter::ParseFormat(extension.c_str(), format) == false)
+		{
+			reply = "error output must end in .png, .qoi or .ppm: " + output;
+			return false;
+		}
+		bRendered = RenderSinglePass(pSceneManager, pose, width, height, output, format, reply);
+	}
+
+	if (bRendered)
+	{
+		char timing[32];
+		snprintf(timing, sizeof(timing), "ok %.1f", (glfwGetTime() - startTime) * 1000.0);
+		reply = timing;
+	}
+	return bRendered;
+}
+
+/***********************************************************
+ *  RenderSinglePass()
+ ***********************************************************/
+bool RenderServer::RenderSinglePass(
+	SceneManager* pSceneManager,
+	const CAMERA_POSE& pose,
+	int width,
+	int height,
+	const std::string& filename,
+	IMAGE_FORMAT format,
+	std::string& reply)
+{
+	SCENE_VIEW sceneView;
+	ViewManager::BuildCameraPoseView(pose, (float)width / height, sceneView);
+	sceneView.viewportRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+	// the software rasterizer has no framebuffer size limit, only the memory cap
+	// above, and keeps rows top-down
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		if ((width > g_MaxSoftwareImageSize) || (height > g_MaxSoftwareImageSize))
+		{
+			reply = "error images over " + std::to_string(g_MaxSoftwareImageSize) + " pixels a side must be .ppm";
+			return false;
+		}
+
+		m_pSoftwareRasterizer->RenderView(pSceneManager, sceneView, width, height);
+		if (ImageWriter::WriteImage(
+			filename.c_str(),
+			format,
+			width,
+			height,
+			m_pSoftwareRasterizer->GetPixels(),
+			m_pSoftwareRasterizer->GetRowStride()) == false)
+		{
+			reply = "error could not write " + filename;
+			return false;
+		}
+		return true;
+	}
+
+	GLint maxRenderbufferSize = 0;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbufferSize);
+	if ((width > maxRenderbufferSize) || (height > maxRenderbufferSize))
+	{
+		reply = "error images over " + std::to_string(maxRenderbufferSize) + " pixels a side must be .ppm";
+		return false;
+	}
+
+	if (ResizeTarget(width, height) == false)
+	{
+		reply = "error could not create the render target";
+		return false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, width, height);
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	pSceneManager->RenderSceneViews(&sceneView, 1, width, height);
+
+	ptrdiff_t rowStride = (ptrdiff_t)width * 4;
+	m_pixels.resize((size_t)rowStride * height);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &m_pixels[0]);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// the readback is bottom-up
+	if (ImageWriter::WriteImage(
+		filename.c_str(),
+		format,
+		width,
+		height,
+		&m_pixels[(size_t)(height - 1) * rowStride],
+		-rowStride) == false)
+	{
+		reply = "error could not write " + filename;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ResizeTarget()
+ ***********************************************************/
+bool RenderServer::ResizeTarget(int width, int height)
+{
+	if ((m_framebuffer != 0) && (width == m_targetWidth) && (height == m_targetHeight))
+	{
+		return true;
+	}
+
+	DestroyTarget();
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		DestroyTarget();
+		return false;
+	}
+
+	m_targetWidth = width;
+	m_targetHeight = height;
+	return true;
+}
+
+/***********************************************************
+ *  DestroyTarget()
+ ***********************************************************/
+void RenderServer::DestroyTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+}
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////
+// RenderServer.h
+// ==============
+// long-running render worker processes taking jobs over a Unix domain socket
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "ImageWriter.h"
+#include "SceneManager.h"
+#include "SoftwareRasterizer.h"
+#include "ViewManager.h"
+
+/***********************************************************
+ *  RenderServer
+ *
+ *  The server process opens a listening Unix domain socket
+ *  and forks a number of worker processes before any window
+ *  or GL context exists. Each worker then goes on to create
+ *  its own hidden window, load the shaders, meshes and
+ *  textures once, and accept connections on the shared
+ *  socket, so the kernel's accept queue hands each waiting
+ *  client to the next idle worker. A client sends one job per
+ *  line and gets one reply line per job:
+ *
+ *    render <output> <width>x<height> <x y z yaw pitch [zoom] [ortho]>
+ *      -> ok <milliseconds>   or   error <message>
+ *    ping -> ok
+ *
+ *  .png and .qoi outputs are rendered in one offscreen pass,
+ *  or by the software rasterizer when one is set, up to a
+ *  fixed size; .ppm outputs are tiled and may be any size. The server
+ *  process only restarts workers that exit and removes the
+ *  socket when it is stopped with SIGINT or SIGTERM.
+ ***********************************************************/
+class RenderServer
+{
+public:
+	RenderServer();
+	~RenderServer();
+
+	// create the listening socket at the path, replacing a stale one
+	bool Listen(const char* socketPath);
+	// fork the workers; returns true in each worker process, and false in
+	// the server process once it has been stopped and the workers are gone
+	bool ForkWorkers(int workerCount);
+	// accept connections and run their jobs until the process is stopped
+	void ServeJobs(SceneManager* pSceneManager);
+	// draw single pass jobs on the CPU instead of through OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pSoftwareRasterizer) { m_pSoftwareRasterizer = pSoftwareRasterizer; }
+
+private:
+	int m_listenSocket;
+	std::string m_socketPath;
+	// 0 in the server process, 1..n in the workers
+	int m_workerIndex;
+
+	// offscreen target for single pass jobs, resized as needed
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_targetWidth;
+	int m_targetHeight;
+	std::vector<uint8_t> m_pixels;
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+
+	// read job lines from one client until it disconnects
+	void HandleConnection(int clientSocket, SceneManager* pSceneManager);
+	// run one job line, filling in the reply
+	bool RunJob(const std::string& line, SceneManager* pSceneManager, std::string& reply);
+	// render a pose into the offscreen target and write it as PNG or QOI
+	bool RenderSinglePass(
+		SceneManager* pSceneManager,
+		const CAMERA_POSE& pose,
+		int width,
+		int height,
+		const std::string& filename,
+		IMAGE_FORMAT format,
+		std::string& reply);
+	bool ResizeTarget(int width, int height);
+	void DestroyTarget();
+};
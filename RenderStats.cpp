@@ -0,0 +1,153 @@
+/////////////////////////////////////////////////////////////////////////////////
+// RenderStats.cpp
+// ===============
+// per frame counters of the work submitted to OpenGL
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+
+#include <cstdio>
+
+namespace
+{
+	RENDER_STATS g_CurrentStats;
+	RENDER_STATS g_FrameStats;
+	RENDER_STATS g_TotalStats;
+}
+
+/***********************************************************
+ *  AddDrawCall()
+ ***********************************************************/
+void RenderStats::AddDrawCall(GLenum primitiveMode, GLsizei vertexCount)
+{
+	g_CurrentStats.drawCalls++;
+	g_CurrentStats.vertices += vertexCount;
+
+	switch (primitiveMode)
+	{
+	case GL_TRIANGLES:
+		g_CurrentStats.triangles += vertexCount / 3;
+		break;
+	case GL_TRIANGLE_STRIP:
+	case GL_TRIANGLE_FAN:
+		if (vertexCount > 2)
+		{
+			g_CurrentStats.triangles += vertexCount - 2;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  AddInstancedDrawCall()
+ ***********************************************************/
+void RenderStats::AddInstancedDrawCall(GLenum primitiveMode, GLsizei vertexCount, GLsizei instanceCount)
+{
+	if (instanceCount <= 0)
+	{
+		return;
+	}
+
+	uint64_t trianglesBefore = g_CurrentStats.triangles;
+	AddDrawCall(primitiveMode, vertexCount);
+
+	// every instance repeats the vertices and triangles of the first
+	uint64_t instanceTriangles = g_CurrentStats.triangles - trianglesBefore;
+	g_CurrentStats.vertices += (uint64_t)vertexCount * (instanceCount - 1);
+	g_CurrentStats.triangles += instanceTriangles * (instanceCount - 1);
+}
+
+/***********************************************************
+ *  AddVertexArrayBind()
+ ***********************************************************/
+void RenderStats::AddVertexArrayBind()
+{
+	g_CurrentStats.vertexArrayBinds++;
+}
+
+/***********************************************************
+ *  AddTextureBind()
+ ***********************************************************/
+void RenderStats::AddTextureBind()
+{
+	g_CurrentStats.textureBinds++;
+}
+
+/***********************************************************
+ *  AddUniformUpdates()
+ ***********************************************************/
+void RenderStats::AddUniformUpdates(int uniformCount)
+{
+	g_CurrentStats.uniformUpdates += uniformCount;
+}
+
+/***********************************************************
+ *  AddUploadBytes()
+ ***********************************************************/
+void RenderStats::AddUploadBytes(size_t byteCount)
+{
+	g_CurrentStats.uploadBytes += byteCount;
+}
+
+/***********************************************************
+ *  EndFrame()
+ ***********************************************************/
+void RenderStats::EndFrame()
+{
+	g_TotalStats.drawCalls += g_CurrentStats.drawCalls;
+	g_TotalStats.vertices += g_CurrentStats.vertices;
+	g_TotalStats.triangles += g_CurrentStats.triangles;
+	g_TotalStats.vertexArrayBinds += g_CurrentStats.vertexArrayBinds;
+	g_TotalStats.textureBinds += g_CurrentStats.textureBinds;
+	g_TotalStats.uniformUpdates += g_CurrentStats.uniformUpdates;
+	g_TotalStats.uploadBytes += g_CurrentStats.uploadBytes;
+
+	g_FrameStats = g_CurrentStats;
+	g_CurrentStats = RENDER_STATS();
+}
+
+/***********************************************************
+ *  GetFrameStats()
+ ***********************************************************/
+const RENDER_STATS& RenderStats::GetFrameStats()
+{
+	return g_FrameStats;
+}
+
+/***********************************************************
+ *  GetCurrentStats()
+ ***********************************************************/
+const RENDER_STATS& RenderStats::GetCurrentStats()
+{
+	return g_CurrentStats;
+}
+
+/***********************************************************
+ *  GetTotalStats()
+ ***********************************************************/
+const RENDER_STATS& RenderStats::GetTotalStats()
+{
+	return g_TotalStats;
+}
+
+/***********************************************************
+ *  FormatJSONFields()
+ ***********************************************************/
+std::string RenderStats::FormatJSONFields(const RENDER_STATS& stats)
+{
+	char text[256];
+	snprintf(text, sizeof(text),
+		"\"draw_calls\":%llu,\"vertices\":%llu,\"triangles\":%llu,"
+		"\"vao_binds\":%llu,\"texture_binds\":%llu,\"uniform_updates\":%llu,\"upload_bytes\":%llu",
+		(unsigned long long)stats.drawCalls,
+		(unsigned long long)stats.vertices,
+		(unsigned long long)stats.triangles,
+		(unsigned long long)stats.vertexArrayBinds,
+		(unsigned long long)stats.textureBinds,
+		(unsigned long long)stats.uniformUpdates,
+		(unsigned long long)stats.uploadBytes);
+
+	return std::string(text);
+}
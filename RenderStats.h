@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////
+// RenderStats.h
+// =============
+// per frame counters of the work submitted to OpenGL
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  RENDER_STATS
+ ***********************************************************/
+struct RENDER_STATS
+{
+	uint64_t drawCalls = 0;
+	uint64_t vertices = 0;
+	uint64_t triangles = 0;
+	uint64_t vertexArrayBinds = 0;
+	uint64_t textureBinds = 0;
+	uint64_t uniformUpdates = 0;
+	uint64_t uploadBytes = 0;
+};
+
+/***********************************************************
+ *  RenderStats
+ *
+ *  The code that issues GL calls adds to the counters of the
+ *  frame in progress; EndFrame() publishes them as the last
+ *  frame's stats and starts a new frame. All counting happens
+ *  on the thread that owns the GL context.
+ ***********************************************************/
+class RenderStats
+{
+public:
+	// count one draw call and the triangles it makes from its vertices
+	static void AddDrawCall(GLenum primitiveMode, GLsizei vertexCount);
+	static void AddInstancedDrawCall(GLenum primitiveMode, GLsizei vertexCount, GLsizei instanceCount);
+	static void AddVertexArrayBind();
+	static void AddTextureBind();
+	static void AddUniformUpdates(int uniformCount);
+	static void AddUploadBytes(size_t byteCount);
+
+	// finish the frame in progress and start counting a new one
+	static void EndFrame();
+
+	// counters of the last finished frame
+	static const RENDER_STATS& GetFrameStats();
+	// counters of the frame in progress
+	static const RENDER_STATS& GetCurrentStats();
+	// counters summed over every finished frame, including startup
+	static const RENDER_STATS& GetTotalStats();
+
+	// the counters as the members of a JSON object, without the braces
+	static std::string FormatJSONFields(const RENDER_STATS& stats);
+};
@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////////////////////////
+// RenderThread.cpp
+// ================
+// render thread that draws scene snapshots handed over by the update thread
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderThread.h"
+#include "Profiler.h"
+
+#include <cstdio>
+
+namespace
+{
+	// set in the middle slot index while it holds an untaken snapshot
+	const int g_FreshSnapshotBit = 4;
+	const int g_SnapshotSlotMask = 3;
+}
+
+/***********************************************************
+ *  RenderThread()
+ ***********************************************************/
+RenderThread::RenderThread()
+	: m_writeIndex(0),
+	m_readIndex(2),
+	m_middleSlot(1),
+	m_pWindow(NULL),
+	m_bStopping(false),
+	m_publishedCount(0),
+	m_skippedCount(0),
+	m_drawnCount(0)
+{
+}
+
+/***********************************************************
+ *  ~RenderThread()
+ ***********************************************************/
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for moving the OpenGL context to the
+ *  render thread. A context can only be current on one
+ *  thread at a time, so the calling thread lets go of it
+ *  first; GLFW event handling stays on the calling thread,
+ *  which is required on most platforms.
+ ***********************************************************/
+bool RenderThread::Start(GLFWwindow* pWindow, std::function<void(const RENDER_SNAPSHOT&)> drawSnapshot)
+{
+	if ((NULL == pWindow) || IsRunning())
+	{
+		return false;
+	}
+
+	m_pWindow = pWindow;
+	m_drawSnapshot = drawSnapshot;
+	m_bStopping = false;
+
+	glfwMakeContextCurrent(NULL);
+	m_thread = std::thread(&RenderThread::ThreadLoop, this);
+	return true;
+}
+
+/***********************************************************
+ *  Stop()
+ ***********************************************************/
+void RenderThread::Stop()
+{
+	if (IsRunning() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopping = true;
+	}
+	m_snapshotReady.notify_one();
+	m_thread.join();
+
+	glfwMakeContextCurrent(m_pWindow);
+}
+
+/***********************************************************
+ *  PublishSnapshot()
+ *
+ *  This method is used for swapping the filled slot into the
+ *  middle and taking the old middle slot to fill next. The
+ *  exchange never waits; the mutex is only locked for a
+ *  moment so the render thread cannot miss the wake-up
+ *  between checking for a snapshot and going to sleep.
+ ***********************************************************/
+void RenderThread::PublishSnapshot()
+{
+	m_snapshots[m_writeIndex].sequence = ++m_publishedCount;
+
+	int previousSlot = m_middleSlot.exchange(m_writeIndex | g_FreshSnapshotBit, std::memory_order_acq_rel);
+	m_writeIndex = previousSlot & g_SnapshotSlotMask;
+	if (previousSlot & g_FreshSnapshotBit)
+	{
+		m_skippedCount++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+	}
+	m_snapshotReady.notify_one();
+}
+
+/***********************************************************
+ *  ThreadLoop()
+ *
+ *  This method is used for drawing snapshots until stopped.
+ *  The thread sleeps while nothing new has been published,
+ *  so it never draws the same snapshot twice.
+ ***********************************************************/
+void RenderThread::ThreadLoop()
+{
+	Profiler::SetThreadName("render");
+	glfwMakeContextCurrent(m_pWindow);
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_snapshotReady.wait(lock, [this]
+				{
+					return m_bStopping || ((m_middleSlot.load(std::memory_order_acquire) & g_FreshSnapshotBit) != 0);
+				});
+			if (m_bStopping)
+			{
+				break;
+			}
+		}
+
+		// take the newest snapshot and leave our old slot for the update thread
+		int previousSlot = m_middleSlot.exchange(m_readIndex, std::memory_order_acq_rel);
+		m_readIndex = previousSlot & g_SnapshotSlotMask;
+
+		m_drawSnapshot(m_snapshots[m_readIndex]);
+		m_drawnCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+/***********************************************************
+ *  PrintStats()
+ ***********************************************************/
+void RenderThread::PrintStats() const
+{
+	printf("INFO: Render thread drew %llu of %llu snapshots (%llu replaced before they were drawn)\n",
+		(unsigned long long)m_drawnCount.load(std::memory_order_relaxed),
+		(unsigned long long)m_publishedCount,
+		(unsigned long long)m_skippedCount);
+	fflush(stdout);
+}
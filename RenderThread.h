@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////////
+// RenderThread.h
+// ==============
+// render thread that draws scene snapshots handed over by the update thread
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GLFW/glfw3.h"
+
+#include "SceneManager.h"
+#include "ViewFrustum.h"
+
+/***********************************************************
+ *  RENDER_SNAPSHOT
+ *
+ *  Everything the render thread needs to draw one frame. The
+ *  update thread fills it in and never touches it again once
+ *  it is published, so the render thread can read it without
+ *  locks. The vectors keep their capacity between frames.
+ ***********************************************************/
+struct RENDER_SNAPSHOT
+{
+	// counts up by one for every published snapshot
+	uint64_t sequence = 0;
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	// the views of the layout; view 0 is the interactive camera
+	std::vector<SCENE_VIEW> views;
+	// culled and sorted draws of each view, with their model matrices
+	std::vector<std::vector<SceneManager::DRAW_PACKET>> viewPackets;
+	bool bShowPerfOverlay = false;
+	// CPU time the update thread spent building the snapshot
+	double buildMilliseconds = 0.0;
+};
+
+/***********************************************************
+ *  RenderThread
+ *
+ *  Takes over the window's OpenGL context and draws the
+ *  newest snapshot each time one is published, while the
+ *  main thread goes on polling input, stepping the camera
+ *  and culling the next frame.
+ *
+ *  The snapshots live in a triple buffer: the update thread
+ *  owns one slot, the render thread owns another, and the
+ *  third is handed back and forth with one atomic exchange.
+ *  Publishing replaces a snapshot the render thread has not
+ *  taken yet, so a slow frame skips stale snapshots instead
+ *  of queueing them, and neither side ever waits for the
+ *  other to finish with a slot.
+ ***********************************************************/
+class RenderThread
+{
+public:
+	RenderThread();
+	~RenderThread();
+
+	// release the window's context on the calling thread and start drawing
+	// each new snapshot with drawSnapshot() on the render thread
+	bool Start(GLFWwindow* pWindow, std::function<void(const RENDER_SNAPSHOT&)> drawSnapshot);
+	// finish the frame being drawn, stop the thread, and make the context
+	// current on the calling thread again
+	void Stop();
+
+	// the snapshot the update thread fills next; valid until PublishSnapshot()
+	RENDER_SNAPSHOT& GetWriteSnapshot() { return m_snapshots[m_writeIndex]; }
+	// hand the filled snapshot to the render thread
+	void PublishSnapshot();
+
+	bool IsRunning() const { return m_thread.joinable(); }
+	// print how many published snapshots were drawn and how many were skipped
+	void PrintStats() const;
+
+private:
+	RENDER_SNAPSHOT m_snapshots[3];
+	// slot the update thread is filling
+	int m_writeIndex;
+	// slot the render thread is drawing
+	int m_readIndex;
+	// the slot in between, with the fresh bit set while it holds a
+	// snapshot the render thread has not taken
+	std::atomic<int> m_middleSlot;
+
+	GLFWwindow* m_pWindow;
+	std::function<void(const RENDER_SNAPSHOT&)> m_drawSnapshot;
+	std::thread m_thread;
+	// only guards the sleep of the render thread while no snapshot is fresh
+	std::mutex m_wakeMutex;
+	std::condition_variable m_snapshotReady;
+	bool m_bStopping;
+
+	uint64_t m_publishedCount;
+	uint64_t m_skippedCount;
+	std::atomic<uint64_t> m_drawnCount;
+
+	void ThreadLoop();
+};
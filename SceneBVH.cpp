@@ -0,0 +1,611 @@
+/////////////////////////////////////////////////////////////////////////////////
+// SceneBVH.cpp
+// ============
+// bounding volume hierarchy over the world space bounds of the scene
+// objects, used for culling, picking and light assignment
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	// number of bins used when searching for the SAH split
+	const int g_SAHBinCount = 12;
+	// nodes with this many objects or fewer are never split
+	const int g_MinLeafObjects = 2;
+	// nodes with more objects are always split, even at a cost
+	const int g_MaxLeafObjects = 8;
+	// refitted cost over built cost that triggers a rebuild
+	const float g_RebuildCostRatio = 1.4f;
+	// deepest tree that is built; nodes at this depth become leaves
+	const int g_MaxTreeDepth = 60;
+	// a depth first walk never holds more than depth + 1 pending nodes
+	const int g_MaxStackDepth = g_MaxTreeDepth + 4;
+
+	// minimum corner of a packed object box
+	inline glm::vec3 ObjectMin(const PACKED_BOUNDS& bounds, int index)
+	{
+		return glm::vec3(
+			bounds.centerX[index] - bounds.extentX[index],
+			bounds.centerY[index] - bounds.extentY[index],
+			bounds.centerZ[index] - bounds.extentZ[index]);
+	}
+
+	// maximum corner of a packed object box
+	inline glm::vec3 ObjectMax(const PACKED_BOUNDS& bounds, int index)
+	{
+		return glm::vec3(
+			bounds.centerX[index] + bounds.extentX[index],
+			bounds.centerY[index] + bounds.extentY[index],
+			bounds.centerZ[index] + bounds.extentZ[index]);
+	}
+
+	// half of the surface area of a box, enough for cost ratios
+	inline float HalfArea(const glm::vec3& minXYZ, const glm::vec3& maxXYZ)
+	{
+		glm::vec3 size = glm::max(maxXYZ - minXYZ, glm::vec3(0.0f));
+		return (size.x * size.y) + (size.y * size.z) + (size.z * size.x);
+	}
+
+	// distance from the ray origin to the box, or FLT_MAX on a miss
+	inline float IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& minXYZ,
+		const glm::vec3& maxXYZ)
+	{
+		float tNear = 0.0f;
+		float tFar = FLT_MAX;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (minXYZ[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (maxXYZ[axis] - origin[axis]) * inverseDirection[axis];
+			if (t0 > t1)
+			{
+				float swap = t0;
+				t0 = t1;
+				t1 = swap;
+			}
+			tNear = glm::max(tNear, t0);
+			tFar = glm::min(tFar, t1);
+		}
+
+		return (tNear <= tFar) ? tNear : FLT_MAX;
+	}
+
+	// squared distance from a point to a box
+	inline float DistanceSquaredToBox(
+		const glm::vec3& point,
+		const glm::vec3& minXYZ,
+		const glm::vec3& maxXYZ)
+	{
+		glm::vec3 closest = glm::max(minXYZ, glm::min(point, maxXYZ));
+		glm::vec3 offset = point - closest;
+		return glm::dot(offset, offset);
+	}
+}
+
+/***********************************************************
+ *  SceneBVH()
+ ***********************************************************/
+SceneBVH::SceneBVH()
+	: m_builtCost(0.0f),
+	m_currentCost(0.0f)
+{
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the whole tree from the
+ *  current object bounds. Nodes are written depth first, so
+ *  every child comes after its parent in the node array.
+ ***********************************************************/
+void SceneBVH::Build(const PACKED_BOUNDS& bounds)
+{
+	m_nodes.clear();
+	m_objectIndices.clear();
+	m_builtCost = 0.0f;
+	m_currentCost = 0.0f;
+
+	if (bounds.count == 0)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> centers(bounds.count);
+	m_objectIndices.resize(bounds.count);
+	for (size_t i = 0; i < bounds.count; i++)
+	{
+		m_objectIndices[i] = static_cast<int>(i);
+		centers[i] = glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+	}
+
+	// a binary tree with one object per leaf has 2n - 1 nodes
+	m_nodes.reserve((bounds.count * 2) - 1);
+
+	BVH_NODE root;
+	root.leftOrFirst = 0;
+	root.objectCount = static_cast<int>(bounds.count);
+	UpdateLeafBounds(root, bounds);
+	m_nodes.push_back(root);
+
+	Subdivide(0, 0, bounds, centers);
+
+	m_builtCost = CalculateCost();
+	m_currentCost = m_builtCost;
+}
+
+/***********************************************************
+ *  Subdivide()
+ *
+ *  This method is used for splitting a node with the surface
+ *  area heuristic. Object centers are dropped into bins along
+ *  the longest axis of the center bounds, and the split plane
+ *  between two bins with the lowest cost is used.
+ ***********************************************************/
+void SceneBVH::Subdivide(int nodeIndex, int depth, const PACKED_BOUNDS& bounds, std::vector<glm::vec3>& centers)
+{
+	int first = m_nodes[nodeIndex].leftOrFirst;
+	int count = m_nodes[nodeIndex].objectCount;
+
+	if ((count <= g_MinLeafObjects) || (depth >= g_MaxTreeDepth))
+	{
+		return;
+	}
+
+	// bounds of the object centers pick the split axis
+	glm::vec3 centerMin(FLT_MAX);
+	glm::vec3 centerMax(-FLT_MAX);
+	for (int i = first; i < first + count; i++)
+	{
+		centerMin = glm::min(centerMin, centers[m_objectIndices[i]]);
+		centerMax = glm::max(centerMax, centers[m_objectIndices[i]]);
+	}
+
+	glm::vec3 centerSize = centerMax - centerMin;
+	int axis = 0;
+	if (centerSize.y > centerSize[axis]) axis = 1;
+	if (centerSize.z > centerSize[axis]) axis = 2;
+
+	// every object shares the same center, so there is nothing to split
+	if (centerSize[axis] <= 0.0f)
+	{
+		return;
+	}
+
+	struct SAH_BIN
+	{
+		glm::vec3 minXYZ = glm::vec3(FLT_MAX);
+		glm::vec3 maxXYZ = glm::vec3(-FLT_MAX);
+		int objectCount = 0;
+	};
+	SAH_BIN bins[g_SAHBinCount];
+
+	float binScale = g_SAHBinCount / centerSize[axis];
+	for (int i = first; i < first + count; i++)
+	{
+		int objectIndex = m_objectIndices[i];
+		int bin = std::min(g_SAHBinCount - 1,
+			static_cast<int>((centers[objectIndex][axis] - centerMin[axis]) * binScale));
+
+		bins[bin].objectCount++;
+		bins[bin].minXYZ = glm::min(bins[bin].minXYZ, ObjectMin(bounds, objectIndex));
+		bins[bin].maxXYZ = glm::max(bins[bin].maxXYZ, ObjectMax(bounds, objectIndex));
+	}
+
+	// sweep from both sides to get the area and count left/right of each plane
+	float leftArea[g_SAHBinCount - 1];
+	float rightArea[g_SAHBinCount - 1];
+	int leftCount[g_SAHBinCount - 1];
+	int rightCount[g_SAHBinCount - 1];
+
+	glm::vec3 leftMin(FLT_MAX);
+	glm::vec3 leftMax(-FLT_MAX);
+	glm::vec3 rightMin(FLT_MAX);
+	glm::vec3 rightMax(-FLT_MAX);
+	int leftSum = 0;
+	int rightSum = 0;
+
+	for (int i = 0; i < g_SAHBinCount - 1; i++)
+	{
+		leftSum += bins[i].objectCount;
+		leftCount[i] = leftSum;
+		leftMin = glm::min(leftMin, bins[i].minXYZ);
+		leftMax = glm::max(leftMax, bins[i].maxXYZ);
+		leftArea[i] = HalfArea(leftMin, leftMax);
+
+		int j = g_SAHBinCount - 1 - i;
+		rightSum += bins[j].objectCount;
+		rightCount[j - 1] = rightSum;
+		rightMin = glm::min(rightMin, bins[j].minXYZ);
+		rightMax = glm::max(rightMax, bins[j].maxXYZ);
+		rightArea[j - 1] = HalfArea(rightMin, rightMax);
+	}
+
+	int bestSplit = -1;
+	float bestCost = FLT_MAX;
+	for (int i = 0; i < g_SAHBinCount - 1; i++)
+	{
+		if ((leftCount[i] == 0) || (rightCount[i] == 0))
+		{
+			continue;
+		}
+
+		float cost = (leftCount[i] * leftArea[i]) + (rightCount[i] * rightArea[i]);
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestSplit = i;
+		}
+	}
+
+	if (bestSplit < 0)
+	{
+		return;
+	}
+
+	// one traversal step plus the children, against testing every object here
+	float parentArea = HalfArea(m_nodes[nodeIndex].minXYZ, m_nodes[nodeIndex].maxXYZ);
+	float splitCost = 1.0f + ((parentArea > 0.0f) ? (bestCost / parentArea) : static_cast<float>(count));
+	if ((splitCost >= static_cast<float>(count)) && (count <= g_MaxLeafObjects))
+	{
+		return;
+	}
+
+	// partition the object indices around the split plane
+	float splitPosition = centerMin[axis] + ((bestSplit + 1) / binScale);
+	int i = first;
+	int j = first + count - 1;
+	while (i <= j)
+	{
+		if (centers[m_objectIndices[i]][axis] < splitPosition)
+		{
+			i++;
+		}
+		else
+		{
+			int swap = m_objectIndices[i];
+			m_objectIndices[i] = m_objectIndices[j];
+			m_objectIndices[j] = swap;
+			j--;
+		}
+	}
+
+	int leftObjects = i - first;
+	if ((leftObjects == 0) || (leftObjects == count))
+	{
+		return;
+	}
+
+	// both children are allocated together so the right child is left + 1
+	int leftIndex = static_cast<int>(m_nodes.size());
+	BVH_NODE leftNode;
+	leftNode.leftOrFirst = first;
+	leftNode.objectCount = leftObjects;
+	UpdateLeafBounds(leftNode, bounds);
+
+	BVH_NODE rightNode;
+	rightNode.leftOrFirst = i;
+	rightNode.objectCount = count - leftObjects;
+	UpdateLeafBounds(rightNode, bounds);
+
+	m_nodes.push_back(leftNode);
+	m_nodes.push_back(rightNode);
+
+	m_nodes[nodeIndex].leftOrFirst = leftIndex;
+	m_nodes[nodeIndex].objectCount = 0;
+
+	Subdivide(leftIndex, depth + 1, bounds, centers);
+	Subdivide(leftIndex + 1, depth + 1, bounds, centers);
+}
+
+/***********************************************************
+ *  UpdateLeafBounds()
+ ***********************************************************/
+void SceneBVH::UpdateLeafBounds(BVH_NODE& node, const PACKED_BOUNDS& bounds) const
+{
+	node.minXYZ = glm::vec3(FLT_MAX);
+	node.maxXYZ = glm::vec3(-FLT_MAX);
+
+	for (int i = node.leftOrFirst; i < node.leftOrFirst + node.objectCount; i++)
+	{
+		int objectIndex = m_objectIndices[i];
+		node.minXYZ = glm::min(node.minXYZ, ObjectMin(bounds, objectIndex));
+		node.maxXYZ = glm::max(node.maxXYZ, ObjectMax(bounds, objectIndex));
+	}
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the node boxes after the
+ *  objects have moved, without changing the tree structure.
+ *  Walking the nodes backwards visits children before their
+ *  parents.
+ ***********************************************************/
+void SceneBVH::Refit(const PACKED_BOUNDS& bounds)
+{
+	for (int i = static_cast<int>(m_nodes.size()) - 1; i >= 0; i--)
+	{
+		BVH_NODE& node = m_nodes[i];
+
+		if (node.objectCount > 0)
+		{
+			UpdateLeafBounds(node, bounds);
+		}
+		else
+		{
+			const BVH_NODE& left = m_nodes[node.leftOrFirst];
+			const BVH_NODE& right = m_nodes[node.leftOrFirst + 1];
+			node.minXYZ = glm::min(left.minXYZ, right.minXYZ);
+			node.maxXYZ = glm::max(left.maxXYZ, right.maxXYZ);
+		}
+	}
+
+	m_currentCost = CalculateCost();
+}
+
+/***********************************************************
+ *  NeedsRebuild()
+ ***********************************************************/
+bool SceneBVH::NeedsRebuild() const
+{
+	return (m_currentCost > m_builtCost * g_RebuildCostRatio);
+}
+
+/***********************************************************
+ *  CalculateCost()
+ *
+ *  This method is used for scoring the tree with the surface
+ *  area heuristic, relative to the root box.
+ ***********************************************************/
+float SceneBVH::CalculateCost() const
+{
+	if (m_nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	float rootArea = HalfArea(m_nodes[0].minXYZ, m_nodes[0].maxXYZ);
+	if (rootArea <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	float cost = 0.0f;
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		float area = HalfArea(m_nodes[i].minXYZ, m_nodes[i].maxXYZ) / rootArea;
+		cost += area * ((m_nodes[i].objectCount > 0) ? m_nodes[i].objectCount : 1.0f);
+	}
+
+	return cost;
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for collecting the objects inside the
+ *  frustum. Each stack entry carries a mask of the planes the
+ *  node still straddles; planes a node is fully inside of are
+ *  not tested again further down the tree.
+ ***********************************************************/
+void SceneBVH::QueryFrustum(
+	const ViewFrustum& frustum,
+	const PACKED_BOUNDS& bounds,
+	std::vector<int>& objectIndices) const
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	const int allPlanes = (1 << ViewFrustum::PLANE_COUNT) - 1;
+
+	int nodeStack[g_MaxStackDepth];
+	int maskStack[g_MaxStackDepth];
+	int stackSize = 0;
+
+	nodeStack[stackSize] = 0;
+	maskStack[stackSize] = frustum.IsValid() ? allPlanes : 0;
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		const BVH_NODE& node = m_nodes[nodeStack[stackSize]];
+		int planeMask = maskStack[stackSize];
+		bool bOutside = false;
+
+		glm::vec3 center = (node.minXYZ + node.maxXYZ) * 0.5f;
+		glm::vec3 extents = (node.maxXYZ - node.minXYZ) * 0.5f;
+
+		for (int p = 0; (p < ViewFrustum::PLANE_COUNT) && (bOutside == false); p++)
+		{
+			if ((planeMask & (1 << p)) == 0)
+			{
+				continue;
+			}
+
+			const glm::vec4& plane = frustum.GetPlane(p);
+			glm::vec3 normal = glm::vec3(plane);
+			float distance = glm::dot(normal, center) + plane.w;
+			float reach = glm::dot(glm::abs(normal), extents);
+
+			if (distance + reach < 0.0f)
+			{
+				bOutside = true;
+			}
+			else if (distance - reach >= 0.0f)
+			{
+				planeMask &= ~(1 << p);
+			}
+		}
+
+		if (bOutside)
+		{
+			continue;
+		}
+
+		if (node.objectCount > 0)
+		{
+			for (int i = node.leftOrFirst; i < node.leftOrFirst + node.objectCount; i++)
+			{
+				int objectIndex = m_objectIndices[i];
+
+				if ((planeMask == 0) ||
+					frustum.TestBox(ObjectMin(bounds, objectIndex), ObjectMax(bounds, objectIndex)))
+				{
+					objectIndices.push_back(objectIndex);
+				}
+			}
+		}
+		else if (stackSize + 2 <= g_MaxStackDepth)
+		{
+			nodeStack[stackSize] = node.leftOrFirst + 1;
+			maskStack[stackSize] = planeMask;
+			stackSize++;
+			nodeStack[stackSize] = node.leftOrFirst;
+			maskStack[stackSize] = planeMask;
+			stackSize++;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for picking: it returns the object
+ *  whose box is hit first along the ray. The nearer child is
+ *  visited first so farther subtrees can be skipped.
+ ***********************************************************/
+int SceneBVH::QueryRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	const PACKED_BOUNDS& bounds,
+	float& hitDistance) const
+{
+	int hitObject = -1;
+	hitDistance = FLT_MAX;
+
+	if (m_nodes.empty())
+	{
+		return hitObject;
+	}
+
+	glm::vec3 inverseDirection(
+		(direction.x != 0.0f) ? 1.0f / direction.x : FLT_MAX,
+		(direction.y != 0.0f) ? 1.0f / direction.y : FLT_MAX,
+		(direction.z != 0.0f) ? 1.0f / direction.z : FLT_MAX);
+
+	int nodeStack[g_MaxStackDepth];
+	int stackSize = 0;
+	nodeStack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[nodeStack[--stackSize]];
+
+		if (IntersectRayBox(origin, inverseDirection, node.minXYZ, node.maxXYZ) >= hitDistance)
+		{
+			continue;
+		}
+
+		if (node.objectCount > 0)
+		{
+			for (int i = node.leftOrFirst; i < node.leftOrFirst + node.objectCount; i++)
+			{
+				int objectIndex = m_objectIndices[i];
+				float distance = IntersectRayBox(
+					origin,
+					inverseDirection,
+					ObjectMin(bounds, objectIndex),
+					ObjectMax(bounds, objectIndex));
+
+				if (distance < hitDistance)
+				{
+					hitDistance = distance;
+					hitObject = objectIndex;
+				}
+			}
+		}
+		else if (stackSize + 2 <= g_MaxStackDepth)
+		{
+			const BVH_NODE& left = m_nodes[node.leftOrFirst];
+			const BVH_NODE& right = m_nodes[node.leftOrFirst + 1];
+			float leftDistance = IntersectRayBox(origin, inverseDirection, left.minXYZ, left.maxXYZ);
+			float rightDistance = IntersectRayBox(origin, inverseDirection, right.minXYZ, right.maxXYZ);
+
+			// push the farther child first so the nearer one is popped next
+			if (leftDistance < rightDistance)
+			{
+				nodeStack[stackSize++] = node.leftOrFirst + 1;
+				nodeStack[stackSize++] = node.leftOrFirst;
+			}
+			else
+			{
+				nodeStack[stackSize++] = node.leftOrFirst;
+				nodeStack[stackSize++] = node.leftOrFirst + 1;
+			}
+		}
+	}
+
+	return hitObject;
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for finding the objects within reach
+ *  of a point light.
+ ***********************************************************/
+void SceneBVH::QuerySphere(
+	const glm::vec3& center,
+	float radius,
+	const PACKED_BOUNDS& bounds,
+	std::vector<int>& objectIndices) const
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	float radiusSquared = radius * radius;
+
+	int nodeStack[g_MaxStackDepth];
+	int stackSize = 0;
+	nodeStack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[nodeStack[--stackSize]];
+
+		if (DistanceSquaredToBox(center, node.minXYZ, node.maxXYZ) > radiusSquared)
+		{
+			continue;
+		}
+
+		if (node.objectCount > 0)
+		{
+			for (int i = node.leftOrFirst; i < node.leftOrFirst + node.objectCount; i++)
+			{
+				int objectIndex = m_objectIndices[i];
+				if (DistanceSquaredToBox(center, ObjectMin(bounds, objectIndex), ObjectMax(bounds, objectIndex)) <= radiusSquared)
+				{
+					objectIndices.push_back(objectIndex);
+				}
+			}
+		}
+		else if (stackSize + 2 <= g_MaxStackDepth)
+		{
+			nodeStack[stackSize++] = node.leftOrFirst + 1;
+			nodeStack[stackSize++] = node.leftOrFirst;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////
+// SceneBVH.h
+// ==========
+// bounding volume hierarchy over the world space bounds of the scene
+// objects, used for culling, picking and light assignment
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ViewFrustum.h"
+
+/***********************************************************
+ *  BVH_NODE
+ *
+ *  One 32 byte node of the flattened tree. Leaf nodes have a
+ *  non-zero object count and point at a range of the object
+ *  index list; inner nodes point at their left child, and the
+ *  right child always follows it in the node array.
+ ***********************************************************/
+struct BVH_NODE
+{
+	glm::vec3 minXYZ;
+	int leftOrFirst;
+	glm::vec3 maxXYZ;
+	int objectCount;
+};
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  Built with the surface area heuristic over binned object
+ *  centers. Moving objects only refit the node boxes; the
+ *  tree is rebuilt once refitting has made it noticeably
+ *  worse than when it was built.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	SceneBVH();
+
+	// build the tree over the packed object bounds
+	void Build(const PACKED_BOUNDS& bounds);
+	// recalculate the node boxes after objects have moved
+	void Refit(const PACKED_BOUNDS& bounds);
+	// true when the refitted tree has degraded enough to rebuild
+	bool NeedsRebuild() const;
+
+	bool IsEmpty() const { return m_nodes.empty(); }
+	size_t GetObjectCount() const { return m_objectIndices.size(); }
+	size_t GetNodeCount() const { return m_nodes.size(); }
+
+	// append the objects whose boxes touch the frustum
+	void QueryFrustum(
+		const ViewFrustum& frustum,
+		const PACKED_BOUNDS& bounds,
+		std::vector<int>& objectIndices) const;
+	// find the nearest object box hit by a ray, or -1
+	int QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const PACKED_BOUNDS& bounds,
+		float& hitDistance) const;
+	// append the objects whose boxes touch the sphere
+	void QuerySphere(
+		const glm::vec3& center,
+		float radius,
+		const PACKED_BOUNDS& bounds,
+		std::vector<int>& objectIndices) const;
+
+private:
+	// flattened nodes, root first
+	std::vector<BVH_NODE> m_nodes;
+	// object indices, grouped by leaf
+	std::vector<int> m_objectIndices;
+	// SAH cost of the tree when it was built, and after the last refit
+	float m_builtCost;
+	float m_currentCost;
+
+	// split a node into two children, recursing until leaves are small
+	void Subdivide(int nodeIndex, int depth, const PACKED_BOUNDS& bounds, std::vector<glm::vec3>& centers);
+	// set a node box from the objects it holds
+	void UpdateLeafBounds(BVH_NODE& node, const PACKED_BOUNDS& bounds) const;
+	// surface area heuristic cost of the whole tree
+	float CalculateCost() const;
+};
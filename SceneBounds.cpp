@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////////////////////////////////////
+// SceneBounds.cpp
+// ===============
+// bounding volumes for the basic shape meshes and the scene objects
+// that are built from them
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBounds.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	// object space bounds of each shape, filled in as the meshes are loaded
+	BOUNDING_VOLUME g_ShapeBounds[SHAPE_COUNT];
+}
+
+/***********************************************************
+ *  ComputeBoundingVolume()
+ *
+ *  This function is used for calculating the axis-aligned
+ *  box and bounding sphere of interleaved vertex data. The
+ *  sphere is centered on the box so it stays stable for
+ *  symmetric meshes.
+ ***********************************************************/
+BOUNDING_VOLUME ComputeBoundingVolume(
+	const float* vertexData,
+	size_t vertexCount,
+	size_t floatsPerVertex)
+{
+	BOUNDING_VOLUME bounds;
+
+	if ((NULL == vertexData) || (vertexCount == 0))
+	{
+		return bounds;
+	}
+
+	glm::vec3 minXYZ(FLT_MAX);
+	glm::vec3 maxXYZ(-FLT_MAX);
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const float* position = vertexData + (i * floatsPerVertex);
+		glm::vec3 vertex(position[0], position[1], position[2]);
+
+		minXYZ = glm::min(minXYZ, vertex);
+		maxXYZ = glm::max(maxXYZ, vertex);
+	}
+
+	bounds.minXYZ = minXYZ;
+	bounds.maxXYZ = maxXYZ;
+	bounds.center = (minXYZ + maxXYZ) * 0.5f;
+
+	// the sphere only needs to reach the farthest vertex
+	float radiusSquared = 0.0f;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const float* position = vertexData + (i * floatsPerVertex);
+		glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - bounds.center;
+
+		radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.radius = sqrtf(radiusSquared);
+
+	return bounds;
+}
+
+/***********************************************************
+ *  TransformBoundingVolume()
+ *
+ *  This function is used for moving object space bounds into
+ *  world space. The box is rebuilt from the transformed center
+ *  and the absolute value of the rotation/scale part, so it
+ *  stays tight under rotation without touching all 8 corners.
+ ***********************************************************/
+BOUNDING_VOLUME TransformBoundingVolume(
+	const BOUNDING_VOLUME& localBounds,
+	const glm::mat4& modelMatrix)
+{
+	BOUNDING_VOLUME worldBounds;
+
+	glm::vec3 localCenter = (localBounds.minXYZ + localBounds.maxXYZ) * 0.5f;
+	glm::vec3 localExtents = (localBounds.maxXYZ - localBounds.minXYZ) * 0.5f;
+
+	glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(localCenter, 1.0f));
+	glm::vec3 worldExtents(0.0f);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		glm::vec3 column = glm::vec3(modelMatrix[axis]);
+		worldExtents += glm::abs(column) * localExtents[axis];
+	}
+
+	worldBounds.minXYZ = worldCenter - worldExtents;
+	worldBounds.maxXYZ = worldCenter + worldExtents;
+
+	// the sphere grows with the largest scale of the three axes
+	float maxScale = glm::max(
+		glm::length(glm::vec3(modelMatrix[0])),
+		glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+
+	worldBounds.center = glm::vec3(modelMatrix * glm::vec4(localBounds.center, 1.0f));
+	worldBounds.radius = localBounds.radius * maxScale;
+
+	return worldBounds;
+}
+
+/***********************************************************
+ *  MergeBoundingVolumes()
+ *
+ *  This function is used for building a bounding volume that
+ *  encloses two others.
+ ***********************************************************/
+BOUNDING_VOLUME MergeBoundingVolumes(
+	const BOUNDING_VOLUME& first,
+	const BOUNDING_VOLUME& second)
+{
+	BOUNDING_VOLUME merged;
+
+	merged.minXYZ = glm::min(first.minXYZ, second.minXYZ);
+	merged.maxXYZ = glm::max(first.maxXYZ, second.maxXYZ);
+
+	// smallest sphere around both spheres
+	glm::vec3 offset = second.center - first.center;
+	float distance = glm::length(offset);
+
+	if (distance + second.radius <= first.radius)
+	{
+		merged.center = first.center;
+		merged.radius = first.radius;
+	}
+	else if (distance + first.radius <= second.radius)
+	{
+		merged.center = second.center;
+		merged.radius = second.radius;
+	}
+	else
+	{
+		merged.radius = (distance + first.radius + second.radius) * 0.5f;
+		merged.center = first.center + offset * ((merged.radius - first.radius) / distance);
+	}
+
+	return merged;
+}
+
+/***********************************************************
+ *  RegisterShapeBounds()
+ *
+ *  This function is used for recording the object space
+ *  bounds of a shape mesh when it is loaded.
+ ***********************************************************/
+void RegisterShapeBounds(SHAPE_TYPE shape, const BOUNDING_VOLUME& bounds)
+{
+	if ((shape >= 0) && (shape < SHAPE_COUNT))
+	{
+		g_ShapeBounds[shape] = bounds;
+	}
+}
+
+/***********************************************************
+ *  GetShapeBounds()
+ *
+ *  This function is used for looking up the object space
+ *  bounds of a shape mesh.
+ ***********************************************************/
+const BOUNDING_VOLUME& GetShapeBounds(SHAPE_TYPE shape)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return g_ShapeBounds[SHAPE_BOX];
+	}
+
+	return g_ShapeBounds[shape];
+}
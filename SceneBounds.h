@@ -0,0 +1,65 @@
+/////////////////////////////////////////////////////////////////////////////////
+// SceneBounds.h
+// =============
+// bounding volumes for the basic shape meshes and the scene objects
+// that are built from them
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// identifies which of the basic shape meshes an object is drawn with
+enum SHAPE_TYPE
+{
+	SHAPE_BOX = 0,
+	SHAPE_CONE,
+	SHAPE_CYLINDER,
+	SHAPE_PLANE,
+	SHAPE_PRISM,
+	SHAPE_PYRAMID3,
+	SHAPE_PYRAMID4,
+	SHAPE_SPHERE,
+	SHAPE_TAPERED_CYLINDER,
+	SHAPE_TORUS,
+	SHAPE_COUNT
+};
+
+/***********************************************************
+ *  BOUNDING_VOLUME
+ *
+ *  Axis-aligned bounding box plus a bounding sphere. The
+ *  box is the tighter volume for culling, the sphere is the
+ *  cheaper one for distance and radius checks.
+ ***********************************************************/
+struct BOUNDING_VOLUME
+{
+	glm::vec3 minXYZ = glm::vec3(0.0f);
+	glm::vec3 maxXYZ = glm::vec3(0.0f);
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+// compute the bounds of interleaved vertex data, where the
+// position is the first three floats of every vertex
+BOUNDING_VOLUME ComputeBoundingVolume(
+	const float* vertexData,
+	size_t vertexCount,
+	size_t floatsPerVertex);
+
+// transform object space bounds into world space
+BOUNDING_VOLUME TransformBoundingVolume(
+	const BOUNDING_VOLUME& localBounds,
+	const glm::mat4& modelMatrix);
+
+// merge two bounding volumes into one that encloses both
+BOUNDING_VOLUME MergeBoundingVolumes(
+	const BOUNDING_VOLUME& first,
+	const BOUNDING_VOLUME& second);
+
+// record the object space bounds of a loaded shape mesh
+void RegisterShapeBounds(SHAPE_TYPE shape, const BOUNDING_VOLUME& bounds);
+// get the object space bounds of a shape mesh
+const BOUNDING_VOLUME& GetShapeBounds(SHAPE_TYPE shape);
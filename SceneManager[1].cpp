@@ -1,511 +1,1909 @@
-/////////////////////////////////////////////////////////////////////////////////
-// SceneManager.cpp
-// ===============
-// Manage the loading and rendering of 3D scenes
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//  Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-/////////////////////////////////////////////////////////////////////////////////
-
-#include "SceneManager.h"
-
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#endif
-
-#include <glm/gtx/transform.hpp>
-#include <iostream>
-
-// Global shader uniform names
-namespace
-{
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
-}
-
-/***********************************************************
- *  SceneManager()
- *
- *  The constructor for the class
- ***********************************************************/
-SceneManager::SceneManager(ShaderManager* pShaderManager)
-	: m_pShaderManager(pShaderManager),
-	m_basicMeshes(nullptr),
-	m_loadedTextures(0)
-{
-	m_basicMeshes = new ShapeMeshes();
-}
-
-/***********************************************************
- *  ~SceneManager()
- *
- *  The destructor for the class
- ***********************************************************/
-SceneManager::~SceneManager()
-{
-	m_pShaderManager = NULL;
-
-	DestroyGLTextures();
-
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
-}
-
-/***********************************************************
- *  CreateGLTexture()
- *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// Safety: prevent overflow if too many textures are loaded
-	if (m_loadedTextures >= 16)
-	{
-		std::cout << "Texture limit reached (16). Could not load: " << filename << std::endl;
-		return false;
-	}
-
-	// Indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// Try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 0);
-
-	// If the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image: " << filename
-			<< ", width: " << width
-			<< ", height: " << height
-			<< ", channels: " << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// Set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		// Set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// Upload to GPU (format depends on channels)
-		if (colorChannels == 3)
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		}
-		else if (colorChannels == 4)
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		}
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels: " << filename << std::endl;
-			stbi_image_free(image);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			return false;
-		}
-
-		// Generate mipmaps
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// Free local image data
-		stbi_image_free(image);
-
-		// Unbind texture
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		// Register the loaded texture and associate it with the tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
-
-		return true;
-	}
-
-	std::cout << "Could not load image: " << filename << std::endl;
-	return false;
-}
-
-/***********************************************************
- *  BindGLTextures()
- *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots. There are up to 16 slots.
- ***********************************************************/
-void SceneManager::BindGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  DestroyGLTextures()
- *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
- ***********************************************************/
-void SceneManager::DestroyGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		if (m_textureIDs[i].ID != 0)
-		{
-			glDeleteTextures(1, &m_textureIDs[i].ID);
-			m_textureIDs[i].ID = 0;
-			m_textureIDs[i].tag = "";
-		}
-	}
-	m_loadedTextures = 0;
-}
-
-/***********************************************************
- *  FindTextureID()
- ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
-{
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return textureID;
-}
-
-/***********************************************************
- *  FindTextureSlot()
- ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
-{
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return textureSlot;
-}
-
-/***********************************************************
- *  FindMaterial()
- ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
-{
-	if (m_objectMaterials.size() == 0)
-	{
-		return false;
-	}
-
-	for (size_t i = 0; i < m_objectMaterials.size(); i++)
-	{
-		if (m_objectMaterials[i].tag.compare(tag) == 0)
-		{
-			material.ambientColor = m_objectMaterials[i].ambientColor;
-			material.ambientStrength = m_objectMaterials[i].ambientStrength;
-			material.diffuseColor = m_objectMaterials[i].diffuseColor;
-			material.specularColor = m_objectMaterials[i].specularColor;
-			material.shininess = m_objectMaterials[i].shininess;
-			return true;
-		}
-	}
-
-	return false;
-}
-
-/***********************************************************
- *  SetTransformations()
- ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
-{
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	scale = glm::scale(scaleXYZ);
-
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-
-	translation = glm::translate(positionXYZ);
-
-	// Order used by this template (matches class sample)
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
-}
-
-/***********************************************************
- *  SetShaderColor()
- ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
-{
-	glm::vec4 currentColor;
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, 0);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
-}
-
-/***********************************************************
- *  SetShaderTexture()
- ***********************************************************/
-void SceneManager::SetShaderTexture(std::string textureTag)
-{
-	if (NULL != m_pShaderManager)
-	{
-		int textureSlot = FindTextureSlot(textureTag);
-
-		// Safety: if tag not found, disable texture so it doesn't go black
-		if (textureSlot < 0)
-		{
-			m_pShaderManager->setIntValue(g_UseTextureName, 0);
-			return;
-		}
-
-		m_pShaderManager->setIntValue(g_UseTextureName, 1);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
-	}
-}
-
-/***********************************************************
- *  SetTextureUVScale()
- ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
-}
-
-/***********************************************************
- *  SetShaderMaterial()
- ***********************************************************/
-void SceneManager::SetShaderMaterial(std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-
-		if (FindMaterial(materialTag, material))
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-/***********************************************************
- *  SetShaderLights()
- *
- *  Sends scene light uniforms to the shader.
- ***********************************************************/
-void SceneManager::SetShaderLights()
-{
-	// Camera position for specular highlights
-	// Replace this with your real camera position variable if different
-	m_pShaderManager->setVec3Value("viewPosition", glm::vec3(0.0f, 3.0f, 8.0f));
-
-	// Make sure lighting is enabled when needed (set these near the draw call too)
-	// m_pShaderManager->setBoolValue("bUseLighting", true);
-	// m_pShaderManager->setBoolValue("bUseTexture", true);
-
-	// ---------- Light 0, key point light (above and slightly in front) ----------
-	m_pShaderManager->setVec3Value("lightSources[0].position", glm::vec3(0.0f, 3.0f, 2.0f));
-
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", glm::vec3(0.10f, 0.10f, 0.10f));
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", glm::vec3(0.95f, 0.90f, 0.80f));
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", glm::vec3(1.00f, 1.00f, 1.00f));
-
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.60f);
-
-	// Attenuation (room-like falloff)
-	m_pShaderManager->setFloatValue("lightSources[0].constant", 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].linear", 0.09f);
-	m_pShaderManager->setFloatValue("lightSources[0].quadratic", 0.032f);
-
-	// ---------- Light 1, fill point light (keeps plane from going black) ----------
-	m_pShaderManager->setVec3Value("lightSources[1].position", glm::vec3(-3.0f, 2.0f, -2.0f));
-
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", glm::vec3(0.14f, 0.14f, 0.14f));
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", glm::vec3(0.35f, 0.35f, 0.40f));
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", glm::vec3(0.40f, 0.40f, 0.40f));
-
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 16.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.20f);
-
-	m_pShaderManager->setFloatValue("lightSources[1].constant", 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].linear", 0.09f);
-	m_pShaderManager->setFloatValue("lightSources[1].quadratic", 0.032f);
-
-	// ---------- Lights 2 and 3, disabled ----------
-	for (int i = 2; i < 4; ++i)
-	{
-		std::string idx = std::to_string(i);
-
-		m_pShaderManager->setVec3Value(("lightSources[" + idx + "].position").c_str(), glm::vec3(0.0f));
-		m_pShaderManager->setVec3Value(("lightSources[" + idx + "].ambientColor").c_str(), glm::vec3(0.0f));
-		m_pShaderManager->setVec3Value(("lightSources[" + idx + "].diffuseColor").c_str(), glm::vec3(0.0f));
-		m_pShaderManager->setVec3Value(("lightSources[" + idx + "].specularColor").c_str(), glm::vec3(0.0f));
-
-		m_pShaderManager->setFloatValue(("lightSources[" + idx + "].focalStrength").c_str(), 1.0f);
-		m_pShaderManager->setFloatValue(("lightSources[" + idx + "].specularIntensity").c_str(), 0.0f);
-
-		// Safe attenuation (doesn't matter since colors are zero)
-		m_pShaderManager->setFloatValue(("lightSources[" + idx + "].constant").c_str(), 1.0f);
-		m_pShaderManager->setFloatValue(("lightSources[" + idx + "].linear").c_str(), 0.0f);
-		m_pShaderManager->setFloatValue(("lightSources[" + idx + "].quadratic").c_str(), 0.0f);
-	}
-}
-
-/***********************************************************
- * PrepareScene()
- ***********************************************************/
-void SceneManager::PrepareScene()
-{
-	// Load textures (tags must match what you use later)
-	CreateGLTexture("Resources/Textures/wood.png", "wood");
-	CreateGLTexture("Resources/Textures/ceramic.png", "ceramic");
-
-	// Bind all loaded textures to texture units (GL_TEXTURE0, GL_TEXTURE1, ...)
-	BindGLTextures();
-
-	// Load meshes
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
-}
-
-/***********************************************************
- * RenderScene()
- ***********************************************************/
-void SceneManager::RenderScene()
-{
-	// Make sure the correct shader program is active each frame
-	m_pShaderManager->use();
-
-	// Send lights (including attenuation) and camera position to the shader
-	SetShaderLights();
-
-	glm::vec3 scaleXYZ;
-	glm::vec3 positionXYZ;
-
-	/******************************************************************/
-	// Desk / Floor (WOOD TEXTURE, TILED)
-	/******************************************************************/
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("wood");
-	SetTextureUVScale(6.0f, 3.0f); // tiling technique, adjust to taste
-	m_basicMeshes->DrawPlaneMesh();
-
-	/******************************************************************/
-	// Coffee Mug (2 shapes)
-	/******************************************************************/
-	const float mugX = 0.0f;
-	const float mugZ = -2.8f;
-	const float mugYaw = -20.0f;
-
-	/********************/
-	/* Mug Body (CERAMIC)
-	/********************/
-	scaleXYZ = glm::vec3(1.15f, 1.65f, 1.15f);
-	const float bodyHalfHeight = scaleXYZ.y * 0.5f;
-
-	// Put bottom of mug on the plane (y = 0)
-	positionXYZ = glm::vec3(mugX, bodyHalfHeight, mugZ);
-
-	SetTransformations(scaleXYZ, 0.0f, mugYaw, 0.0f, positionXYZ);
-
-	// Texture on body
-	SetShaderTexture("ceramic");
-	SetTextureUVScale(2.0f, 2.0f);
-	m_basicMeshes->DrawTaperedCylinderMesh();
-
-	/********************/
-	/* Handle (COLOR)
-	/********************/
-	scaleXYZ = glm::vec3(0.55f, 0.75f, 0.22f);
-
-	const float xRotationDegrees = 0.0f;
-	const float yRotationDegrees = mugYaw;
-	const float zRotationDegrees = 90.0f;
-
-	positionXYZ = glm::vec3(
-		mugX + 0.98f,               // offset out from the mug body
-		bodyHalfHeight + 0.45f,     // raise to mid-upper body
-		mugZ + 0.08f                // small forward offset to avoid z-fighting
-	);
-
-	SetTransformations(scaleXYZ, xRotationDegrees, yRotationDegrees, zRotationDegrees, positionXYZ);
-
-	// Solid color on handle (turns texture off inside SetShaderColor)
-	SetShaderColor(0.98f, 0.55f, 0.15f, 1.0f);
-	m_basicMeshes->DrawTorusMesh();
-}
\ No newline at end of file
+/////////////////////////////////////////////////////////////////////////////////
+// SceneManager.cpp
+// ===============
+// Manage the loading and rendering of 3D scenes
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//  Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "SceneManager.h"
+#include "Profiler.h"
+#include "StartupReport.h"
+#include "RenderStats.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#endif
+
+#include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Global shader uniform names
+namespace
+{
+	const char* g_ModelName = "model";
+	const char* g_ColorValueName = "objectColor";
+	const char* g_TextureValueName = "objectTexture";
+	const char* g_UseTextureName = "bUseTexture";
+	const char* g_UseLightingName = "bUseLighting";
+	const char* g_ViewName = "view";
+	const char* g_ProjectionName = "projection";
+
+	// image files loaded as textures by PrepareScene()
+	struct SCENE_TEXTURE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const SCENE_TEXTURE g_SceneTextures[] =
+	{
+		{ "Resources/Textures/wood.png", "wood" },
+		{ "Resources/Textures/ceramic.png", "ceramic" },
+	};
+
+	// below this many objects a linear SIMD frustum test beats the BVH walk
+	const size_t g_BVHCullMinObjects = 64;
+	// eye position for the specular highlights of every view
+	const glm::vec3 g_SpecularViewPosition = glm::vec3(0.0f, 3.0f, 8.0f);
+	// light contributions dimmer than this are treated as out of reach
+	const float g_LightCutoff = 1.0f / 256.0f;
+	// size of the CPU depth buffer used for occlusion culling
+	const int g_OcclusionBufferWidth = 256;
+	const int g_OcclusionBufferHeight = 200;
+
+	// from this many objects culling, sorting and packet building are split
+	// into chunks run on the job system
+	const size_t g_ParallelSceneMinObjects = 4096;
+	// objects per culling chunk, a multiple of the 4 boxes tested at once
+	const size_t g_CullChunkObjects = 2048;
+	// draw list entries per radix sort and packet chunk
+	const size_t g_SortChunkEntries = 4096;
+	// materials that fit the 16 bit material field of a draw sort key
+	const int g_SortKeyMaterialLimit = 0xFFFF;
+
+	// stress scene objects are spread through this box, in front of the start camera
+	const glm::vec3 g_StressFieldMin = glm::vec3(-8.0f, 0.0f, -16.0f);
+	const glm::vec3 g_StressFieldMax = glm::vec3(8.0f, 8.0f, 0.0f);
+	// materials the stress scene objects pick from
+	const int g_StressMaterialCount = 16;
+
+	/***********************************************************
+	 *  NextStressRandom()
+	 *
+	 *  A small generator of our own rather than <random>, whose
+	 *  distributions differ between standard libraries, so a
+	 *  seed gives the same stress scene on every platform.
+	 ***********************************************************/
+	float NextStressRandom(uint32_t& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (float)(state >> 8) / 16777216.0f;
+	}
+
+	/***********************************************************
+	 *  UseParallelChunks()
+	 *
+	 *  Below the threshold, or without job workers, handing out
+	 *  chunks costs more than it saves.
+	 ***********************************************************/
+	bool UseParallelChunks(size_t count)
+	{
+		return (count >= g_ParallelSceneMinObjects) && (JobSystem::GetWorkerCount() > 0);
+	}
+
+	// uniform names for each light source field, built once
+	struct LIGHT_UNIFORM_NAMES
+	{
+		std::string position;
+		std::string ambientColor;
+		std::string diffuseColor;
+		std::string specularColor;
+		std::string focalStrength;
+		std::string specularIntensity;
+		std::string constant;
+		std::string linear;
+		std::string quadratic;
+	};
+
+	const LIGHT_UNIFORM_NAMES& GetLightUniformNames(int lightIndex)
+	{
+		static LIGHT_UNIFORM_NAMES names[SceneManager::MAX_LIGHT_SOURCES];
+		static bool bNamesBuilt = false;
+
+		if (bNamesBuilt == false)
+		{
+			for (int i = 0; i < SceneManager::MAX_LIGHT_SOURCES; ++i)
+			{
+				std::string prefix = "lightSources[" + std::to_string(i) + "].";
+
+				names[i].position = prefix + "position";
+				names[i].ambientColor = prefix + "ambientColor";
+				names[i].diffuseColor = prefix + "diffuseColor";
+				names[i].specularColor = prefix + "specularColor";
+				names[i].focalStrength = prefix + "focalStrength";
+				names[i].specularIntensity = prefix + "specularIntensity";
+				names[i].constant = prefix + "constant";
+				names[i].linear = prefix + "linear";
+				names[i].quadratic = prefix + "quadratic";
+			}
+			bNamesBuilt = true;
+		}
+
+		return names[lightIndex];
+	}
+}
+
+/***********************************************************
+ *  SceneManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneManager::SceneManager(ShaderManager* pShaderManager)
+	: m_pShaderManager(pShaderManager),
+	m_basicMeshes(nullptr),
+	m_loadedTextures(0)
+{
+	m_basicMeshes = new ShapeMeshes();
+	m_occlusionBuffer.Initialize(g_OcclusionBufferWidth, g_OcclusionBufferHeight);
+
+	// Indicate to always flip images vertically when loaded; this is a
+	// global stb_image setting, so it is set once before any decode starts
+	stbi_set_flip_vertically_on_load(true);
+}
+
+/***********************************************************
+ *  ~SceneManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneManager::~SceneManager()
+{
+	m_pShaderManager = NULL;
+
+	// free any early decodes that PrepareScene() never used
+	for (size_t i = 0; i < m_pendingTextureDecodes.size(); i++)
+	{
+		JobSystem::Wait(m_pendingTextureDecodes[i].job);
+		if (m_pendingTextureDecodes[i].pImage->pixels)
+		{
+			stbi_image_free(m_pendingTextureDecodes[i].pImage->pixels);
+		}
+	}
+	m_pendingTextureDecodes.clear();
+
+	DestroyGLTextures();
+
+	delete m_basicMeshes;
+	m_basicMeshes = NULL;
+}
+
+/***********************************************************
+ *  BeginTextureDecodes()
+ *
+ *  This method is used for decoding the scene textures as
+ *  jobs while the window and OpenGL context are still being
+ *  created. Only the file reading and decoding
+ *  happen early; the upload still waits for PrepareScene().
+ ***********************************************************/
+void SceneManager::BeginTextureDecodes()
+{
+	for (size_t i = 0; i < sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]); i++)
+	{
+		PENDING_TEXTURE_DECODE decode;
+		decode.filename = g_SceneTextures[i].filename;
+		decode.pImage = std::make_shared<DECODED_IMAGE>();
+
+		std::shared_ptr<DECODED_IMAGE> pImage = decode.pImage;
+		std::string filename = decode.filename;
+		decode.job = JobSystem::Submit([pImage, filename]() { *pImage = DecodeTextureImage(filename); });
+		m_pendingTextureDecodes.push_back(decode);
+	}
+}
+
+/***********************************************************
+ *  DecodeTextureImage()
+ ***********************************************************/
+SceneManager::DECODED_IMAGE SceneManager::DecodeTextureImage(std::string filename)
+{
+	STARTUP_PHASE("DecodeTexture");
+
+	DECODED_IMAGE image;
+	image.pixels = stbi_load(filename.c_str(), &image.width, &image.height, &image.colorChannels, 0);
+	return image;
+}
+
+/***********************************************************
+ *  GetSceneTextureFilename()
+ ***********************************************************/
+const char* SceneManager::GetSceneTextureFilename(int textureIndex)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)(sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]))))
+	{
+		return NULL;
+	}
+
+	return g_SceneTextures[textureIndex].filename;
+}
+
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for loading textures from image files,
+ *  configuring the texture mapping parameters in OpenGL,
+ *  generating the mipmaps, and loading the read texture into
+ *  the next available texture slot in memory. An image that
+ *  BeginTextureDecodes() already started decoding is taken
+ *  from its job instead of being decoded again.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+{
+	STARTUP_PHASE("CreateGLTexture");
+
+	// Safety: prevent overflow if too many textures are loaded
+	if (m_loadedTextures >= 16)
+	{
+		std::cout << "Texture limit reached (16). Could not load: " << filename << std::endl;
+		return false;
+	}
+
+	// Try to parse the image data from the specified image file
+	DECODED_IMAGE image;
+	bool bDecoded = false;
+	for (size_t i = 0; i < m_pendingTextureDecodes.size(); i++)
+	{
+		if (m_pendingTextureDecodes[i].filename == filename)
+		{
+			JobSystem::Wait(m_pendingTextureDecodes[i].job);
+			image = *m_pendingTextureDecodes[i].pImage;
+			m_pendingTextureDecodes.erase(m_pendingTextureDecodes.begin() + i);
+			bDecoded = true;
+			break;
+		}
+	}
+	if (bDecoded == false)
+	{
+		image = DecodeTextureImage(filename);
+	}
+
+	return UploadGLTexture(image, filename, tag);
+}
+
+/***********************************************************
+ *  UploadGLTexture()
+ ***********************************************************/
+bool SceneManager::UploadGLTexture(DECODED_IMAGE& image, const char* filename, std::string tag)
+{
+	int width = image.width;
+	int height = image.height;
+	int colorChannels = image.colorChannels;
+	GLuint textureID = 0;
+
+	// If the image was successfully read from the image file
+	if (image.pixels)
+	{
+		std::cout << "Successfully loaded image: " << filename
+			<< ", width: " << width
+			<< ", height: " << height
+			<< ", channels: " << colorChannels << std::endl;
+
+		glGenTextures(1, &textureID);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		RenderStats::AddTextureBind();
+
+		// Set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		// Set texture filtering parameters
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// Upload to GPU (format depends on channels)
+		if (colorChannels == 3)
+		{
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels);
+			RenderStats::AddUploadBytes((size_t)width * height * 3);
+		}
+		else if (colorChannels == 4)
+		{
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+			RenderStats::AddUploadBytes((size_t)width * height * 4);
+		}
+		else
+		{
+			std::cout << "Not implemented to handle image with " << colorChannels << " channels: " << filename << std::endl;
+			stbi_image_free(image.pixels);
+			image.pixels = nullptr;
+			glBindTexture(GL_TEXTURE_2D, 0);
+			return false;
+		}
+
+		// Generate mipmaps
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		// Free local image data
+		stbi_image_free(image.pixels);
+		image.pixels = nullptr;
+
+		// Unbind texture
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// Register the loaded texture and associate it with the tag string
+		m_textureIDs[m_loadedTextures].ID = textureID;
+		m_textureIDs[m_loadedTextures].tag = tag;
+		m_loadedTextures++;
+
+		return true;
+	}
+
+	std::cout << "Could not load image: " << filename << std::endl;
+	return false;
+}
+
+/***********************************************************
+ *  BindGLTextures()
+ *
+ *  This method is used for binding the loaded textures to
+ *  OpenGL texture memory slots. There are up to 16 slots.
+ ***********************************************************/
+void SceneManager::BindGLTextures()
+{
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		RenderStats::AddTextureBind();
+	}
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the memory in all the
+ *  used texture memory slots.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if (m_textureIDs[i].ID != 0)
+		{
+			glDeleteTextures(1, &m_textureIDs[i].ID);
+			m_textureIDs[i].ID = 0;
+			m_textureIDs[i].tag = "";
+		}
+	}
+	m_loadedTextures = 0;
+}
+
+/***********************************************************
+ *  FindTextureID()
+ ***********************************************************/
+int SceneManager::FindTextureID(std::string tag)
+{
+	int textureID = -1;
+	int index = 0;
+	bool bFound = false;
+
+	while ((index < m_loadedTextures) && (bFound == false))
+	{
+		if (m_textureIDs[index].tag.compare(tag) == 0)
+		{
+			textureID = m_textureIDs[index].ID;
+			bFound = true;
+		}
+		else
+		{
+			index++;
+		}
+	}
+
+	return textureID;
+}
+
+/***********************************************************
+ *  FindTextureSlot()
+ ***********************************************************/
+int SceneManager::FindTextureSlot(std::string tag)
+{
+	int textureSlot = -1;
+	int index = 0;
+	bool bFound = false;
+
+	while ((index < m_loadedTextures) && (bFound == false))
+	{
+		if (m_textureIDs[index].tag.compare(tag) == 0)
+		{
+			textureSlot = index;
+			bFound = true;
+		}
+		else
+		{
+			index++;
+		}
+	}
+
+	return textureSlot;
+}
+
+/***********************************************************
+ *  FindMaterial()
+ ***********************************************************/
+bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+{
+	if (m_objectMaterials.size() == 0)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		if (m_objectMaterials[i].tag.compare(tag) == 0)
+		{
+			material.ambientColor = m_objectMaterials[i].ambientColor;
+			material.ambientStrength = m_objectMaterials[i].ambientStrength;
+			material.diffuseColor = m_objectMaterials[i].diffuseColor;
+			material.specularColor = m_objectMaterials[i].specularColor;
+			material.shininess = m_objectMaterials[i].shininess;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for combining the scale, rotation and
+ *  translation values into a single model matrix.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 scale;
+	glm::mat4 rotationX;
+	glm::mat4 rotationY;
+	glm::mat4 rotationZ;
+	glm::mat4 translation;
+
+	scale = glm::scale(scaleXYZ);
+
+	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	translation = glm::translate(positionXYZ);
+
+	// Order used by this template (matches class sample)
+	return translation * rotationX * rotationY * rotationZ * scale;
+}
+
+/***********************************************************
+ *  SetTransformations()
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 modelView = BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		RenderStats::AddUniformUpdates(1);
+	}
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	glm::vec4 currentColor;
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setIntValue(g_UseTextureName, 0);
+		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		RenderStats::AddUniformUpdates(2);
+	}
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ ***********************************************************/
+void SceneManager::SetShaderTexture(std::string textureTag)
+{
+	if (NULL != m_pShaderManager)
+	{
+		int textureSlot = FindTextureSlot(textureTag);
+
+		// Safety: if tag not found, disable texture so it doesn't go black
+		if (textureSlot < 0)
+		{
+			m_pShaderManager->setIntValue(g_UseTextureName, 0);
+			RenderStats::AddUniformUpdates(1);
+			return;
+		}
+
+		m_pShaderManager->setIntValue(g_UseTextureName, 1);
+		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+		RenderStats::AddUniformUpdates(2);
+	}
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		RenderStats::AddUniformUpdates(1);
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(std::string materialTag)
+{
+	if (m_objectMaterials.size() > 0)
+	{
+		OBJECT_MATERIAL material;
+
+		if (FindMaterial(materialTag, material))
+		{
+			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
+			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
+			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
+			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
+			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			RenderStats::AddUniformUpdates(5);
+		}
+	}
+}
+
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding an object to the scene. The
+ *  model matrix and world space bounds are calculated once
+ *  here instead of every frame.
+ ***********************************************************/
+int SceneManager::AddSceneObject(
+	SHAPE_TYPE shape,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	SCENE_OBJECT object;
+	object.shape = shape;
+
+	m_sceneObjects.push_back(object);
+	int objectIndex = static_cast<int>(m_sceneObjects.size()) - 1;
+
+	// keep the packed bounds the same size as the object list
+	m_packedBounds.Resize(m_sceneObjects.size());
+	m_bSceneStructureDirty = true;
+
+	SetObjectTransformations(
+		objectIndex,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	return objectIndex;
+}
+
+/***********************************************************
+ *  SetObjectTransformations()
+ ***********************************************************/
+void SceneManager::SetObjectTransformations(
+	int objectIndex,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((objectIndex < 0) || (objectIndex >= static_cast<int>(m_sceneObjects.size())))
+	{
+		return;
+	}
+
+	SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+	object.scaleXYZ = scaleXYZ;
+	object.rotationDegrees = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	object.positionXYZ = positionXYZ;
+
+	UpdateObjectBounds(objectIndex);
+}
+
+/***********************************************************
+ *  SetObjectTexture()
+ ***********************************************************/
+void SceneManager::SetObjectTexture(int objectIndex, std::string textureTag, float u, float v)
+{
+	if ((objectIndex < 0) || (objectIndex >= static_cast<int>(m_sceneObjects.size())))
+	{
+		return;
+	}
+
+	m_sceneObjects[objectIndex].textureSlot = FindTextureSlot(textureTag);
+	m_sceneObjects[objectIndex].uvScale = glm::vec2(u, v);
+	m_bRedrawNeeded = true;
+}
+
+/***********************************************************
+ *  SetObjectColor()
+ ***********************************************************/
+void SceneManager::SetObjectColor(int objectIndex, float red, float green, float blue, float alpha)
+{
+	if ((objectIndex < 0) || (objectIndex >= static_cast<int>(m_sceneObjects.size())))
+	{
+		return;
+	}
+
+	m_sceneObjects[objectIndex].textureSlot = -1;
+	m_sceneObjects[objectIndex].color = glm::vec4(red, green, blue, alpha);
+	m_bRedrawNeeded = true;
+}
+
+/***********************************************************
+ *  SetObjectMaterial()
+ ***********************************************************/
+void SceneManager::SetObjectMaterial(int objectIndex, std::string materialTag)
+{
+	if ((objectIndex < 0) || (objectIndex >= static_cast<int>(m_sceneObjects.size())))
+	{
+		return;
+	}
+
+	m_sceneObjects[objectIndex].materialIndex = -1;
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		if (m_objectMaterials[i].tag.compare(materialTag) == 0)
+		{
+			m_sceneObjects[objectIndex].materialIndex = static_cast<int>(i);
+			break;
+		}
+	}
+	m_bRedrawNeeded = true;
+}
+
+/***********************************************************
+ *  UpdateObjectBounds()
+ *
+ *  This method is used for recalculating the cached model
+ *  matrix and world space bounds of an object after its
+ *  transformation values have changed.
+ ***********************************************************/
+void SceneManager::UpdateObjectBounds(int objectIndex)
+{
+	SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+
+	object.modelMatrix = BuildModelMatrix(
+		object.scaleXYZ,
+		object.rotationDegrees.x,
+		object.rotationDegrees.y,
+		object.rotationDegrees.z,
+		object.positionXYZ);
+
+	object.worldBounds = TransformBoundingVolume(
+		GetShapeBounds(object.shape),
+		object.modelMatrix);
+
+	m_packedBounds.Set(objectIndex, object.worldBounds);
+	m_bSceneBoundsDirty = true;
+	m_bRedrawNeeded = true;
+}
+
+/***********************************************************
+ *  SetObjectOccluder()
+ *
+ *  Only boxes and planes can occlude, since their bounds are
+ *  exactly their surfaces; round shapes would hide objects
+ *  that show past their curved edges.
+ ***********************************************************/
+void SceneManager::SetObjectOccluder(int objectIndex, bool bOccluder)
+{
+	if ((objectIndex < 0) || (objectIndex >= static_cast<int>(m_sceneObjects.size())))
+	{
+		return;
+	}
+
+	SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+	object.bOccluder = bOccluder && ((object.shape == SHAPE_BOX) || (object.shape == SHAPE_PLANE));
+}
+
+/***********************************************************
+ *  SetCullingView()
+ *
+ *  This method is used for setting the view frustum and the
+ *  view-projection matrix that the scene objects are culled
+ *  against in RenderScene().
+ ***********************************************************/
+void SceneManager::SetCullingView(const ViewFrustum& frustum, const glm::mat4& viewProjection)
+{
+	m_cullingFrustum = frustum;
+	m_viewProjection = viewProjection;
+}
+
+/***********************************************************
+ *  CullOccludedObjects()
+ *
+ *  This method is used for the CPU occlusion pass that runs
+ *  after frustum culling. The visible occluders are drawn into
+ *  the low resolution depth buffer, then every other visible
+ *  object is kept only if some of its box is not behind them.
+ ***********************************************************/
+void SceneManager::CullOccludedObjects()
+{
+	bool bHasOccluders = false;
+
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_visibleObjects[i]];
+
+		if (object.bOccluder)
+		{
+			if (bHasOccluders == false)
+			{
+				m_occlusionBuffer.Clear();
+				bHasOccluders = true;
+			}
+
+			const BOUNDING_VOLUME& localBounds = GetShapeBounds(object.shape);
+			m_occlusionBuffer.RasterizeBox(
+				m_viewProjection * object.modelMatrix,
+				localBounds.minXYZ,
+				localBounds.maxXYZ);
+		}
+	}
+
+	if (bHasOccluders == false)
+	{
+		return;
+	}
+
+	size_t keptCount = 0;
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_visibleObjects[i]];
+
+		if (object.bOccluder ||
+			m_occlusionBuffer.TestBox(m_viewProjection, object.worldBounds.minXYZ, object.worldBounds.maxXYZ))
+		{
+			m_visibleObjects[keptCount++] = m_visibleObjects[i];
+		}
+	}
+	m_visibleObjects.resize(keptCount);
+}
+
+/***********************************************************
+ *  DrawSceneObject()
+ *
+ *  This method is used for sending the model matrix, texture
+ *  or color, and material of an object to the shader and then
+ *  drawing its mesh.
+ ***********************************************************/
+void SceneManager::DrawSceneObject(const SCENE_OBJECT& object)
+{
+	DrawObject(
+		object.shape,
+		object.modelMatrix,
+		object.textureSlot,
+		object.uvScale,
+		object.color,
+		object.materialIndex);
+}
+
+/***********************************************************
+ *  DrawObject()
+ *
+ *  This method is used for drawing one mesh with the given
+ *  shader values, whether they come from a scene object or
+ *  from a draw packet built on another thread.
+ ***********************************************************/
+void SceneManager::DrawObject(
+	SHAPE_TYPE shape,
+	const glm::mat4& modelMatrix,
+	int textureSlot,
+	const glm::vec2& uvScale,
+	const glm::vec4& color,
+	int materialIndex)
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	m_pShaderManager->setMat4Value(g_ModelName, modelMatrix);
+	RenderStats::AddUniformUpdates(1);
+
+	if (textureSlot >= 0)
+	{
+		m_pShaderManager->setIntValue(g_UseTextureName, 1);
+		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+		RenderStats::AddUniformUpdates(2);
+		SetTextureUVScale(uvScale.x, uvScale.y);
+	}
+	else
+	{
+		SetShaderColor(color.r, color.g, color.b, color.a);
+	}
+
+	// objects are sorted by material, so most draws can keep the last one
+	if ((materialIndex >= 0) && (materialIndex != m_lastMaterialIndex))
+	{
+		m_lastMaterialIndex = materialIndex;
+		const OBJECT_MATERIAL& material = m_objectMaterials[materialIndex];
+
+		m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
+		m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
+		m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
+		m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
+		m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+		RenderStats::AddUniformUpdates(5);
+	}
+
+	DrawShapeMesh(shape);
+}
+
+/***********************************************************
+ *  DrawShapeMesh()
+ ***********************************************************/
+void SceneManager::DrawShapeMesh(SHAPE_TYPE shape)
+{
+	switch (shape)
+	{
+	case SHAPE_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case SHAPE_CONE:
+		m_basicMeshes->DrawConeMesh();
+		break;
+	case SHAPE_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case SHAPE_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case SHAPE_PRISM:
+		m_basicMeshes->DrawPrismMesh();
+		break;
+	case SHAPE_PYRAMID3:
+		m_basicMeshes->DrawPyramid3Mesh();
+		break;
+	case SHAPE_PYRAMID4:
+		m_basicMeshes->DrawPyramid4Mesh();
+		break;
+	case SHAPE_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case SHAPE_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh();
+		break;
+	case SHAPE_TORUS:
+		m_basicMeshes->DrawTorusMesh();
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  UpdateSceneBVH()
+ *
+ *  This method is used for bringing the BVH up to date with
+ *  the scene objects. Added objects need a full build; moved
+ *  objects only refit the node boxes, unless the refit tree
+ *  has become too loose and is worth rebuilding.
+ ***********************************************************/
+void SceneManager::UpdateSceneBVH()
+{
+	bool bChanged = false;
+
+	if (m_bSceneStructureDirty)
+	{
+		m_sceneBVH.Build(m_packedBounds);
+		bChanged = true;
+	}
+	else if (m_bSceneBoundsDirty)
+	{
+		m_sceneBVH.Refit(m_packedBounds);
+		if (m_sceneBVH.NeedsRebuild())
+		{
+			m_sceneBVH.Build(m_packedBounds);
+		}
+		bChanged = true;
+	}
+
+	m_bSceneStructureDirty = false;
+	m_bSceneBoundsDirty = false;
+
+	if (bChanged || m_bLightsDirty)
+	{
+		AssignLightsToObjects();
+	}
+}
+
+/***********************************************************
+ *  AssignLightsToObjects()
+ *
+ *  This method is used for working out which objects each
+ *  light can reach. The reach is the distance at which the
+ *  attenuated light drops below a visible level, and the BVH
+ *  finds the objects inside that sphere.
+ ***********************************************************/
+void SceneManager::AssignLightsToObjects()
+{
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		m_sceneObjects[i].lightMask = 0;
+	}
+
+	std::vector<int> litObjects;
+
+	for (int lightIndex = 0; lightIndex < MAX_LIGHT_SOURCES; lightIndex++)
+	{
+		const LIGHT_SOURCE& light = m_lightSources[lightIndex];
+
+		glm::vec3 brightest = glm::max(light.ambientColor, glm::max(light.diffuseColor, light.specularColor));
+		float intensity = glm::max(brightest.x, glm::max(brightest.y, brightest.z));
+		if (intensity <= 0.0f)
+		{
+			continue;
+		}
+
+		// solve intensity / (constant + linear*d + quadratic*d^2) = cutoff for d
+		float target = intensity / g_LightCutoff;
+		float reach = 0.0f;
+		if (light.quadratic > 0.0f)
+		{
+			float c = light.constant - target;
+			float discriminant = (light.linear * light.linear) - (4.0f * light.quadratic * c);
+			reach = (-light.linear + sqrtf(glm::max(discriminant, 0.0f))) / (2.0f * light.quadratic);
+		}
+		else if (light.linear > 0.0f)
+		{
+			reach = (target - light.constant) / light.linear;
+		}
+		else
+		{
+			// no falloff, the light reaches everything
+			reach = 1.0e30f;
+		}
+
+		litObjects.clear();
+		m_sceneBVH.QuerySphere(light.position, reach, m_packedBounds, litObjects);
+
+		for (size_t i = 0; i < litObjects.size(); i++)
+		{
+			m_sceneObjects[litObjects[i]].lightMask |= (1u << lightIndex);
+		}
+	}
+
+	m_bLightsDirty = false;
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the nearest object whose
+ *  bounds are hit by a ray, such as one cast from the camera.
+ ***********************************************************/
+int SceneManager::PickObject(glm::vec3 rayOrigin, glm::vec3 rayDirection)
+{
+	UpdateSceneBVH();
+
+	float hitDistance = 0.0f;
+	return m_sceneBVH.QueryRay(rayOrigin, rayDirection, m_packedBounds, hitDistance);
+}
+
+/***********************************************************
+ *  DefineSceneLights()
+ *
+ *  This method is used for configuring the light sources
+ *  that are sent to the shader in SetShaderLights().
+ ***********************************************************/
+void SceneManager::DefineSceneLights()
+{
+	// ---------- Light 0, key point light (above and slightly in front) ----------
+	m_lightSources[0].position = glm::vec3(0.0f, 3.0f, 2.0f);
+
+	m_lightSources[0].ambientColor = glm::vec3(0.10f, 0.10f, 0.10f);
+	m_lightSources[0].diffuseColor = glm::vec3(0.95f, 0.90f, 0.80f);
+	m_lightSources[0].specularColor = glm::vec3(1.00f, 1.00f, 1.00f);
+
+	m_lightSources[0].focalStrength = 32.0f;
+	m_lightSources[0].specularIntensity = 0.60f;
+
+	// Attenuation (room-like falloff)
+	m_lightSources[0].constant = 1.0f;
+	m_lightSources[0].linear = 0.09f;
+	m_lightSources[0].quadratic = 0.032f;
+
+	// ---------- Light 1, fill point light (keeps plane from going black) ----------
+	m_lightSources[1].position = glm::vec3(-3.0f, 2.0f, -2.0f);
+
+	m_lightSources[1].ambientColor = glm::vec3(0.14f, 0.14f, 0.14f);
+	m_lightSources[1].diffuseColor = glm::vec3(0.35f, 0.35f, 0.40f);
+	m_lightSources[1].specularColor = glm::vec3(0.40f, 0.40f, 0.40f);
+
+	m_lightSources[1].focalStrength = 16.0f;
+	m_lightSources[1].specularIntensity = 0.20f;
+
+	m_lightSources[1].constant = 1.0f;
+	m_lightSources[1].linear = 0.09f;
+	m_lightSources[1].quadratic = 0.032f;
+
+	// ---------- Lights 2 and 3, disabled ----------
+	for (int i = 2; i < MAX_LIGHT_SOURCES; ++i)
+	{
+		// colors of zero switch the light off; attenuation doesn't matter
+		m_lightSources[i] = LIGHT_SOURCE();
+	}
+
+	m_bLightsDirty = true;
+	m_bRedrawNeeded = true;
+}
+
+/***********************************************************
+ *  SetShaderLights()
+ *
+ *  Sends scene light uniforms to the shader.
+ ***********************************************************/
+void SceneManager::SetShaderLights()
+{
+	PROFILE_SCOPE("SetShaderLights");
+
+	// Camera position for specular highlights
+	// Replace this with your real camera position variable if different
+	m_pShaderManager->setVec3Value("viewPosition", g_SpecularViewPosition);
+	RenderStats::AddUniformUpdates(1);
+
+	// Make sure lighting is enabled when needed (set these near the draw call too)
+	// m_pShaderManager->setBoolValue("bUseLighting", true);
+	// m_pShaderManager->setBoolValue("bUseTexture", true);
+
+	for (int i = 0; i < MAX_LIGHT_SOURCES; ++i)
+	{
+		const LIGHT_SOURCE& light = m_lightSources[i];
+		const LIGHT_UNIFORM_NAMES& names = GetLightUniformNames(i);
+
+		m_pShaderManager->setVec3Value(names.position.c_str(), light.position);
+		m_pShaderManager->setVec3Value(names.ambientColor.c_str(), light.ambientColor);
+		m_pShaderManager->setVec3Value(names.diffuseColor.c_str(), light.diffuseColor);
+		m_pShaderManager->setVec3Value(names.specularColor.c_str(), light.specularColor);
+
+		m_pShaderManager->setFloatValue(names.focalStrength.c_str(), light.focalStrength);
+		m_pShaderManager->setFloatValue(names.specularIntensity.c_str(), light.specularIntensity);
+
+		m_pShaderManager->setFloatValue(names.constant.c_str(), light.constant);
+		m_pShaderManager->setFloatValue(names.linear.c_str(), light.linear);
+		m_pShaderManager->setFloatValue(names.quadratic.c_str(), light.quadratic);
+		RenderStats::AddUniformUpdates(9);
+	}
+}
+
+/***********************************************************
+ * PrepareScene()
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	STARTUP_PHASE("PrepareScene");
+
+	// Load textures (tags must match what you use later)
+	for (size_t i = 0; i < sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]); i++)
+	{
+		CreateGLTexture(g_SceneTextures[i].filename, g_SceneTextures[i].tag);
+	}
+
+	// Bind all loaded textures to texture units (GL_TEXTURE0, GL_TEXTURE1, ...)
+	BindGLTextures();
+
+	// Key and fill lights
+	DefineSceneLights();
+
+	// Load meshes
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadTaperedCylinderMesh();
+	m_basicMeshes->LoadTorusMesh();
+
+	glm::vec3 scaleXYZ;
+	glm::vec3 positionXYZ;
+	int objectIndex = -1;
+
+	/******************************************************************/
+	// Desk / Floor (WOOD TEXTURE, TILED)
+	/******************************************************************/
+	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	objectIndex = AddSceneObject(SHAPE_PLANE, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
+	SetObjectTexture(objectIndex, "wood", 6.0f, 3.0f); // tiling technique, adjust to taste
+
+	// The desk hides everything underneath it
+	SetObjectOccluder(objectIndex, true);
+
+	/******************************************************************/
+	// Coffee Mug (2 shapes)
+	/******************************************************************/
+	const float mugX = 0.0f;
+	const float mugZ = -2.8f;
+	const float mugYaw = -20.0f;
+
+	/********************/
+	/* Mug Body (CERAMIC)
+	/********************/
+	scaleXYZ = glm::vec3(1.15f, 1.65f, 1.15f);
+	const float bodyHalfHeight = scaleXYZ.y * 0.5f;
+
+	// Put bottom of mug on the plane (y = 0)
+	positionXYZ = glm::vec3(mugX, bodyHalfHeight, mugZ);
+
+	objectIndex = AddSceneObject(SHAPE_TAPERED_CYLINDER, scaleXYZ, 0.0f, mugYaw, 0.0f, positionXYZ);
+
+	// Texture on body
+	SetObjectTexture(objectIndex, "ceramic", 2.0f, 2.0f);
+
+	/********************/
+	/* Handle (COLOR)
+	/********************/
+	scaleXYZ = glm::vec3(0.55f, 0.75f, 0.22f);
+
+	const float xRotationDegrees = 0.0f;
+	const float yRotationDegrees = mugYaw;
+	const float zRotationDegrees = 90.0f;
+
+	positionXYZ = glm::vec3(
+		mugX + 0.98f,               // offset out from the mug body
+		bodyHalfHeight + 0.45f,     // raise to mid-upper body
+		mugZ + 0.08f                // small forward offset to avoid z-fighting
+	);
+
+	objectIndex = AddSceneObject(SHAPE_TORUS, scaleXYZ, xRotationDegrees, yRotationDegrees, zRotationDegrees, positionXYZ);
+
+	// Solid color on handle (turns texture off inside SetShaderColor)
+	SetObjectColor(objectIndex, 0.98f, 0.55f, 0.15f, 1.0f);
+}
+
+/***********************************************************
+ *  PrepareStressScene()
+ *
+ *  This method is used for building a scene of any size to
+ *  find where rendering stops scaling. The scene textures and
+ *  every basic shape are loaded, then the objects are made by
+ *  ReplaceStressObjects().
+ ***********************************************************/
+void SceneManager::PrepareStressScene(int objectCount, unsigned int seed)
+{
+	STARTUP_PHASE("PrepareStressScene");
+
+	for (size_t i = 0; i < sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]); i++)
+	{
+		CreateGLTexture(g_SceneTextures[i].filename, g_SceneTextures[i].tag);
+	}
+	BindGLTextures();
+
+	DefineSceneLights();
+
+	m_basicMeshes->LoadBoxMesh();
+	m_basicMeshes->LoadConeMesh();
+	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadPrismMesh();
+	m_basicMeshes->LoadPyramid3Mesh();
+	m_basicMeshes->LoadPyramid4Mesh();
+	m_basicMeshes->LoadSphereMesh();
+	m_basicMeshes->LoadTaperedCylinderMesh();
+	m_basicMeshes->LoadTorusMesh();
+
+	ReplaceStressObjects(objectCount, seed);
+}
+
+/***********************************************************
+ *  ReplaceStressObjects()
+ *
+ *  This method is used for swapping the objects of a stress
+ *  scene for a new set, keeping the loaded meshes, textures
+ *  and lights. Each object gets a random shape, transform and
+ *  material, and either one of the scene textures or a solid
+ *  color. Objects shrink as the count grows, so the field
+ *  stays about as full and the pixels drawn stay similar;
+ *  part of it is outside the start view, so culling has work.
+ *  The random values are drawn one statement at a time, since
+ *  the order arguments are evaluated in is not fixed.
+ ***********************************************************/
+void SceneManager::ReplaceStressObjects(int objectCount, unsigned int seed)
+{
+	if (objectCount < MIN_STRESS_OBJECTS)
+	{
+		objectCount = MIN_STRESS_OBJECTS;
+	}
+	else if (objectCount > MAX_STRESS_OBJECTS)
+	{
+		objectCount = MAX_STRESS_OBJECTS;
+	}
+
+	// the BVH is rebuilt and the lights reassigned for the new objects
+	m_sceneObjects.clear();
+	m_visibleObjects.clear();
+	m_packedBounds.Resize(0);
+	m_bSceneStructureDirty = true;
+	m_bLightsDirty = true;
+
+	uint32_t randomState = seed;
+
+	m_objectMaterials.clear();
+	for (int i = 0; i < g_StressMaterialCount; i++)
+	{
+		OBJECT_MATERIAL material;
+		material.ambientStrength = 0.1f + 0.3f * NextStressRandom(randomState);
+		material.ambientColor = glm::vec3(1.0f);
+		material.diffuseColor = glm::vec3(0.5f + 0.5f * NextStressRandom(randomState));
+		material.specularColor = glm::vec3(NextStressRandom(randomState));
+		material.shininess = 2.0f + 62.0f * NextStressRandom(randomState);
+		material.tag = "stress" + std::to_string(i);
+		m_objectMaterials.push_back(material);
+	}
+
+	int textureSlots[2];
+	textureSlots[0] = FindTextureSlot("wood");
+	textureSlots[1] = FindTextureSlot("ceramic");
+
+	glm::vec3 fieldSize = g_StressFieldMax - g_StressFieldMin;
+	float cellSize = std::cbrt(fieldSize.x * fieldSize.y * fieldSize.z / (float)objectCount);
+
+	m_sceneObjects.reserve(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		SHAPE_TYPE shape = (SHAPE_TYPE)std::min((int)(NextStressRandom(randomState) * SHAPE_COUNT), SHAPE_COUNT - 1);
+
+		float size = cellSize * (0.3f + 0.5f * NextStressRandom(randomState));
+		glm::vec3 scaleXYZ;
+		scaleXYZ.x = size * (0.6f + 0.8f * NextStressRandom(randomState));
+		scaleXYZ.y = size * (0.6f + 0.8f * NextStressRandom(randomState));
+		scaleXYZ.z = size * (0.6f + 0.8f * NextStressRandom(randomState));
+
+		float XrotationDegrees = 360.0f * NextStressRandom(randomState);
+		float YrotationDegrees = 360.0f * NextStressRandom(randomState);
+		float ZrotationDegrees = 360.0f * NextStressRandom(randomState);
+
+		glm::vec3 positionXYZ;
+		positionXYZ.x = g_StressFieldMin.x + fieldSize.x * NextStressRandom(randomState);
+		positionXYZ.y = g_StressFieldMin.y + fieldSize.y * NextStressRandom(randomState);
+		positionXYZ.z = g_StressFieldMin.z + fieldSize.z * NextStressRandom(randomState);
+
+		int objectIndex = AddSceneObject(shape, scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+		SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+
+		// a third each wood, ceramic and solid color; the slots and material
+		// are set directly, since a lookup by tag per object adds up at a million
+		float look = NextStressRandom(randomState);
+		if (look < 2.0f / 3.0f)
+		{
+			float uvScale = 1.0f + 2.0f * NextStressRandom(randomState);
+			object.textureSlot = textureSlots[(look < 1.0f / 3.0f) ? 0 : 1];
+			object.uvScale = glm::vec2(uvScale, uvScale);
+		}
+		else
+		{
+			object.textureSlot = -1;
+			object.color.r = NextStressRandom(randomState);
+			object.color.g = NextStressRandom(randomState);
+			object.color.b = NextStressRandom(randomState);
+			object.color.a = 1.0f;
+		}
+		object.materialIndex = std::min((int)(NextStressRandom(randomState) * g_StressMaterialCount), g_StressMaterialCount - 1);
+	}
+
+	m_bRedrawNeeded = true;
+}
+
+/***********************************************************
+ * RenderScene()
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	PROFILE_SCOPE("RenderScene");
+
+	// Make sure the correct shader program is active each frame
+	m_pShaderManager->use();
+
+	// Send lights (including attenuation) and camera position to the shader
+	SetShaderLights();
+
+	// Bring the spatial index up to date with any moved objects
+	UpdateSceneBVH();
+
+	// Skip objects outside the view or hidden behind the large occluders
+	CullVisibleObjects();
+	SortDrawList(m_visibleObjects);
+
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->BeginPass("draw");
+	}
+
+	{
+		PROFILE_SCOPE("DrawObjects");
+		m_lastMaterialIndex = -1;
+		for (size_t i = 0; i < m_visibleObjects.size(); i++)
+		{
+			DrawSceneObject(m_sceneObjects[m_visibleObjects[i]]);
+		}
+	}
+
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->EndPass("draw");
+	}
+
+	m_bRedrawNeeded = false;
+}
+
+/***********************************************************
+ *  CullVisibleObjects()
+ *
+ *  This method is used for filling the visible object list
+ *  for the current culling view: objects outside the frustum
+ *  are skipped, then those hidden behind the occluders.
+ ***********************************************************/
+void SceneManager::CullVisibleObjects()
+{
+	// Skip every object whose bounds are outside the view frustum
+	{
+		PROFILE_SCOPE("FrustumCull");
+		m_visibleObjects.clear();
+		if (UseParallelChunks(m_sceneObjects.size()))
+		{
+			CullChunksInParallel();
+		}
+		else if (m_sceneObjects.size() < g_BVHCullMinObjects)
+		{
+			m_cullingFrustum.CullPackedBounds(m_packedBounds, m_visibleObjects);
+		}
+		else
+		{
+			m_sceneBVH.QueryFrustum(m_cullingFrustum, m_packedBounds, m_visibleObjects);
+		}
+	}
+
+	// Skip objects hidden behind the large occluders
+	if (m_bOcclusionCulling)
+	{
+		PROFILE_SCOPE("OcclusionCull");
+		CullOccludedObjects();
+	}
+}
+
+/***********************************************************
+ *  CullChunksInParallel()
+ *
+ *  This method is used for frustum culling a large scene on
+ *  the job system. Each chunk of the packed bounds is tested
+ *  with the linear SIMD loop into its own list, so no thread
+ *  shares an output; the lists are then copied one after the
+ *  other, keeping the visible objects in index order. With
+ *  every core busy this beats walking the BVH on one thread.
+ ***********************************************************/
+void SceneManager::CullChunksInParallel()
+{
+	size_t objectCount = m_packedBounds.count;
+	int chunkCount = (int)((objectCount + g_CullChunkObjects - 1) / g_CullChunkObjects);
+	if ((int)m_cullChunks.size() < chunkCount)
+	{
+		m_cullChunks.resize(chunkCount);
+	}
+
+	JobSystem::ParallelFor(chunkCount, [this, objectCount](int chunkIndex)
+		{
+			size_t firstIndex = chunkIndex * g_CullChunkObjects;
+			std::vector<int>& visibleObjects = m_cullChunks[chunkIndex].visibleObjects;
+			visibleObjects.clear();
+			m_cullingFrustum.CullPackedBounds(
+				m_packedBounds,
+				firstIndex,
+				std::min(firstIndex + g_CullChunkObjects, objectCount),
+				visibleObjects);
+		});
+
+	size_t visibleCount = 0;
+	for (int c = 0; c < chunkCount; c++)
+	{
+		m_cullChunks[c].firstOutput = visibleCount;
+		visibleCount += m_cullChunks[c].visibleObjects.size();
+	}
+
+	m_visibleObjects.resize(visibleCount);
+	JobSystem::ParallelFor(chunkCount, [this](int chunkIndex)
+		{
+			const CULL_CHUNK& chunk = m_cullChunks[chunkIndex];
+			std::copy(chunk.visibleObjects.begin(), chunk.visibleObjects.end(), m_visibleObjects.begin() + chunk.firstOutput);
+		});
+}
+
+/***********************************************************
+ *  SortDrawList()
+ *
+ *  This method is used for ordering opaque objects by texture,
+ *  material and mesh so consecutive draws share state. Objects
+ *  that blend keep their scene order, after the opaque ones.
+ ***********************************************************/
+void SceneManager::SortDrawList(std::vector<int>& objectIndices)
+{
+	if (UseParallelChunks(objectIndices.size()) && ((int)m_objectMaterials.size() < g_SortKeyMaterialLimit))
+	{
+		RadixSortDrawList(objectIndices);
+		return;
+	}
+
+	std::stable_sort(objectIndices.begin(), objectIndices.end(),
+		[this](int a, int b)
+		{
+			const SCENE_OBJECT& objectA = m_sceneObjects[a];
+			const SCENE_OBJECT& objectB = m_sceneObjects[b];
+			bool bBlendA = (objectA.textureSlot < 0) && (objectA.color.a < 1.0f);
+			bool bBlendB = (objectB.textureSlot < 0) && (objectB.color.a < 1.0f);
+
+			if (bBlendA || bBlendB)
+			{
+				return (bBlendA == false) && bBlendB;
+			}
+			if (objectA.textureSlot != objectB.textureSlot)
+			{
+				return objectA.textureSlot < objectB.textureSlot;
+			}
+			if (objectA.materialIndex != objectB.materialIndex)
+			{
+				return objectA.materialIndex < objectB.materialIndex;
+			}
+			return objectA.shape < objectB.shape;
+		});
+}
+
+/***********************************************************
+ *  GetDrawSortKey()
+ *
+ *  This method is used for packing the draw order of an
+ *  object into the high 32 bits of a key: the blend bit on
+ *  top, then for opaque objects the texture slot, material
+ *  and mesh, each plus one so "none" sorts first. Blended
+ *  objects leave the rest zero so they keep their list
+ *  order. The object index rides along in the low 32 bits.
+ ***********************************************************/
+uint64_t SceneManager::GetDrawSortKey(int objectIndex) const
+{
+	const SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+
+	uint32_t order;
+	if ((object.textureSlot < 0) && (object.color.a < 1.0f))
+	{
+		order = 1u << 31;
+	}
+	else
+	{
+		order = ((uint32_t)(object.textureSlot + 1) << 26) |
+			((uint32_t)(object.materialIndex + 1) << 10) |
+			((uint32_t)object.shape << 6);
+	}
+
+	return ((uint64_t)order << 32) | (uint32_t)objectIndex;
+}
+
+/***********************************************************
+ *  RadixSortDrawList()
+ *
+ *  This method is used for sorting a long draw list on the
+ *  job system. Each chunk of the list writes its keys and
+ *  counts the digits of one key byte; a serial pass turns the
+ *  counts into the place each chunk writes each digit, and
+ *  the chunks then scatter their keys in parallel. The sort
+ *  is stable and only runs over the high 32 bits, so it gives
+ *  the same order as the std::stable_sort path, and a byte
+ *  that is the same in every key is skipped.
+ ***********************************************************/
+void SceneManager::RadixSortDrawList(std::vector<int>& objectIndices)
+{
+	PROFILE_SCOPE("RadixSortDrawList");
+
+	size_t entryCount = objectIndices.size();
+	int chunkCount = (int)((entryCount + g_SortChunkEntries - 1) / g_SortChunkEntries);
+
+	m_sortKeys.resize(entryCount);
+	m_sortScratch.resize(entryCount);
+	m_radixCounts.resize((size_t)chunkCount * 256);
+	// bits set in any key of the chunk, then bits set in every key of it
+	m_sortChunkBits.resize((size_t)chunkCount * 2);
+
+	JobSystem::ParallelFor(chunkCount, [this, &objectIndices, entryCount](int chunkIndex)
+		{
+			size_t first = chunkIndex * g_SortChunkEntries;
+			size_t end = std::min(first + g_SortChunkEntries, entryCount);
+			uint64_t anyBits = 0;
+			uint64_t allBits = ~(uint64_t)0;
+			for (size_t i = first; i < end; i++)
+			{
+				uint64_t key = GetDrawSortKey(objectIndices[i]);
+				m_sortKeys[i] = key;
+				anyBits |= key;
+				allBits &= key;
+			}
+			m_sortChunkBits[chunkIndex * 2] = anyBits;
+			m_sortChunkBits[chunkIndex * 2 + 1] = allBits;
+		});
+
+	uint64_t anyBits = 0;
+	uint64_t allBits = ~(uint64_t)0;
+	for (int c = 0; c < chunkCount; c++)
+	{
+		anyBits |= m_sortChunkBits[c * 2];
+		allBits &= m_sortChunkBits[c * 2 + 1];
+	}
+	uint64_t differingBits = anyBits ^ allBits;
+
+	uint64_t* pSource = m_sortKeys.data();
+	uint64_t* pTarget = m_sortScratch.data();
+	for (int shift = 32; shift < 64; shift += 8)
+	{
+		if (((differingBits >> shift) & 0xFF) == 0)
+		{
+			continue;
+		}
+
+		JobSystem::ParallelFor(chunkCount, [this, pSource, entryCount, shift](int chunkIndex)
+			{
+				uint32_t* pCounts = &m_radixCounts[(size_t)chunkIndex * 256];
+				std::fill(pCounts, pCounts + 256, 0u);
+				size_t first = chunkIndex * g_SortChunkEntries;
+				size_t end = std::min(first + g_SortChunkEntries, entryCount);
+				for (size_t i = first; i < end; i++)
+				{
+					pCounts[(pSource[i] >> shift) & 0xFF]++;
+				}
+			});
+
+		// digit by digit, and within a digit chunk by chunk, so the scatter is stable
+		uint32_t offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			for (int c = 0; c < chunkCount; c++)
+			{
+				uint32_t count = m_radixCounts[(size_t)c * 256 + digit];
+				m_radixCounts[(size_t)c * 256 + digit] = offset;
+				offset += count;
+			}
+		}
+
+		JobSystem::ParallelFor(chunkCount, [this, pSource, pTarget, entryCount, shift](int chunkIndex)
+			{
+				uint32_t* pOffsets = &m_radixCounts[(size_t)chunkIndex * 256];
+				size_t first = chunkIndex * g_SortChunkEntries;
+				size_t end = std::min(first + g_SortChunkEntries, entryCount);
+				for (size_t i = first; i < end; i++)
+				{
+					pTarget[pOffsets[(pSource[i] >> shift) & 0xFF]++] = pSource[i];
+				}
+			});
+
+		std::swap(pSource, pTarget);
+	}
+
+	JobSystem::ParallelFor(chunkCount, [&objectIndices, pSource, entryCount](int chunkIndex)
+		{
+			size_t first = chunkIndex * g_SortChunkEntries;
+			size_t end = std::min(first + g_SortChunkEntries, entryCount);
+			for (size_t i = first; i < end; i++)
+			{
+				objectIndices[i] = (int)(uint32_t)pSource[i];
+			}
+		});
+}
+
+/***********************************************************
+ *  RenderSceneViews()
+ *
+ *  This method is used for drawing several views of the scene
+ *  in one pass over it. The lights and BVH are updated once,
+ *  each view is culled into a bit mask per object, and the
+ *  objects any view can see are merged into one sorted draw
+ *  list. Each view then sets its viewport and matrices and
+ *  draws the objects of the list that have its bit set.
+ ***********************************************************/
+void SceneManager::RenderSceneViews(
+	const SCENE_VIEW* pViews,
+	int viewCount,
+	int framebufferWidth,
+	int framebufferHeight)
+{
+	PROFILE_SCOPE("RenderSceneViews");
+
+	viewCount = std::min(viewCount, (int)MAX_SCENE_VIEWS);
+
+	m_pShaderManager->use();
+	SetShaderLights();
+	UpdateSceneBVH();
+
+	// one traversal: cull every view and merge the results
+	m_objectViewMasks.assign(m_sceneObjects.size(), 0);
+	m_sharedDrawList.clear();
+	for (int v = 0; v < viewCount; v++)
+	{
+		SetCullingView(pViews[v].frustum, pViews[v].viewProjection);
+		CullVisibleObjects();
+
+		for (size_t i = 0; i < m_visibleObjects.size(); i++)
+		{
+			int objectIndex = m_visibleObjects[i];
+			if (m_objectViewMasks[objectIndex] == 0)
+			{
+				m_sharedDrawList.push_back(objectIndex);
+			}
+			m_objectViewMasks[objectIndex] |= (1u << v);
+		}
+	}
+	SortDrawList(m_sharedDrawList);
+
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->BeginPass("draw");
+	}
+
+	{
+		PROFILE_SCOPE("DrawObjects");
+		for (int v = 0; v < viewCount; v++)
+		{
+			BeginSceneView(pViews[v], v, framebufferWidth, framebufferHeight);
+
+			unsigned int viewBit = (1u << v);
+			m_lastMaterialIndex = -1;
+			for (size_t i = 0; i < m_sharedDrawList.size(); i++)
+			{
+				int objectIndex = m_sharedDrawList[i];
+				if (m_objectViewMasks[objectIndex] & viewBit)
+				{
+					DrawSceneObject(m_sceneObjects[objectIndex]);
+				}
+			}
+		}
+
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
+	}
+
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->EndPass("draw");
+	}
+
+	// the visible count reports objects drawn in any view
+	m_visibleObjects = m_sharedDrawList;
+	m_bRedrawNeeded = false;
+}
+
+/***********************************************************
+ *  BeginSceneView()
+ *
+ *  This method is used for pointing the viewport and the view
+ *  and projection uniforms at one view of a multi-view frame.
+ ***********************************************************/
+void SceneManager::BeginSceneView(
+	const SCENE_VIEW& sceneView,
+	int viewIndex,
+	int framebufferWidth,
+	int framebufferHeight)
+{
+	GLint x = (GLint)(sceneView.viewportRect.x * framebufferWidth);
+	GLint y = (GLint)(sceneView.viewportRect.y * framebufferHeight);
+	GLsizei width = (GLsizei)(sceneView.viewportRect.z * framebufferWidth);
+	GLsizei height = (GLsizei)(sceneView.viewportRect.w * framebufferHeight);
+	glViewport(x, y, width, height);
+
+	// views after the first may be insets over it, so clear their area first
+	if (viewIndex > 0)
+	{
+		glScissor(x, y, width, height);
+		glEnable(GL_SCISSOR_TEST);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	m_pShaderManager->setMat4Value(g_ViewName, sceneView.view);
+	m_pShaderManager->setMat4Value(g_ProjectionName, sceneView.projection);
+	RenderStats::AddUniformUpdates(2);
+}
+
+/***********************************************************
+ *  RenderSnapshotViews()
+ *
+ *  This method is used for drawing draw packets that were
+ *  culled and sorted ahead of time, one list per view. Only
+ *  the lights, materials, meshes and textures of the scene
+ *  are read, and those do not change after the scene is
+ *  prepared, so the lists can be built on another thread
+ *  while this one draws.
+ ***********************************************************/
+void SceneManager::RenderSnapshotViews(
+	const SCENE_VIEW* pViews,
+	const std::vector<DRAW_PACKET>* pViewPackets,
+	int viewCount,
+	int framebufferWidth,
+	int framebufferHeight)
+{
+	PROFILE_SCOPE("RenderSnapshotViews");
+
+	viewCount = std::min(viewCount, (int)MAX_SCENE_VIEWS);
+
+	m_pShaderManager->use();
+	SetShaderLights();
+
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->BeginPass("draw");
+	}
+
+	{
+		PROFILE_SCOPE("DrawObjects");
+		for (int v = 0; v < viewCount; v++)
+		{
+			BeginSceneView(pViews[v], v, framebufferWidth, framebufferHeight);
+
+			const std::vector<DRAW_PACKET>& packets = pViewPackets[v];
+			m_lastMaterialIndex = -1;
+			for (size_t i = 0; i < packets.size(); i++)
+			{
+				const DRAW_PACKET& packet = packets[i];
+				DrawObject(
+					packet.shape,
+					packet.modelMatrix,
+					packet.textureSlot,
+					packet.uvScale,
+					packet.color,
+					packet.materialIndex);
+			}
+		}
+
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
+	}
+
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->EndPass("draw");
+	}
+}
+
+/***********************************************************
+ *  BuildDrawPackets()
+ *
+ *  This method is used for running the same culling and draw
+ *  order as RenderSceneViews() for one view, and listing what
+ *  each draw would set in the shader instead of drawing it.
+ *  Long lists are filled in chunks on the job system; each
+ *  chunk writes its own range of the packets.
+ ***********************************************************/
+void SceneManager::BuildDrawPackets(const SCENE_VIEW& sceneView, std::vector<DRAW_PACKET>& packets)
+{
+	PROFILE_SCOPE("BuildDrawPackets");
+
+	UpdateSceneBVH();
+	SetCullingView(sceneView.frustum, sceneView.viewProjection);
+	CullVisibleObjects();
+	SortDrawList(m_visibleObjects);
+
+	size_t packetCount = m_visibleObjects.size();
+	packets.resize(packetCount);
+	auto fillPackets = [this, &packets](size_t first, size_t end)
+		{
+			for (size_t i = first; i < end; i++)
+			{
+				const SCENE_OBJECT& object = m_sceneObjects[m_visibleObjects[i]];
+				DRAW_PACKET& packet = packets[i];
+				packet.shape = object.shape;
+				packet.modelMatrix = object.modelMatrix;
+				packet.textureSlot = object.textureSlot;
+				packet.uvScale = object.uvScale;
+				packet.color = object.color;
+				packet.materialIndex = object.materialIndex;
+				packet.lightMask = object.lightMask;
+			}
+		};
+
+	if (UseParallelChunks(packetCount))
+	{
+		int chunkCount = (int)((packetCount + g_SortChunkEntries - 1) / g_SortChunkEntries);
+		JobSystem::ParallelFor(chunkCount, [&fillPackets, packetCount](int chunkIndex)
+			{
+				size_t first = chunkIndex * g_SortChunkEntries;
+				fillPackets(first, std::min(first + g_SortChunkEntries, packetCount));
+			});
+	}
+	else
+	{
+		fillPackets(0, packetCount);
+	}
+
+	m_bRedrawNeeded = false;
+}
+
+/***********************************************************
+ *  GetMaterial()
+ ***********************************************************/
+const SceneManager::OBJECT_MATERIAL* SceneManager::GetMaterial(int materialIndex) const
+{
+	if ((materialIndex < 0) || (materialIndex >= (int)m_objectMaterials.size()))
+	{
+		return NULL;
+	}
+
+	return &m_objectMaterials[materialIndex];
+}
+
+/***********************************************************
+ *  ReadTexturePixels()
+ *
+ *  This method is used for copying a texture out of OpenGL.
+ *  Each texture stays bound to the unit of its slot, so the
+ *  read leaves the bindings as they were.
+ ***********************************************************/
+bool SceneManager::ReadTexturePixels(int textureSlot, int& width, int& height, std::vector<uint8_t>& pixels) const
+{
+	if ((textureSlot < 0) || (textureSlot >= m_loadedTextures))
+	{
+		return false;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + textureSlot);
+	glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	if ((width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	pixels.resize((size_t)width * height * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+
+	return (glGetError() == GL_NO_ERROR);
+}
+
+/***********************************************************
+ *  GetSpecularViewPosition()
+ ***********************************************************/
+glm::vec3 SceneManager::GetSpecularViewPosition()
+{
+	return g_SpecularViewPosition;
+}
@@ -1,104 +1,355 @@
-/////////////////////////////////////////////////////////////////////////////////
-// SceneManager.h
-// ==============
-// Manages preparing and rendering of 3D scenes, including shader settings.
-//
-// AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-// Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-/////////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include <string>
-#include <vector>
-
-#include <glm/glm.hpp>
-
-#include "ShaderManager.h"
-#include "ShapeMeshes.h"
-
-/***********************************************************
- *  SceneManager
- *
- *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
- ***********************************************************/
-class SceneManager
-{
-public:
-	// constructor
-	SceneManager(ShaderManager* pShaderManager);
-	// destructor
-	~SceneManager();
-
-	struct TEXTURE_INFO
-	{
-		std::string tag;
-		uint32_t ID;
-	};
-
-	struct OBJECT_MATERIAL
-	{
-		float ambientStrength = 0.0f;
-		glm::vec3 ambientColor = glm::vec3(0.0f);
-		glm::vec3 diffuseColor = glm::vec3(0.0f);
-		glm::vec3 specularColor = glm::vec3(0.0f);
-		float shininess = 0.0f;
-		std::string tag;
-	};
-
-	// Student-customizable scene methods
-	void PrepareScene();
-	void RenderScene();
-
-	// Sends scene light uniforms to the shader (called from RenderScene)
-	void SetShaderLights();
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager = nullptr;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes = nullptr;
-	// total number of loaded textures
-	int m_loadedTextures = 0;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
-
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
-	// free the loaded OpenGL textures
-	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(std::string materialTag);
-};
+/////////////////////////////////////////////////////////////////////////////////
+// SceneManager.h
+// ==============
+// Manages preparing and rendering of 3D scenes, including shader settings.
+//
+// AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+// Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ShaderManager.h"
+#include "ShapeMeshes.h"
+#include "SceneBounds.h"
+#include "ViewFrustum.h"
+#include "SceneBVH.h"
+#include "OcclusionBuffer.h"
+#include "GpuTimer.h"
+#include "JobSystem.h"
+
+/***********************************************************
+ *  SceneManager
+ *
+ *  This class contains the code for preparing and rendering
+ *  3D scenes, including the shader settings.
+ ***********************************************************/
+class SceneManager
+{
+public:
+	// constructor
+	SceneManager(ShaderManager* pShaderManager);
+	// destructor
+	~SceneManager();
+
+	struct TEXTURE_INFO
+	{
+		std::string tag;
+		uint32_t ID;
+	};
+
+	struct OBJECT_MATERIAL
+	{
+		float ambientStrength = 0.0f;
+		glm::vec3 ambientColor = glm::vec3(0.0f);
+		glm::vec3 diffuseColor = glm::vec3(0.0f);
+		glm::vec3 specularColor = glm::vec3(0.0f);
+		float shininess = 0.0f;
+		std::string tag;
+	};
+
+	struct SCENE_OBJECT
+	{
+		SHAPE_TYPE shape = SHAPE_BOX;
+		glm::vec3 scaleXYZ = glm::vec3(1.0f);
+		glm::vec3 rotationDegrees = glm::vec3(0.0f);
+		glm::vec3 positionXYZ = glm::vec3(0.0f);
+		// texture slot, or -1 to draw with the solid color
+		int textureSlot = -1;
+		glm::vec2 uvScale = glm::vec2(1.0f);
+		glm::vec4 color = glm::vec4(1.0f);
+		// index into the defined materials, or -1 for none
+		int materialIndex = -1;
+		// cached at load time and whenever the object moves
+		glm::mat4 modelMatrix = glm::mat4(1.0f);
+		BOUNDING_VOLUME worldBounds;
+		// bit i is set when light source i reaches the object
+		unsigned int lightMask = 0;
+		// large box or plane drawn into the occlusion buffer
+		bool bOccluder = false;
+	};
+
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::vec3 ambientColor = glm::vec3(0.0f);
+		glm::vec3 diffuseColor = glm::vec3(0.0f);
+		glm::vec3 specularColor = glm::vec3(0.0f);
+		float focalStrength = 1.0f;
+		float specularIntensity = 0.0f;
+		float constant = 1.0f;
+		float linear = 0.0f;
+		float quadratic = 0.0f;
+	};
+
+	// number of light sources the shader supports
+	static const int MAX_LIGHT_SOURCES = 4;
+
+	// start decoding the scene textures on worker threads; may be called
+	// before the OpenGL context exists, and PrepareScene() picks them up
+	void BeginTextureDecodes();
+
+	// Student-customizable scene methods
+	void PrepareScene();
+	void RenderScene();
+
+	// fewest and most objects a generated stress scene can have
+	static const int MIN_STRESS_OBJECTS = 10;
+	static const int MAX_STRESS_OBJECTS = 1000000;
+	// instead of PrepareScene(), fill the scene with objectCount random
+	// objects of every basic shape; the same seed gives the same scene
+	void PrepareStressScene(int objectCount, unsigned int seed);
+	// replace the objects of a prepared stress scene, keeping its meshes and textures
+	void ReplaceStressObjects(int objectCount, unsigned int seed);
+
+	// Sends scene light uniforms to the shader (called from RenderScene)
+	void SetShaderLights();
+
+	// most views RenderSceneViews() can draw in one pass
+	static const int MAX_SCENE_VIEWS = 32;
+	// draw several views, each into its part of the framebuffer, from one
+	// culled and sorted draw list; sets the view and projection of each view
+	void RenderSceneViews(
+		const SCENE_VIEW* pViews,
+		int viewCount,
+		int framebufferWidth,
+		int framebufferHeight);
+
+	// one entry of the culled and sorted draw list, with the values its draw
+	// call would send to the shader, for renderers that do not use OpenGL
+	struct DRAW_PACKET
+	{
+		SHAPE_TYPE shape;
+		glm::mat4 modelMatrix;
+		int textureSlot;
+		glm::vec2 uvScale;
+		glm::vec4 color;
+		int materialIndex;
+		unsigned int lightMask;
+	};
+	// cull and sort the scene for one view and list its draws in order
+	void BuildDrawPackets(const SCENE_VIEW& sceneView, std::vector<DRAW_PACKET>& packets);
+	// draw the packet lists built by BuildDrawPackets(), one per view; reads
+	// no per-object state, so the lists of the next frame can be built meanwhile
+	void RenderSnapshotViews(
+		const SCENE_VIEW* pViews,
+		const std::vector<DRAW_PACKET>* pViewPackets,
+		int viewCount,
+		int framebufferWidth,
+		int framebufferHeight);
+	// lights, materials and textures the draw packets refer to
+	const LIGHT_SOURCE& GetLightSource(int lightIndex) const { return m_lightSources[lightIndex]; }
+	const OBJECT_MATERIAL* GetMaterial(int materialIndex) const;
+	int GetTextureCount() const { return m_loadedTextures; }
+	// read a loaded texture back from OpenGL as 8-bit RGBA rows
+	bool ReadTexturePixels(int textureSlot, int& width, int& height, std::vector<uint8_t>& pixels) const;
+	// eye position the shader uses for specular highlights
+	static glm::vec3 GetSpecularViewPosition();
+
+	// set the view used to skip objects outside the frustum or hidden by occluders
+	void SetCullingView(const ViewFrustum& frustum, const glm::mat4& viewProjection);
+	// turn the CPU occlusion culling pass on or off
+	void EnableOcclusionCulling(bool bEnable) { m_bOcclusionCulling = bEnable; }
+	// number of objects drawn by the last RenderScene or RenderSceneViews call
+	size_t GetVisibleObjectCount() const { return m_visibleObjects.size(); }
+	size_t GetSceneObjectCount() const { return m_sceneObjects.size(); }
+	// true if objects, their shading or the lights changed since the last RenderScene call
+	bool NeedsRedraw() const { return m_bRedrawNeeded; }
+	// time the GPU passes of RenderScene with this timer, or NULL for none
+	void SetGpuTimer(GpuTimer* pGpuTimer) { m_pGpuTimer = pGpuTimer; }
+
+	// add an object to the scene and return its index
+	int AddSceneObject(
+		SHAPE_TYPE shape,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// move an existing scene object
+	void SetObjectTransformations(
+		int objectIndex,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// set how an existing scene object is shaded
+	void SetObjectTexture(int objectIndex, std::string textureTag, float u, float v);
+	void SetObjectColor(int objectIndex, float red, float green, float blue, float alpha);
+	void SetObjectMaterial(int objectIndex, std::string materialTag);
+	// mark a box or plane object as an occluder for the CPU occlusion pass
+	void SetObjectOccluder(int objectIndex, bool bOccluder);
+
+	// find the object under a ray, or -1 if nothing is hit
+	int PickObject(glm::vec3 rayOrigin, glm::vec3 rayDirection);
+
+private:
+	// times the private hot paths below one at a time
+	friend class Microbenchmark;
+
+	// texture image decoded into memory, not yet uploaded to OpenGL
+	struct DECODED_IMAGE
+	{
+		int width = 0;
+		int height = 0;
+		int colorChannels = 0;
+		unsigned char* pixels = nullptr;
+	};
+
+	struct PENDING_TEXTURE_DECODE
+	{
+		std::string filename;
+		// filled in by the decode job; shared so the job can outlive the entry
+		std::shared_ptr<DECODED_IMAGE> pImage;
+		JobSystem::JOB_HANDLE job;
+	};
+
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager = nullptr;
+	// pointer to basic shapes object
+	ShapeMeshes* m_basicMeshes = nullptr;
+	// total number of loaded textures
+	int m_loadedTextures = 0;
+	// loaded textures info
+	TEXTURE_INFO m_textureIDs[16];
+	// defined object materials
+	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// objects that make up the scene
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// world space bounds of the scene objects, packed for culling
+	PACKED_BOUNDS m_packedBounds;
+	// frustum and view-projection matrix for the current view
+	ViewFrustum m_cullingFrustum;
+	glm::mat4 m_viewProjection = glm::mat4(1.0f);
+	// CPU depth buffer that the occluders are drawn into
+	OcclusionBuffer m_occlusionBuffer;
+	bool m_bOcclusionCulling = true;
+	// indices of the objects that passed culling this frame
+	std::vector<int> m_visibleObjects;
+	// multi-view rendering: objects any view can see, and a bit per view that sees each object
+	std::vector<int> m_sharedDrawList;
+	std::vector<unsigned int> m_objectViewMasks;
+	// large scenes: the visible objects of each culling chunk, and the sort
+	// keys of the draw list with the radix sort's second buffer and counts
+	struct CULL_CHUNK
+	{
+		std::vector<int> visibleObjects;
+		size_t firstOutput = 0;
+	};
+	std::vector<CULL_CHUNK> m_cullChunks;
+	std::vector<uint64_t> m_sortKeys;
+	std::vector<uint64_t> m_sortScratch;
+	std::vector<uint32_t> m_radixCounts;
+	std::vector<uint64_t> m_sortChunkBits;
+	// material last sent to the shader while drawing, or -1 if none
+	int m_lastMaterialIndex = -1;
+	// spatial index over the world space object bounds
+	SceneBVH m_sceneBVH;
+	// set when objects are added, or moved, since the BVH was updated
+	bool m_bSceneStructureDirty = false;
+	bool m_bSceneBoundsDirty = false;
+	// light sources sent to the shader
+	LIGHT_SOURCE m_lightSources[MAX_LIGHT_SOURCES];
+	// set when the light sources change, so light reach is reassigned
+	bool m_bLightsDirty = true;
+	// set when anything that changes the rendered image changes, cleared by RenderScene
+	bool m_bRedrawNeeded = true;
+	// optional GPU pass timer, owned by the caller
+	GpuTimer* m_pGpuTimer = nullptr;
+
+	// texture decodes started by BeginTextureDecodes() and not yet used
+	std::vector<PENDING_TEXTURE_DECODE> m_pendingTextureDecodes;
+
+	// load texture images and convert to OpenGL texture data
+	bool CreateGLTexture(const char* filename, std::string tag);
+	// read and decode an image file; safe to call from any thread
+	static DECODED_IMAGE DecodeTextureImage(std::string filename);
+	// image file of a texture PrepareScene() loads, or NULL past the last one
+	static const char* GetSceneTextureFilename(int textureIndex);
+	// upload a decoded image as the next texture and free its pixels
+	bool UploadGLTexture(DECODED_IMAGE& image, const char* filename, std::string tag);
+	// bind loaded OpenGL textures to slots in memory
+	void BindGLTextures();
+	// free the loaded OpenGL textures
+	void DestroyGLTextures();
+	// find a loaded texture by tag
+	int FindTextureID(std::string tag);
+	int FindTextureSlot(std::string tag);
+	// find a defined material by tag
+	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+
+	// set the transformation values into the transform buffer
+	void SetTransformations(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the color values into the shader
+	void SetShaderColor(
+		float redColorValue,
+		float greenColorValue,
+		float blueColorValue,
+		float alphaValue);
+
+	// set the texture data into the shader
+	void SetShaderTexture(std::string textureTag);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(float u, float v);
+
+	// set the object material into the shader
+	void SetShaderMaterial(std::string materialTag);
+
+	// build the model matrix from the transformation values
+	glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// refresh the cached matrix and bounds after an object changes
+	void UpdateObjectBounds(int objectIndex);
+	// set the shader values for a scene object and draw its mesh
+	void DrawSceneObject(const SCENE_OBJECT& object);
+	// send the shader values of one draw and draw its mesh
+	void DrawObject(
+		SHAPE_TYPE shape,
+		const glm::mat4& modelMatrix,
+		int textureSlot,
+		const glm::vec2& uvScale,
+		const glm::vec4& color,
+		int materialIndex);
+	// set the viewport, inset clear, view and projection of one view
+	void BeginSceneView(const SCENE_VIEW& sceneView, int viewIndex, int framebufferWidth, int framebufferHeight);
+	// draw the basic mesh for a shape type
+	void DrawShapeMesh(SHAPE_TYPE shape);
+
+	// define the light sources used in the scene
+	void DefineSceneLights();
+	// refit or rebuild the BVH after objects were added or moved
+	void UpdateSceneBVH();
+	// mark which objects are within reach of each light source
+	void AssignLightsToObjects();
+	// drop visible objects that are hidden behind the occluders
+	void CullOccludedObjects();
+	// fill the visible object list for the current culling view
+	void CullVisibleObjects();
+	// frustum cull a large scene in chunks on the job system
+	void CullChunksInParallel();
+	// order objects so consecutive draws share texture, material and mesh
+	void SortDrawList(std::vector<int>& objectIndices);
+	// the same order packed into the high 32 bits, with the object index below
+	uint64_t GetDrawSortKey(int objectIndex) const;
+	// sort a long draw list by its keys with a parallel LSD radix sort
+	void RadixSortDrawList(std::vector<int>& objectIndices);
+};
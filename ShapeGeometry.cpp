@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////
+// ShapeGeometry.cpp
+// =================
+// CPU copies of the basic shape meshes as plain triangle lists
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeGeometry.h"
+
+namespace
+{
+	// triangles of each shape, filled in as the meshes are loaded
+	std::vector<SHAPE_VERTEX> g_ShapeTriangles[SHAPE_COUNT];
+
+	/***********************************************************
+	 *  ReadVertex()
+	 *
+	 *  Vertices are interleaved as position, normal and texture
+	 *  coordinate, the layout every shape mesh uses.
+	 ***********************************************************/
+	SHAPE_VERTEX ReadVertex(const float* vertexData, size_t floatsPerVertex, size_t vertexIndex)
+	{
+		const float* pVertex = vertexData + vertexIndex * floatsPerVertex;
+
+		SHAPE_VERTEX vertex;
+		vertex.position = glm::vec3(pVertex[0], pVertex[1], pVertex[2]);
+		vertex.normal = glm::vec3(pVertex[3], pVertex[4], pVertex[5]);
+		vertex.uv = glm::vec2(pVertex[6], pVertex[7]);
+		return vertex;
+	}
+}
+
+/***********************************************************
+ *  RegisterShapeTriangles()
+ *
+ *  This function is used for expanding a draw call into a
+ *  triangle list, the way OpenGL assembles its primitives.
+ *  Strips alternate their winding, so every other triangle
+ *  swaps two vertices to keep the winding of the first.
+ *  Ranges past the end of the vertex data are cut short.
+ ***********************************************************/
+void RegisterShapeTriangles(
+	SHAPE_TYPE shape,
+	GLenum mode,
+	const float* vertexData,
+	size_t vertexCount,
+	size_t floatsPerVertex,
+	size_t first,
+	size_t count,
+	const GLuint* pIndices)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT) || (NULL == vertexData) || (floatsPerVertex < 8))
+	{
+		return;
+	}
+
+	// the vertex index of each element in the range
+	std::vector<size_t> elements;
+	elements.reserve(count);
+	for (size_t i = first; i < first + count; i++)
+	{
+		size_t vertexIndex = (NULL != pIndices) ? pIndices[i] : i;
+		if (vertexIndex >= vertexCount)
+		{
+			break;
+		}
+		elements.push_back(vertexIndex);
+	}
+
+	std::vector<SHAPE_VERTEX>& triangles = g_ShapeTriangles[shape];
+	size_t corners[3];
+
+	for (size_t i = 0; i + 2 < elements.size(); )
+	{
+		if (mode == GL_TRIANGLE_STRIP)
+		{
+			corners[0] = elements[i];
+			corners[1] = elements[((i % 2) == 0) ? i + 1 : i + 2];
+			corners[2] = elements[((i % 2) == 0) ? i + 2 : i + 1];
+			i += 1;
+		}
+		else if (mode == GL_TRIANGLE_FAN)
+		{
+			corners[0] = elements[0];
+			corners[1] = elements[i + 1];
+			corners[2] = elements[i + 2];
+			i += 1;
+		}
+		else
+		{
+			corners[0] = elements[i];
+			corners[1] = elements[i + 1];
+			corners[2] = elements[i + 2];
+			i += 3;
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			triangles.push_back(ReadVertex(vertexData, floatsPerVertex, corners[c]));
+		}
+	}
+}
+
+/***********************************************************
+ *  ClearShapeTriangles()
+ ***********************************************************/
+void ClearShapeTriangles(SHAPE_TYPE shape)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return;
+	}
+
+	// give the memory back too, since a reload may make a smaller mesh
+	std::vector<SHAPE_VERTEX>().swap(g_ShapeTriangles[shape]);
+}
+
+/***********************************************************
+ *  GetShapeTriangles()
+ ***********************************************************/
+const std::vector<SHAPE_VERTEX>& GetShapeTriangles(SHAPE_TYPE shape)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return g_ShapeTriangles[SHAPE_BOX];
+	}
+
+	return g_ShapeTriangles[shape];
+}
@@ -0,0 +1,40 @@
+/////////////////////////////////////////////////////////////////////////////////
+// ShapeGeometry.h
+// ===============
+// CPU copies of the basic shape meshes as plain triangle lists
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "SceneBounds.h"
+
+// one vertex of a shape triangle, in object space
+struct SHAPE_VERTEX
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 uv;
+};
+
+// record the triangles one draw call of a loaded shape mesh assembles;
+// mode is GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_TRIANGLE_FAN, and with
+// indices the range selects indices rather than vertices
+void RegisterShapeTriangles(
+	SHAPE_TYPE shape,
+	GLenum mode,
+	const float* vertexData,
+	size_t vertexCount,
+	size_t floatsPerVertex,
+	size_t first,
+	size_t count,
+	const GLuint* pIndices = NULL);
+// drop the triangles of a shape, so a reloaded mesh replaces them instead of adding to them
+void ClearShapeTriangles(SHAPE_TYPE shape);
+// get the triangles of a shape mesh, three vertices per triangle
+const std::vector<SHAPE_VERTEX>& GetShapeTriangles(SHAPE_TYPE shape);
@@ -0,0 +1,763 @@
+/////////////////////////////////////////////////////////////////////////////////
+// SoftwareRasterizer.cpp
+// ======================
+// multithreaded tile-based CPU renderer for machines without a usable GPU
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "ShapeGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARERASTERIZER_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// geometry chunks per thread, so a chunk of large meshes can't hold up the stage
+	const int g_ChunksPerThread = 2;
+	// vertex positions snap to 1/16 pixel, so shared edges give identical edge functions
+	const float g_SubpixelSteps = 16.0f;
+	// triangles are only clipped in x and y where they leave this many
+	// viewports around the screen, which keeps the edge functions precise
+	const float g_GuardBand = 8.0f;
+	// largest polygon one triangle can become after clipping against six planes
+	const int g_MaxClippedVertices = 9;
+	const int g_ClipPlaneCount = 6;
+
+	// distance of a clip space position inside a clip plane; negative is outside
+	float ClipPlaneDistance(int plane, const glm::vec4& clip)
+	{
+		switch (plane)
+		{
+		case 0: return clip.z + clip.w;
+		case 1: return clip.w - clip.z;
+		case 2: return (g_GuardBand * clip.w) + clip.x;
+		case 3: return (g_GuardBand * clip.w) - clip.x;
+		case 4: return (g_GuardBand * clip.w) + clip.y;
+		default: return (g_GuardBand * clip.w) - clip.y;
+		}
+	}
+
+	// bit i set when the position is outside clip plane i
+	unsigned int ClipOutcode(const glm::vec4& clip)
+	{
+		unsigned int outcode = 0;
+		for (int plane = 0; plane < g_ClipPlaneCount; plane++)
+		{
+			if (ClipPlaneDistance(plane, clip) < 0.0f)
+			{
+				outcode |= (1u << plane);
+			}
+		}
+		return outcode;
+	}
+
+	uint8_t ToByte(float value)
+	{
+		return (uint8_t)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer()
+	: m_width(0),
+	m_height(0),
+	m_tileColumns(0),
+	m_tileRows(0),
+	m_depthStride(0),
+	m_viewProjection(1.0f),
+	m_viewPosition(0.0f),
+	m_chunkCount(0),
+	m_pSceneManager(NULL),
+	m_threadCount(1)
+{
+}
+
+/***********************************************************
+ *  ~SoftwareRasterizer()
+ ***********************************************************/
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for choosing how many threads draw a
+ *  view. The thread that calls RenderView() counts as one of
+ *  them; the rest are job system workers, so there can be no
+ *  more than the job system has.
+ ***********************************************************/
+void SoftwareRasterizer::Start(int threadCount)
+{
+	int availableThreads = JobSystem::GetWorkerCount() + 1;
+	if ((threadCount <= 0) || (threadCount > availableThreads))
+	{
+		threadCount = availableThreads;
+	}
+	m_threadCount = threadCount;
+
+	std::cout << "INFO: Software rasterizer using " << threadCount << " thread" << ((threadCount == 1) ? "" : "s") << std::endl;
+}
+
+/***********************************************************
+ *  LoadTextures()
+ *
+ *  This method is used for keeping a CPU copy of every scene
+ *  texture, indexed by texture slot like the draw packets.
+ ***********************************************************/
+bool SoftwareRasterizer::LoadTextures(const SceneManager* pSceneManager)
+{
+	if (NULL == pSceneManager)
+	{
+		return false;
+	}
+
+	bool bAllRead = true;
+	m_textures.resize(pSceneManager->GetTextureCount());
+	for (int slot = 0; slot < (int)m_textures.size(); slot++)
+	{
+		SOFTWARE_TEXTURE& texture = m_textures[slot];
+		if (pSceneManager->ReadTexturePixels(slot, texture.width, texture.height, texture.pixels) == false)
+		{
+			std::cout << "Could not read texture slot " << slot << " for the software rasterizer" << std::endl;
+			texture.width = 0;
+			texture.height = 0;
+			texture.pixels.clear();
+			bAllRead = false;
+		}
+	}
+
+	return bAllRead;
+}
+
+/***********************************************************
+ *  RenderView()
+ *
+ *  This method is used for drawing one view of the scene at
+ *  width x height. The view's viewport rectangle is ignored;
+ *  the view always fills the color buffer.
+ ***********************************************************/
+void SoftwareRasterizer::RenderView(SceneManager* pSceneManager, const SCENE_VIEW& sceneView, int width, int height)
+{
+	PROFILE_SCOPE("SoftwareRender");
+
+	if ((NULL == pSceneManager) || (width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	if ((width != m_width) || (height != m_height))
+	{
+		m_width = width;
+		m_height = height;
+		m_tileColumns = (width + TILE_SIZE - 1) / TILE_SIZE;
+		m_tileRows = (height + TILE_SIZE - 1) / TILE_SIZE;
+		m_depthStride = (width + 3) & ~3;
+		m_colorBuffer.assign((size_t)width * height * 4, 0);
+		m_depthBuffer.assign((size_t)m_depthStride * height, 1.0f);
+	}
+
+	m_pSceneManager = pSceneManager;
+	m_viewProjection = sceneView.viewProjection;
+	m_viewPosition = SceneManager::GetSpecularViewPosition();
+	for (int i = 0; i < SceneManager::MAX_LIGHT_SOURCES; i++)
+	{
+		m_lights[i] = pSceneManager->GetLightSource(i);
+	}
+
+	pSceneManager->BuildDrawPackets(sceneView, m_packets);
+	BuildChunks();
+
+	{
+		PROFILE_SCOPE("SoftwareGeometry");
+		JobSystem::ParallelFor((int)m_chunkCount, [this](int chunkIndex) { ProcessChunk(m_chunks[chunkIndex]); }, m_threadCount);
+	}
+
+	{
+		PROFILE_SCOPE("SoftwareRasterize");
+		JobSystem::ParallelFor(m_tileColumns * m_tileRows, [this](int tileIndex) { RasterizeTile(tileIndex); }, m_threadCount);
+	}
+}
+
+/***********************************************************
+ *  BuildChunks()
+ *
+ *  This method is used for cutting the packet list into runs
+ *  of roughly equal triangle counts. The runs keep the packet
+ *  order, which the tiles rely on for blending.
+ ***********************************************************/
+void SoftwareRasterizer::BuildChunks()
+{
+	m_chunkCount = 0;
+	if (m_packets.empty())
+	{
+		return;
+	}
+
+	size_t totalTriangles = 0;
+	for (size_t i = 0; i < m_packets.size(); i++)
+	{
+		totalTriangles += GetShapeTriangles(m_packets[i].shape).size() / 3;
+	}
+
+	size_t targetChunks = std::min(m_packets.size(), (size_t)GetThreadCount() * g_ChunksPerThread);
+	if (m_chunks.size() < targetChunks)
+	{
+		m_chunks.resize(targetChunks);
+	}
+
+	size_t firstPacket = 0;
+	size_t triangleCount = 0;
+	for (size_t i = 0; i < m_packets.size(); i++)
+	{
+		triangleCount += GetShapeTriangles(m_packets[i].shape).size() / 3;
+
+		bool bLastPacket = (i + 1 == m_packets.size());
+		bool bChunkFull = (m_chunkCount + 1 < targetChunks) &&
+			(triangleCount * targetChunks >= (m_chunkCount + 1) * totalTriangles);
+		if (bLastPacket || bChunkFull)
+		{
+			GEOMETRY_CHUNK& chunk = m_chunks[m_chunkCount++];
+			chunk.firstPacket = firstPacket;
+			chunk.endPacket = i + 1;
+			firstPacket = i + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  ProcessChunk()
+ *
+ *  This method is used for the vertex stage of one chunk.
+ *  Triangles outside one clip plane are dropped; those that
+ *  cross the near or far plane, or leave the guard band, are
+ *  clipped into a fan of smaller triangles.
+ ***********************************************************/
+void SoftwareRasterizer::ProcessChunk(GEOMETRY_CHUNK& chunk)
+{
+	chunk.triangles.clear();
+	chunk.tileBins.resize(m_tileColumns * m_tileRows);
+	for (size_t i = 0; i < chunk.tileBins.size(); i++)
+	{
+		chunk.tileBins[i].clear();
+	}
+
+	CLIP_VERTEX polygon[2][g_MaxClippedVertices];
+
+	for (size_t packetIndex = chunk.firstPacket; packetIndex < chunk.endPacket; packetIndex++)
+	{
+		const SceneManager::DRAW_PACKET& packet = m_packets[packetIndex];
+		const std::vector<SHAPE_VERTEX>& shapeTriangles = GetShapeTriangles(packet.shape);
+
+		glm::mat4 modelViewProjection = m_viewProjection * packet.modelMatrix;
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(packet.modelMatrix)));
+
+		for (size_t t = 0; t + 2 < shapeTriangles.size(); t += 3)
+		{
+			CLIP_VERTEX vertices[3];
+			unsigned int anyOutside = 0;
+			unsigned int allOutside = ~0u;
+
+			for (int i = 0; i < 3; i++)
+			{
+				const SHAPE_VERTEX& shapeVertex = shapeTriangles[t + i];
+				glm::vec4 position(shapeVertex.position, 1.0f);
+
+				vertices[i].clip = modelViewProjection * position;
+				vertices[i].world = glm::vec3(packet.modelMatrix * position);
+				vertices[i].normal = normalMatrix * shapeVertex.normal;
+				vertices[i].uv = shapeVertex.uv * packet.uvScale;
+
+				unsigned int outcode = ClipOutcode(vertices[i].clip);
+				anyOutside |= outcode;
+				allOutside &= outcode;
+			}
+
+			if (allOutside != 0)
+			{
+				continue;
+			}
+
+			if (anyOutside == 0)
+			{
+				SetupTriangle(chunk, vertices[0], vertices[1], vertices[2], (int)packetIndex);
+				continue;
+			}
+
+			// clip the triangle against each plane it crosses
+			int vertexCount = 3;
+			int current = 0;
+			std::copy(vertices, vertices + 3, polygon[current]);
+
+			for (int plane = 0; (plane < g_ClipPlaneCount) && (vertexCount >= 3); plane++)
+			{
+				if ((anyOutside & (1u << plane)) == 0)
+				{
+					continue;
+				}
+
+				const CLIP_VERTEX* input = polygon[current];
+				CLIP_VERTEX* output = polygon[1 - current];
+				int outputCount = 0;
+
+				for (int i = 0; i < vertexCount; i++)
+				{
+					const CLIP_VERTEX& a = input[i];
+					const CLIP_VERTEX& b = input[(i + 1) % vertexCount];
+					float distanceA = ClipPlaneDistance(plane, a.clip);
+					float distanceB = ClipPlaneDistance(plane, b.clip);
+
+					if (distanceA >= 0.0f)
+					{
+						output[outputCount++] = a;
+					}
+					if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+					{
+						float s = distanceA / (distanceA - distanceB);
+						CLIP_VERTEX& crossing = output[outputCount++];
+						crossing.clip = glm::mix(a.clip, b.clip, s);
+						crossing.world = glm::mix(a.world, b.world, s);
+						crossing.normal = glm::mix(a.normal, b.normal, s);
+						crossing.uv = glm::mix(a.uv, b.uv, s);
+					}
+				}
+
+				vertexCount = outputCount;
+				current = 1 - current;
+			}
+
+			for (int i = 1; i + 1 < vertexCount; i++)
+			{
+				SetupTriangle(chunk, polygon[current][0], polygon[current][i], polygon[current][i + 1], (int)packetIndex);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used for projecting a clipped triangle to
+ *  the screen, with y pointing down, and working out its edge
+ *  functions, depth plane and the tiles it overlaps. Both
+ *  windings are drawn, as the GL path does not cull faces.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangle(
+	GEOMETRY_CHUNK& chunk,
+	const CLIP_VERTEX& v0,
+	const CLIP_VERTEX& v1,
+	const CLIP_VERTEX& v2,
+	int packetIndex)
+{
+	const CLIP_VERTEX* vertices[3] = { &v0, &v1, &v2 };
+	float screenX[3];
+	float screenY[3];
+	float depth[3];
+	float invW[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& clip = vertices[i]->clip;
+		invW[i] = 1.0f / clip.w;
+		float x = ((clip.x * invW[i]) * 0.5f + 0.5f) * m_width;
+		float y = (0.5f - (clip.y * invW[i]) * 0.5f) * m_height;
+		screenX[i] = floorf(x * g_SubpixelSteps + 0.5f) / g_SubpixelSteps;
+		screenY[i] = floorf(y * g_SubpixelSteps + 0.5f) / g_SubpixelSteps;
+		depth[i] = (clip.z * invW[i]) * 0.5f + 0.5f;
+	}
+
+	float area = ((screenX[1] - screenX[0]) * (screenY[2] - screenY[0])) -
+		((screenX[2] - screenX[0]) * (screenY[1] - screenY[0]));
+	if (area == 0.0f)
+	{
+		return;
+	}
+
+	int minX = std::max(0, (int)ceilf(std::min(screenX[0], std::min(screenX[1], screenX[2])) - 0.5f));
+	int minY = std::max(0, (int)ceilf(std::min(screenY[0], std::min(screenY[1], screenY[2])) - 0.5f));
+	int maxX = std::min(m_width, (int)floorf(std::max(screenX[0], std::max(screenX[1], screenX[2])) - 0.5f) + 1);
+	int maxY = std::min(m_height, (int)floorf(std::max(screenY[0], std::max(screenY[1], screenY[2])) - 0.5f) + 1);
+	if ((minX >= maxX) || (minY >= maxY))
+	{
+		return;
+	}
+
+	RASTER_TRIANGLE triangle;
+
+	// edge i runs between the two vertices other than i; flipping the signs
+	// for the other winding keeps the inside positive
+	float sign = (area > 0.0f) ? 1.0f : -1.0f;
+	triangle.topLeftMask = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		int a = (i + 1) % 3;
+		int b = (i + 2) % 3;
+		triangle.edgeA[i] = sign * (screenY[a] - screenY[b]);
+		triangle.edgeB[i] = sign * (screenX[b] - screenX[a]);
+		triangle.edgeC[i] = sign * ((screenX[a] * screenY[b]) - (screenY[a] * screenX[b]));
+
+		// pixel centers exactly on an edge belong to the triangle on its right
+		// or below it, so triangles sharing the edge never both draw them
+		if ((triangle.edgeA[i] > 0.0f) || ((triangle.edgeA[i] == 0.0f) && (triangle.edgeB[i] > 0.0f)))
+		{
+			triangle.topLeftMask |= (1 << i);
+		}
+	}
+
+	triangle.invArea = 1.0f / fabsf(area);
+	triangle.depthA = ((triangle.edgeA[0] * depth[0]) + (triangle.edgeA[1] * depth[1]) + (triangle.edgeA[2] * depth[2])) * triangle.invArea;
+	triangle.depthB = ((triangle.edgeB[0] * depth[0]) + (triangle.edgeB[1] * depth[1]) + (triangle.edgeB[2] * depth[2])) * triangle.invArea;
+	triangle.depthC = ((triangle.edgeC[0] * depth[0]) + (triangle.edgeC[1] * depth[1]) + (triangle.edgeC[2] * depth[2])) * triangle.invArea;
+
+	for (int i = 0; i < 3; i++)
+	{
+		triangle.invW[i] = invW[i];
+		triangle.world[i] = vertices[i]->world;
+		triangle.normal[i] = vertices[i]->normal;
+		triangle.uv[i] = vertices[i]->uv;
+	}
+
+	triangle.minX = minX;
+	triangle.minY = minY;
+	triangle.maxX = maxX;
+	triangle.maxY = maxY;
+	triangle.packetIndex = packetIndex;
+
+	int triangleIndex = (int)chunk.triangles.size();
+	chunk.triangles.push_back(triangle);
+
+	for (int tileY = minY / TILE_SIZE; tileY <= (maxY - 1) / TILE_SIZE; tileY++)
+	{
+		for (int tileX = minX / TILE_SIZE; tileX <= (maxX - 1) / TILE_SIZE; tileX++)
+		{
+			chunk.tileBins[(tileY * m_tileColumns) + tileX].push_back(triangleIndex);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTile()
+ *
+ *  This method is used for the pixel stage of one tile. Only
+ *  the thread drawing a tile touches its pixels, so the color
+ *  and depth buffers need no locking.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTile(int tileIndex)
+{
+	int tileMinX = (tileIndex % m_tileColumns) * TILE_SIZE;
+	int tileMinY = (tileIndex / m_tileColumns) * TILE_SIZE;
+	int tileMaxX = std::min(tileMinX + TILE_SIZE, m_width);
+	int tileMaxY = std::min(tileMinY + TILE_SIZE, m_height);
+
+	// clear to opaque black, as the GL path does
+	for (int y = tileMinY; y < tileMaxY; y++)
+	{
+		uint8_t* colorRow = &m_colorBuffer[((size_t)y * m_width + tileMinX) * 4];
+		for (int x = tileMinX; x < tileMaxX; x++)
+		{
+			colorRow[0] = 0;
+			colorRow[1] = 0;
+			colorRow[2] = 0;
+			colorRow[3] = 255;
+			colorRow += 4;
+		}
+		std::fill_n(&m_depthBuffer[(size_t)y * m_depthStride + tileMinX], tileMaxX - tileMinX, 1.0f);
+	}
+
+	for (size_t c = 0; c < m_chunkCount; c++)
+	{
+		const GEOMETRY_CHUNK& chunk = m_chunks[c];
+		const std::vector<int>& bin = chunk.tileBins[tileIndex];
+		for (size_t i = 0; i < bin.size(); i++)
+		{
+			RasterizeTriangle(chunk.triangles[bin[i]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for finding the pixels of one tile a
+ *  triangle covers and that pass the depth test. Edge
+ *  functions are evaluated at pixel centers, four pixels of a
+ *  row at a time. Groups of four start on a multiple of four,
+ *  so they never reach into a neighboring tile.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTriangle(
+	const RASTER_TRIANGLE& triangle,
+	int tileMinX,
+	int tileMinY,
+	int tileMaxX,
+	int tileMaxY)
+{
+	int minX = std::max(triangle.minX, tileMinX);
+	int minY = std::max(triangle.minY, tileMinY);
+	int maxX = std::min(triangle.maxX, tileMaxX);
+	int maxY = std::min(triangle.maxY, tileMaxY);
+	if ((minX >= maxX) || (minY >= maxY))
+	{
+		return;
+	}
+
+	const float* a = triangle.edgeA;
+	const float* b = triangle.edgeB;
+	const float* c = triangle.edgeC;
+
+#ifdef SOFTWARERASTERIZER_USE_SSE
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 edgeA0 = _mm_set1_ps(a[0]);
+	const __m128 edgeA1 = _mm_set1_ps(a[1]);
+	const __m128 edgeA2 = _mm_set1_ps(a[2]);
+	const __m128 topLeft0 = _mm_castsi128_ps(_mm_set1_epi32((triangle.topLeftMask & 1) ? -1 : 0));
+	const __m128 topLeft1 = _mm_castsi128_ps(_mm_set1_epi32((triangle.topLeftMask & 2) ? -1 : 0));
+	const __m128 topLeft2 = _mm_castsi128_ps(_mm_set1_epi32((triangle.topLeftMask & 4) ? -1 : 0));
+	const __m128 stepDepth = _mm_set1_ps(triangle.depthA);
+	const __m128 spanMin = _mm_set1_ps((float)minX);
+	const __m128 spanMax = _mm_set1_ps((float)maxX);
+	const __m128 invArea = _mm_set1_ps(triangle.invArea);
+
+	float b0[4];
+	float b1[4];
+	float b2[4];
+	float depths[4];
+
+	for (int y = minY; y < maxY; y++)
+	{
+		float pixelY = y + 0.5f;
+		float* depthRow = &m_depthBuffer[(size_t)y * m_depthStride];
+
+		__m128 rowE0 = _mm_set1_ps((b[0] * pixelY) + c[0]);
+		__m128 rowE1 = _mm_set1_ps((b[1] * pixelY) + c[1]);
+		__m128 rowE2 = _mm_set1_ps((b[2] * pixelY) + c[2]);
+		__m128 rowDepth = _mm_set1_ps((triangle.depthB * pixelY) + triangle.depthC);
+
+		for (int x = minX & ~3; x < maxX; x += 4)
+		{
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, pixelX), rowE0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, pixelX), rowE1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, pixelX), rowE2);
+
+			__m128 inside0 = _mm_or_ps(_mm_cmpgt_ps(e0, zero), _mm_and_ps(_mm_cmpeq_ps(e0, zero), topLeft0));
+			__m128 inside1 = _mm_or_ps(_mm_cmpgt_ps(e1, zero), _mm_and_ps(_mm_cmpeq_ps(e1, zero), topLeft1));
+			__m128 inside2 = _mm_or_ps(_mm_cmpgt_ps(e2, zero), _mm_and_ps(_mm_cmpeq_ps(e2, zero), topLeft2));
+			__m128 inSpan = _mm_and_ps(_mm_cmpgt_ps(pixelX, spanMin), _mm_cmplt_ps(pixelX, spanMax));
+			__m128 covered = _mm_and_ps(_mm_and_ps(inside0, inside1), _mm_and_ps(inside2, inSpan));
+
+			if (_mm_movemask_ps(covered) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(stepDepth, pixelX), rowDepth);
+			__m128 passed = _mm_and_ps(covered, _mm_cmplt_ps(depth, _mm_loadu_ps(depthRow + x)));
+			int passedMask = _mm_movemask_ps(passed);
+			if (passedMask == 0)
+			{
+				continue;
+			}
+
+			_mm_storeu_ps(b0, _mm_mul_ps(e0, invArea));
+			_mm_storeu_ps(b1, _mm_mul_ps(e1, invArea));
+			_mm_storeu_ps(b2, _mm_mul_ps(e2, invArea));
+			_mm_storeu_ps(depths, depth);
+
+			// pixels are written one at a time so the other lanes are left alone
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (passedMask & (1 << lane))
+				{
+					depthRow[x + lane] = depths[lane];
+					ShadePixel(triangle, x + lane, y, b0[lane], b1[lane], b2[lane]);
+				}
+			}
+		}
+	}
+#else
+	for (int y = minY; y < maxY; y++)
+	{
+		float pixelY = y + 0.5f;
+		float* depthRow = &m_depthBuffer[(size_t)y * m_depthStride];
+
+		float rowE0 = (b[0] * pixelY) + c[0];
+		float rowE1 = (b[1] * pixelY) + c[1];
+		float rowE2 = (b[2] * pixelY) + c[2];
+
+		for (int x = minX; x < maxX; x++)
+		{
+			float pixelX = x + 0.5f;
+
+			float e0 = (a[0] * pixelX) + rowE0;
+			float e1 = (a[1] * pixelX) + rowE1;
+			float e2 = (a[2] * pixelX) + rowE2;
+
+			if ((e0 < 0.0f) || ((e0 == 0.0f) && ((triangle.topLeftMask & 1) == 0)) ||
+				(e1 < 0.0f) || ((e1 == 0.0f) && ((triangle.topLeftMask & 2) == 0)) ||
+				(e2 < 0.0f) || ((e2 == 0.0f) && ((triangle.topLeftMask & 4) == 0)))
+			{
+				continue;
+			}
+
+			float depth = (triangle.depthA * pixelX) + ((triangle.depthB * pixelY) + triangle.depthC);
+			if (depth >= depthRow[x])
+			{
+				continue;
+			}
+
+			depthRow[x] = depth;
+			ShadePixel(triangle, x, y, e0 * triangle.invArea, e1 * triangle.invArea, e2 * triangle.invArea);
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  ShadePixel()
+ *
+ *  This method is used for computing the color of a covered
+ *  pixel the way the fragment shader does: the attributes are
+ *  interpolated with perspective correction, each light that
+ *  reaches the object adds attenuated Phong ambient, diffuse
+ *  and specular terms, and the sum tints the texture or the
+ *  object color, which is then alpha blended over the pixel.
+ ***********************************************************/
+void SoftwareRasterizer::ShadePixel(const RASTER_TRIANGLE& triangle, int x, int y, float b0, float b1, float b2)
+{
+	const SceneManager::DRAW_PACKET& packet = m_packets[triangle.packetIndex];
+
+	// screen space weights divided by w, renormalized, are the weights in 3D
+	float w0 = b0 * triangle.invW[0];
+	float w1 = b1 * triangle.invW[1];
+	float w2 = b2 * triangle.invW[2];
+	float weightScale = 1.0f / (w0 + w1 + w2);
+	w0 *= weightScale;
+	w1 *= weightScale;
+	w2 *= weightScale;
+
+	glm::vec3 position = (triangle.world[0] * w0) + (triangle.world[1] * w1) + (triangle.world[2] * w2);
+	glm::vec3 normal = (triangle.normal[0] * w0) + (triangle.normal[1] * w1) + (triangle.normal[2] * w2);
+	glm::vec2 uv = (triangle.uv[0] * w0) + (triangle.uv[1] * w1) + (triangle.uv[2] * w2);
+
+	float normalLength = glm::length(normal);
+	if (normalLength > 0.0f)
+	{
+		normal /= normalLength;
+	}
+
+	glm::vec4 baseColor = packet.color;
+	if ((packet.textureSlot >= 0) && (packet.textureSlot < (int)m_textures.size()) &&
+		(m_textures[packet.textureSlot].pixels.empty() == false))
+	{
+		baseColor = SampleTexture(packet.textureSlot, uv);
+	}
+
+	// without a material the light colors are used as they are
+	glm::vec3 materialAmbient(1.0f);
+	glm::vec3 materialDiffuse(1.0f);
+	glm::vec3 materialSpecular(1.0f);
+	const SceneManager::OBJECT_MATERIAL* pMaterial = m_pSceneManager->GetMaterial(packet.materialIndex);
+	if (NULL != pMaterial)
+	{
+		materialAmbient = pMaterial->ambientColor * pMaterial->ambientStrength;
+		materialDiffuse = pMaterial->diffuseColor;
+		materialSpecular = pMaterial->specularColor;
+	}
+
+	glm::vec3 viewDirection = glm::normalize(m_viewPosition - position);
+	glm::vec3 lighting(0.0f);
+
+	for (int i = 0; i < SceneManager::MAX_LIGHT_SOURCES; i++)
+	{
+		if ((packet.lightMask & (1u << i)) == 0)
+		{
+			continue;
+		}
+
+		const SceneManager::LIGHT_SOURCE& light = m_lights[i];
+		glm::vec3 toLight = light.position - position;
+		float distance = glm::length(toLight);
+		glm::vec3 lightDirection = (distance > 0.0f) ? (toLight / distance) : normal;
+
+		glm::vec3 ambient = light.ambientColor * materialAmbient;
+
+		float impact = std::max(glm::dot(normal, lightDirection), 0.0f);
+		glm::vec3 diffuse = impact * light.diffuseColor * materialDiffuse;
+
+		glm::vec3 reflectDirection = glm::reflect(-lightDirection, normal);
+		float highlight = powf(std::max(glm::dot(viewDirection, reflectDirection), 0.0f), light.focalStrength);
+		glm::vec3 specular = light.specularIntensity * highlight * light.specularColor * materialSpecular;
+
+		float attenuation = 1.0f / (light.constant + (light.linear * distance) + (light.quadratic * distance * distance));
+		lighting += attenuation * (ambient + diffuse + specular);
+	}
+
+	glm::vec4 source(lighting * glm::vec3(baseColor), baseColor.a);
+
+	uint8_t* pixel = &m_colorBuffer[((size_t)y * m_width + x) * 4];
+	float alpha = glm::clamp(source.a, 0.0f, 1.0f);
+	for (int channel = 0; channel < 4; channel++)
+	{
+		float destination = pixel[channel] / 255.0f;
+		pixel[channel] = ToByte((source[channel] * alpha) + (destination * (1.0f - alpha)));
+	}
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used for reading a texture with bilinear
+ *  filtering and repeat wrapping, like the GL samplers. Row
+ *  zero is v = 0, the order the texture was uploaded in.
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::SampleTexture(int textureSlot, glm::vec2 uv) const
+{
+	const SOFTWARE_TEXTURE& texture = m_textures[textureSlot];
+
+	float texelX = (uv.x * texture.width) - 0.5f;
+	float texelY = (uv.y * texture.height) - 0.5f;
+	float floorX = floorf(texelX);
+	float floorY = floorf(texelY);
+	float fractionX = texelX - floorX;
+	float fractionY = texelY - floorY;
+
+	int x0 = (int)fmodf(floorX, (float)texture.width);
+	int y0 = (int)fmodf(floorY, (float)texture.height);
+	if (x0 < 0)
+	{
+		x0 += texture.width;
+	}
+	if (y0 < 0)
+	{
+		y0 += texture.height;
+	}
+	int x1 = (x0 + 1) % texture.width;
+	int y1 = (y0 + 1) % texture.height;
+
+	const uint8_t* p00 = &texture.pixels[((size_t)y0 * texture.width + x0) * 4];
+	const uint8_t* p10 = &texture.pixels[((size_t)y0 * texture.width + x1) * 4];
+	const uint8_t* p01 = &texture.pixels[((size_t)y1 * texture.width + x0) * 4];
+	const uint8_t* p11 = &texture.pixels[((size_t)y1 * texture.width + x1) * 4];
+
+	glm::vec4 color;
+	for (int channel = 0; channel < 4; channel++)
+	{
+		float top = p00[channel] + ((p10[channel] - p00[channel]) * fractionX);
+		float bottom = p01[channel] + ((p11[channel] - p01[channel]) * fractionX);
+		color[channel] = (top + ((bottom - top) * fractionY)) / 255.0f;
+	}
+
+	return color;
+}
@@ -0,0 +1,150 @@
+/////////////////////////////////////////////////////////////////////////////////
+// SoftwareRasterizer.h
+// ====================
+// multithreaded tile-based CPU renderer for machines without a usable GPU
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SceneManager.h"
+#include "ViewFrustum.h"
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  Draws the culled and sorted draw packets of the scene on
+ *  the CPU, with the fixed vertex format of the shape meshes
+ *  and the Phong lighting the scene sets up for the shader.
+ *  A frame runs in two parallel stages of jobs on the job
+ *  system:
+ *
+ *  - the packets are split into chunks of similar triangle
+ *    counts; each chunk transforms and clips its triangles
+ *    and bins them into the 64x64 pixel screen tiles they
+ *    touch, in its own lists, so no locks are needed
+ *  - each tile then walks the chunks' bins in packet order,
+ *    testing four pixels at a time against the edge
+ *    functions and the depth buffer, and shades the pixels
+ *    that pass, so blending keeps the order of the GL path
+ *
+ *  Textures are copied out of OpenGL once by LoadTextures()
+ *  and sampled bilinearly with repeat wrapping.
+ ***********************************************************/
+class SoftwareRasterizer
+{
+public:
+	// side of a screen tile in pixels
+	static const int TILE_SIZE = 64;
+
+	SoftwareRasterizer();
+	~SoftwareRasterizer();
+
+	// set the threads taking part in each stage, the calling thread
+	// included; threadCount 0 uses every job system worker
+	void Start(int threadCount);
+	// copy the scene textures out of OpenGL; call once after PrepareScene()
+	bool LoadTextures(const SceneManager* pSceneManager);
+
+	// render one view of the scene into the color buffer
+	void RenderView(SceneManager* pSceneManager, const SCENE_VIEW& sceneView, int width, int height);
+
+	// 8-bit RGBA color of the last view, top row first
+	const uint8_t* GetPixels() const { return m_colorBuffer.empty() ? NULL : &m_colorBuffer[0]; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	ptrdiff_t GetRowStride() const { return (ptrdiff_t)m_width * 4; }
+	int GetThreadCount() const { return m_threadCount; }
+
+private:
+	// a shape vertex after the vertex stage
+	struct CLIP_VERTEX
+	{
+		glm::vec4 clip;
+		glm::vec3 world;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// a screen space triangle ready for the tiles
+	struct RASTER_TRIANGLE
+	{
+		// edge functions A*x + B*y + C, positive inside; edge i is opposite vertex i
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// bit i set when edge i is a top or left edge and owns the pixels on it
+		int topLeftMask;
+		float invArea;
+		// depth is linear in screen space: depthA*x + depthB*y + depthC
+		float depthA;
+		float depthB;
+		float depthC;
+		float invW[3];
+		glm::vec3 world[3];
+		glm::vec3 normal[3];
+		glm::vec2 uv[3];
+		// pixel bounds, max exclusive
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		int packetIndex;
+	};
+
+	// the triangles of a run of packets and the tiles each one touches
+	struct GEOMETRY_CHUNK
+	{
+		size_t firstPacket;
+		size_t endPacket;
+		std::vector<RASTER_TRIANGLE> triangles;
+		// triangle indices per tile, in packet order
+		std::vector<std::vector<int>> tileBins;
+	};
+
+	struct SOFTWARE_TEXTURE
+	{
+		int width;
+		int height;
+		std::vector<uint8_t> pixels;
+	};
+
+	// frame state shared by the stages
+	int m_width;
+	int m_height;
+	int m_tileColumns;
+	int m_tileRows;
+	// depth rows are padded to a multiple of four pixels
+	int m_depthStride;
+	std::vector<uint8_t> m_colorBuffer;
+	std::vector<float> m_depthBuffer;
+	glm::mat4 m_viewProjection;
+	glm::vec3 m_viewPosition;
+	std::vector<SceneManager::DRAW_PACKET> m_packets;
+	std::vector<GEOMETRY_CHUNK> m_chunks;
+	size_t m_chunkCount;
+	std::vector<SOFTWARE_TEXTURE> m_textures;
+	const SceneManager* m_pSceneManager;
+	SceneManager::LIGHT_SOURCE m_lights[SceneManager::MAX_LIGHT_SOURCES];
+
+	// threads of the job system each stage may use, the calling thread included
+	int m_threadCount;
+
+	// split the packets into chunks of similar triangle counts
+	void BuildChunks();
+	// transform, clip and bin the triangles of one chunk
+	void ProcessChunk(GEOMETRY_CHUNK& chunk);
+	// set up and bin one clipped triangle
+	void SetupTriangle(GEOMETRY_CHUNK& chunk, const CLIP_VERTEX& v0, const CLIP_VERTEX& v1, const CLIP_VERTEX& v2, int packetIndex);
+	// clear one tile and draw every binned triangle into it
+	void RasterizeTile(int tileIndex);
+	void RasterizeTriangle(const RASTER_TRIANGLE& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+	// light, texture and blend one covered pixel
+	void ShadePixel(const RASTER_TRIANGLE& triangle, int x, int y, float b0, float b1, float b2);
+	glm::vec4 SampleTexture(int textureSlot, glm::vec2 uv) const;
+};
@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////////////////////////
+// StartupReport.cpp
+// =================
+// timing of each startup phase up to the first presented frame
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "StartupReport.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct STARTUP_PHASE_TIME
+	{
+		const char* name;
+		uint64_t startTime;
+		uint64_t endTime;
+		int threadIndex;
+	};
+
+	std::mutex g_StartupMutex;
+	std::vector<STARTUP_PHASE_TIME> g_StartupPhases;
+	// threads in the order they first recorded a phase; the main thread is first
+	std::vector<std::thread::id> g_StartupThreads;
+	bool g_bStartupReportDone = false;
+
+	/***********************************************************
+	 *  GetThreadIndex()
+	 *
+	 *  Must be called with the startup mutex held.
+	 ***********************************************************/
+	int GetThreadIndex()
+	{
+		std::thread::id threadID = std::this_thread::get_id();
+
+		for (size_t i = 0; i < g_StartupThreads.size(); i++)
+		{
+			if (g_StartupThreads[i] == threadID)
+			{
+				return (int)i;
+			}
+		}
+
+		g_StartupThreads.push_back(threadID);
+		return (int)g_StartupThreads.size() - 1;
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ ***********************************************************/
+void StartupReport::Begin()
+{
+	std::lock_guard<std::mutex> lock(g_StartupMutex);
+	GetThreadIndex();
+}
+
+/***********************************************************
+ *  AddPhase()
+ ***********************************************************/
+void StartupReport::AddPhase(const char* phaseName, uint64_t startTime, uint64_t endTime)
+{
+	Profiler::RecordEvent(phaseName, startTime, endTime);
+
+	std::lock_guard<std::mutex> lock(g_StartupMutex);
+	if (g_bStartupReportDone)
+	{
+		return;
+	}
+
+	STARTUP_PHASE_TIME phase;
+	phase.name = phaseName;
+	phase.startTime = startTime;
+	phase.endTime = endTime;
+	phase.threadIndex = GetThreadIndex();
+	g_StartupPhases.push_back(phase);
+}
+
+/***********************************************************
+ *  PrintReport()
+ *
+ *  This method is used for printing the phases in the order
+ *  they started, with nested phases following the phase that
+ *  contains them. Times are from process start, so the last
+ *  line is the time to the first frame.
+ ***********************************************************/
+void StartupReport::PrintReport()
+{
+	uint64_t firstFrameTime = Profiler::Now();
+
+	std::lock_guard<std::mutex> lock(g_StartupMutex);
+	if (g_bStartupReportDone)
+	{
+		return;
+	}
+	g_bStartupReportDone = true;
+
+	std::stable_sort(g_StartupPhases.begin(), g_StartupPhases.end(),
+		[](const STARTUP_PHASE_TIME& a, const STARTUP_PHASE_TIME& b)
+		{
+			return a.startTime < b.startTime;
+		});
+
+	printf("INFO: Startup phases\n");
+	printf("  %-26s %10s %12s  %s\n", "phase", "start ms", "duration ms", "thread");
+	for (size_t i = 0; i < g_StartupPhases.size(); i++)
+	{
+		const STARTUP_PHASE_TIME& phase = g_StartupPhases[i];
+		char threadName[16];
+		if (phase.threadIndex == 0)
+		{
+			snprintf(threadName, sizeof(threadName), "main");
+		}
+		else
+		{
+			snprintf(threadName, sizeof(threadName), "worker %d", phase.threadIndex);
+		}
+
+		printf("  %-26s %10.2f %12.2f  %s\n",
+			phase.name,
+			phase.startTime / 1.0e6,
+			(phase.endTime - phase.startTime) / 1.0e6,
+			threadName);
+	}
+	printf("  time to first frame: %.2f ms\n\n", firstFrameTime / 1.0e6);
+	fflush(stdout);
+
+	g_StartupPhases.clear();
+}
+
+/***********************************************************
+ *  StopRecording()
+ ***********************************************************/
+void StartupReport::StopRecording()
+{
+	std::lock_guard<std::mutex> lock(g_StartupMutex);
+	g_bStartupReportDone = true;
+	g_StartupPhases.clear();
+}
+
+/***********************************************************
+ *  StartupPhase()
+ ***********************************************************/
+StartupPhase::StartupPhase(const char* phaseName)
+	: m_phaseName(phaseName),
+	m_startTime(Profiler::Now())
+{
+}
+
+/***********************************************************
+ *  ~StartupPhase()
+ ***********************************************************/
+StartupPhase::~StartupPhase()
+{
+	StartupReport::AddPhase(m_phaseName, m_startTime, Profiler::Now());
+}
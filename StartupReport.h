@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////////////
+// StartupReport.h
+// ===============
+// timing of each startup phase up to the first presented frame
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include "Profiler.h"
+
+/***********************************************************
+ *  StartupReport
+ *
+ *  Phases may be recorded from any thread until the report is
+ *  printed; after that, recording stops so later mesh or
+ *  texture loads do not grow the list. Phase times use the
+ *  profiler clock and are also recorded as profiler events.
+ ***********************************************************/
+class StartupReport
+{
+public:
+	// mark the calling thread as the main thread in the report
+	static void Begin();
+	// record a finished phase; the name must stay valid until the report is printed
+	static void AddPhase(const char* phaseName, uint64_t startTime, uint64_t endTime);
+	// print every phase and the time to the first frame, then stop recording
+	static void PrintReport();
+	// stop recording without a report, for runs that never present a frame
+	static void StopRecording();
+};
+
+/***********************************************************
+ *  StartupPhase
+ *
+ *  Records one startup phase covering the lifetime of the
+ *  object.
+ ***********************************************************/
+class StartupPhase
+{
+public:
+	explicit StartupPhase(const char* phaseName);
+	~StartupPhase();
+
+private:
+	const char* m_phaseName;
+	uint64_t m_startTime;
+};
+
+// time the rest of the enclosing block as a startup phase
+#define STARTUP_PHASE(phaseName) StartupPhase PROFILE_CONCAT(startupPhase, __LINE__)(phaseName)
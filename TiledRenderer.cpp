@@ -0,0 +1,343 @@
+/////////////////////////////////////////////////////////////////////////////////
+// TiledRenderer.cpp
+// =================
+// offline rendering of images larger than any framebuffer, one tile at a time
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "TiledRenderer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "GLFW/glfw3.h"
+
+#include <glm/gtx/transform.hpp>
+
+namespace
+{
+	// largest tile side, also limited by the driver's renderbuffer and viewport sizes
+	const int g_MaxTileSize = 2048;
+
+	/***********************************************************
+	 *  SeekTo()
+	 *
+	 *  Output images pass the 2 GB a long can address, so seek
+	 *  with a 64-bit offset.
+	 ***********************************************************/
+	bool SeekTo(FILE* file, uint64_t offset)
+	{
+#ifdef _WIN32
+		return (_fseeki64(file, (__int64)offset, SEEK_SET) == 0);
+#else
+		return (fseeko(file, (off_t)offset, SEEK_SET) == 0);
+#endif
+	}
+}
+
+/***********************************************************
+ *  TiledRenderer()
+ ***********************************************************/
+TiledRenderer::TiledRenderer()
+	: m_framebuffer(0),
+	m_colorBuffer(0),
+	m_depthBuffer(0),
+	m_tileSize(0)
+{
+	memset(m_tiles, 0, sizeof(m_tiles));
+}
+
+/***********************************************************
+ *  ~TiledRenderer()
+ ***********************************************************/
+TiledRenderer::~TiledRenderer()
+{
+	DestroyTileTarget();
+}
+
+/***********************************************************
+ *  BuildTileProjection()
+ *
+ *  This method is used for narrowing a projection to one tile
+ *  of the image. The tile's rectangle in normalized device
+ *  coordinates is scaled and moved to fill the -1..1 range,
+ *  applied after the projection, which works the same for a
+ *  perspective and an orthographic projection. Pixels keep
+ *  the size they have in the full image, so the tiles join
+ *  without seams.
+ ***********************************************************/
+glm::mat4 TiledRenderer::BuildTileProjection(
+	const glm::mat4& projection,
+	int imageWidth,
+	int imageHeight,
+	int tileX,
+	int tileY,
+	int tileWidth,
+	int tileHeight)
+{
+	// normalized device y points up while image rows count down
+	float left = -1.0f + 2.0f * tileX / imageWidth;
+	float right = left + 2.0f * tileWidth / imageWidth;
+	float top = 1.0f - 2.0f * tileY / imageHeight;
+	float bottom = top - 2.0f * tileHeight / imageHeight;
+
+	glm::mat4 tileScale = glm::scale(glm::vec3(
+		(float)imageWidth / tileWidth,
+		(float)imageHeight / tileHeight,
+		1.0f));
+	glm::mat4 tileOffset = glm::translate(glm::vec3(
+		-(left + right) * 0.5f,
+		-(top + bottom) * 0.5f,
+		0.0f));
+
+	return tileScale * tileOffset * projection;
+}
+
+/***********************************************************
+ *  RenderImage()
+ *
+ *  This method is used for rendering the tiles left to right,
+ *  top to bottom. After each tile is drawn its readback is
+ *  queued, and the tile before it is written while the GPU
+ *  works on the new one. Tiles on the right and bottom edges
+ *  are drawn at full size and only their part inside the
+ *  image is read back.
+ ***********************************************************/
+bool TiledRenderer::RenderImage(
+	SceneManager* pSceneManager,
+	const CAMERA_POSE& pose,
+	int width,
+	int height,
+	const char* filename)
+{
+	PROFILE_SCOPE("TiledRender");
+
+	if ((NULL == pSceneManager) || (width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	GLint maxRenderbufferSize = 0;
+	GLint maxViewportSize[2] = { 0, 0 };
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbufferSize);
+	glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewportSize);
+	int tileSize = std::min(g_MaxTileSize, (int)maxRenderbufferSize);
+	tileSize = std::min(tileSize, (int)std::min(maxViewportSize[0], maxViewportSize[1]));
+	tileSize = std::min(tileSize, std::max(width, height));
+
+	if (CreateTileTarget(tileSize) == false)
+	{
+		return false;
+	}
+
+	FILE* file = fopen(filename, "wb");
+	if (NULL == file)
+	{
+		std::cout << "Could not open image file for writing: " << filename << std::endl;
+		DestroyTileTarget();
+		return false;
+	}
+
+	char header[64];
+	int headerSize = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+	bool bWritten = (fwrite(header, 1, headerSize, file) == (size_t)headerSize);
+
+	// the whole image shares one view; each tile narrows the projection
+	SCENE_VIEW fullView;
+	ViewManager::BuildCameraPoseView(pose, (float)width / height, fullView);
+
+	SCENE_VIEW tileView = fullView;
+	tileView.viewportRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+	double startTime = glfwGetTime();
+	int columns = (width + tileSize - 1) / tileSize;
+	int rows = (height + tileSize - 1) / tileSize;
+	int tileIndex = 0;
+
+	// tile rows are tightly packed RGB; the caller's alignment is put back afterwards
+	GLint previousPackAlignment = 4;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &previousPackAlignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	for (int row = 0; (row < rows) && bWritten; row++)
+	{
+		for (int column = 0; (column < columns) && bWritten; column++)
+		{
+			PENDING_TILE& tile = m_tiles[tileIndex % 2];
+			PENDING_TILE& previousTile = m_tiles[(tileIndex + 1) % 2];
+			tileIndex++;
+
+			tile.x = column * tileSize;
+			tile.y = row * tileSize;
+			tile.width = std::min(tileSize, width - tile.x);
+			tile.height = std::min(tileSize, height - tile.y);
+
+			tileView.projection = BuildTileProjection(
+				fullView.projection, width, height, tile.x, tile.y, tileSize, tileSize);
+			tileView.viewProjection = tileView.projection * tileView.view;
+			tileView.frustum.ExtractPlanes(tileView.viewProjection);
+
+			{
+				PROFILE_SCOPE("RenderTile");
+				glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+				glViewport(0, 0, tileSize, tileSize);
+				glEnable(GL_DEPTH_TEST);
+				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				pSceneManager->RenderSceneViews(&tileView, 1, tileSize, tileSize);
+
+				// the tile's top rows hold the part inside the image
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, tile.pixelBuffer);
+				glReadPixels(0, tileSize - tile.height, tile.width, tile.height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				tile.bPending = true;
+			}
+
+			if (previousTile.bPending)
+			{
+				bWritten = WriteTile(previousTile, file, width, headerSize);
+			}
+		}
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (bWritten && m_tiles[i].bPending)
+		{
+			bWritten = WriteTile(m_tiles[i], file, width, headerSize);
+		}
+		m_tiles[i].bPending = false;
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, previousPackAlignment);
+
+	if (fclose(file) != 0)
+	{
+		bWritten = false;
+	}
+	DestroyTileTarget();
+
+	if (bWritten == false)
+	{
+		std::cout << "Could not write image file: " << filename << std::endl;
+		return false;
+	}
+
+	double elapsedSeconds = glfwGetTime() - startTime;
+	std::cout << "INFO: Rendered " << width << "x" << height << " image to " << filename
+		<< " in " << columns * rows << " tiles of " << tileSize << "x" << tileSize
+		<< ", " << elapsedSeconds << " s" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  WriteTile()
+ *
+ *  This method is used for writing a tile's rows to where they
+ *  belong in the file. The readback is bottom-up, so the last
+ *  row of the buffer is the tile's top row.
+ ***********************************************************/
+bool TiledRenderer::WriteTile(PENDING_TILE& tile, FILE* file, int imageWidth, uint64_t headerSize)
+{
+	PROFILE_SCOPE("WriteTile");
+
+	tile.bPending = false;
+
+	size_t rowSize = (size_t)tile.width * 3;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, tile.pixelBuffer);
+	const uint8_t* pPixels = (const uint8_t*)glMapBufferRange(
+		GL_PIXEL_PACK_BUFFER, 0, rowSize * tile.height, GL_MAP_READ_BIT);
+	if (NULL == pPixels)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		std::cout << "Could not map the tile readback buffer" << std::endl;
+		return false;
+	}
+
+	bool bWritten = true;
+	for (int row = 0; (row < tile.height) && bWritten; row++)
+	{
+		uint64_t offset = headerSize + ((uint64_t)(tile.y + row) * imageWidth + tile.x) * 3;
+		const uint8_t* pRow = pPixels + (size_t)(tile.height - 1 - row) * rowSize;
+		bWritten = SeekTo(file, offset) && (fwrite(pRow, 1, rowSize, file) == rowSize);
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	return bWritten;
+}
+
+/***********************************************************
+ *  CreateTileTarget()
+ ***********************************************************/
+bool TiledRenderer::CreateTileTarget(int tileSize)
+{
+	DestroyTileTarget();
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, tileSize, tileSize);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, tileSize, tileSize);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Could not create the " << tileSize << "x" << tileSize << " tile framebuffer" << std::endl;
+		DestroyTileTarget();
+		return false;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		glGenBuffers(1, &m_tiles[i].pixelBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_tiles[i].pixelBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)tileSize * tileSize * 3, NULL, GL_STREAM_READ);
+		m_tiles[i].bPending = false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	m_tileSize = tileSize;
+	return true;
+}
+
+/***********************************************************
+ *  DestroyTileTarget()
+ ***********************************************************/
+void TiledRenderer::DestroyTileTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_tiles[i].pixelBuffer != 0)
+		{
+			glDeleteBuffers(1, &m_tiles[i].pixelBuffer);
+			m_tiles[i].pixelBuffer = 0;
+		}
+		m_tiles[i].bPending = false;
+	}
+
+	m_tileSize = 0;
+}
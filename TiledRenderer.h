@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////
+// TiledRenderer.h
+// ===============
+// offline rendering of images larger than any framebuffer, one tile at a time
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include <GL/glew.h>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+
+/***********************************************************
+ *  TiledRenderer
+ *
+ *  Renders one camera pose at an arbitrary output size. The
+ *  image is split into square tiles, and each tile is drawn
+ *  into a small offscreen framebuffer with the part of the
+ *  full projection that covers it, so every tile also culls
+ *  against its own narrower frustum. Tiles are read back
+ *  through two pixel pack buffers, one drawing while the
+ *  other is written, and each tile's rows are written into
+ *  place in a binary PPM file, so neither the framebuffer nor
+ *  memory ever holds more than two tiles.
+ ***********************************************************/
+class TiledRenderer
+{
+public:
+	TiledRenderer();
+	~TiledRenderer();
+
+	// render the pose at width x height and write it to a PPM file
+	bool RenderImage(
+		SceneManager* pSceneManager,
+		const CAMERA_POSE& pose,
+		int width,
+		int height,
+		const char* filename);
+
+	// the projection covering only the pixel rectangle of a tile, given
+	// from the top left corner, of an image with the full projection
+	static glm::mat4 BuildTileProjection(
+		const glm::mat4& projection,
+		int imageWidth,
+		int imageHeight,
+		int tileX,
+		int tileY,
+		int tileWidth,
+		int tileHeight);
+
+private:
+	// a tile whose readback has been started but not yet written
+	struct PENDING_TILE
+	{
+		GLuint pixelBuffer;
+		int x;
+		int y;
+		int width;
+		int height;
+		bool bPending;
+	};
+
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_tileSize;
+
+	PENDING_TILE m_tiles[2];
+
+	// create the tile framebuffer and the two pack buffers
+	bool CreateTileTarget(int tileSize);
+	void DestroyTileTarget();
+
+	// copy a finished tile out of its pack buffer into the file
+	bool WriteTile(PENDING_TILE& tile, FILE* file, int imageWidth, uint64_t headerSize);
+};
@@ -0,0 +1,284 @@
+/////////////////////////////////////////////////////////////////////////////////
+// ViewFrustum.cpp
+// ===============
+// view frustum planes and visibility tests against scene bounds
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "ViewFrustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIEWFRUSTUM_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+/***********************************************************
+ *  PACKED_BOUNDS::Resize()
+ *
+ *  Size the arrays for the object count, rounded up to a
+ *  multiple of 4. Existing entries are kept; padding entries
+ *  are moved far outside any frustum so the SIMD loop can
+ *  skip a partly filled group early.
+ ***********************************************************/
+void PACKED_BOUNDS::Resize(size_t objectCount)
+{
+	size_t paddedCount = (objectCount + 3) & ~static_cast<size_t>(3);
+
+	centerX.resize(paddedCount, 0.0f);
+	centerY.resize(paddedCount, 0.0f);
+	centerZ.resize(paddedCount, 0.0f);
+	extentX.resize(paddedCount, 0.0f);
+	extentY.resize(paddedCount, 0.0f);
+	extentZ.resize(paddedCount, 0.0f);
+
+	for (size_t i = objectCount; i < paddedCount; i++)
+	{
+		centerX[i] = 1.0e30f;
+	}
+
+	count = objectCount;
+}
+
+/***********************************************************
+ *  PACKED_BOUNDS::Set()
+ ***********************************************************/
+void PACKED_BOUNDS::Set(size_t index, const BOUNDING_VOLUME& bounds)
+{
+	glm::vec3 center = (bounds.minXYZ + bounds.maxXYZ) * 0.5f;
+	glm::vec3 extents = (bounds.maxXYZ - bounds.minXYZ) * 0.5f;
+
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extents.x;
+	extentY[index] = extents.y;
+	extentZ[index] = extents.z;
+}
+
+/***********************************************************
+ *  ViewFrustum()
+ ***********************************************************/
+ViewFrustum::ViewFrustum()
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f);
+	}
+	m_bValid = false;
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for pulling the six clipping planes
+ *  out of the rows of the view-projection matrix. GLM stores
+ *  matrices by column, so row i is (m[0][i], m[1][i], ...).
+ ***********************************************************/
+void ViewFrustum::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(
+			viewProjection[0][i],
+			viewProjection[1][i],
+			viewProjection[2][i],
+			viewProjection[3][i]);
+	}
+
+	m_planes[PLANE_LEFT] = rows[3] + rows[0];
+	m_planes[PLANE_RIGHT] = rows[3] - rows[0];
+	m_planes[PLANE_BOTTOM] = rows[3] + rows[1];
+	m_planes[PLANE_TOP] = rows[3] - rows[1];
+	m_planes[PLANE_NEAR] = rows[3] + rows[2];
+	m_planes[PLANE_FAR] = rows[3] - rows[2];
+
+	// normalize so the plane distances are in world units
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] = m_planes[i] / length;
+		}
+	}
+
+	m_bValid = true;
+}
+
+/***********************************************************
+ *  TestSphere()
+ ***********************************************************/
+bool ViewFrustum::TestSphere(const glm::vec3& center, float radius) const
+{
+	if (m_bValid == false)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		if (glm::dot(glm::vec3(m_planes[i]), center) + m_planes[i].w < -radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  TestBox()
+ ***********************************************************/
+bool ViewFrustum::TestBox(const glm::vec3& minXYZ, const glm::vec3& maxXYZ) const
+{
+	if (m_bValid == false)
+	{
+		return true;
+	}
+
+	glm::vec3 center = (minXYZ + maxXYZ) * 0.5f;
+	glm::vec3 extents = (maxXYZ - minXYZ) * 0.5f;
+
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		glm::vec3 normal = glm::vec3(m_planes[i]);
+
+		// distance of the center, plus the box reach along the plane normal
+		float distance = glm::dot(normal, center) + m_planes[i].w;
+		float reach = glm::dot(glm::abs(normal), extents);
+
+		if (distance + reach < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  CullPackedBounds()
+ *
+ *  This method is used for testing every object in the packed
+ *  bounds against all six planes. Four boxes are tested per
+ *  iteration; an object is visible unless it lies completely
+ *  behind at least one plane.
+ ***********************************************************/
+void ViewFrustum::CullPackedBounds(const PACKED_BOUNDS& bounds, std::vector<int>& visibleIndices) const
+{
+	CullPackedBounds(bounds, 0, bounds.count, visibleIndices);
+}
+
+/***********************************************************
+ *  CullPackedBounds()
+ *
+ *  This method is used for testing one range of the packed
+ *  bounds. The range starts on a group of four so the SIMD
+ *  loads stay within the padded arrays.
+ ***********************************************************/
+void ViewFrustum::CullPackedBounds(
+	const PACKED_BOUNDS& bounds,
+	size_t firstIndex,
+	size_t endIndex,
+	std::vector<int>& visibleIndices) const
+{
+	endIndex = std::min(endIndex, bounds.count);
+
+	if (m_bValid == false)
+	{
+		for (size_t i = firstIndex; i < endIndex; i++)
+		{
+			visibleIndices.push_back(static_cast<int>(i));
+		}
+		return;
+	}
+
+#ifdef VIEWFRUSTUM_USE_SSE
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 planeX[PLANE_COUNT];
+	__m128 planeY[PLANE_COUNT];
+	__m128 planeZ[PLANE_COUNT];
+	__m128 planeW[PLANE_COUNT];
+	__m128 absPlaneX[PLANE_COUNT];
+	__m128 absPlaneY[PLANE_COUNT];
+	__m128 absPlaneZ[PLANE_COUNT];
+
+	for (int p = 0; p < PLANE_COUNT; p++)
+	{
+		planeX[p] = _mm_set1_ps(m_planes[p].x);
+		planeY[p] = _mm_set1_ps(m_planes[p].y);
+		planeZ[p] = _mm_set1_ps(m_planes[p].z);
+		planeW[p] = _mm_set1_ps(m_planes[p].w);
+		absPlaneX[p] = _mm_andnot_ps(signMask, planeX[p]);
+		absPlaneY[p] = _mm_andnot_ps(signMask, planeY[p]);
+		absPlaneZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (size_t i = firstIndex; i < endIndex; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+		__m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+		__m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+		__m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+		__m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+		// lanes that end up set are outside at least one plane
+		__m128 outside = zero;
+
+		for (int p = 0; p < PLANE_COUNT; p++)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, planeX[p]), _mm_mul_ps(cy, planeY[p])),
+				_mm_add_ps(_mm_mul_ps(cz, planeZ[p]), planeW[p]));
+			__m128 reach = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(ex, absPlaneX[p]), _mm_mul_ps(ey, absPlaneY[p])),
+				_mm_mul_ps(ez, absPlaneZ[p]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		if (outsideMask == 0xF)
+		{
+			continue;
+		}
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			size_t index = i + lane;
+			if ((index < endIndex) && ((outsideMask & (1 << lane)) == 0))
+			{
+				visibleIndices.push_back(static_cast<int>(index));
+			}
+		}
+	}
+#else
+	for (size_t i = firstIndex; i < endIndex; i++)
+	{
+		bool bVisible = true;
+
+		for (int p = 0; (p < PLANE_COUNT) && bVisible; p++)
+		{
+			float distance = (bounds.centerX[i] * m_planes[p].x) +
+				(bounds.centerY[i] * m_planes[p].y) +
+				(bounds.centerZ[i] * m_planes[p].z) + m_planes[p].w;
+			float reach = (bounds.extentX[i] * fabsf(m_planes[p].x)) +
+				(bounds.extentY[i] * fabsf(m_planes[p].y)) +
+				(bounds.extentZ[i] * fabsf(m_planes[p].z));
+
+			bVisible = (distance + reach >= 0.0f);
+		}
+
+		if (bVisible)
+		{
+			visibleIndices.push_back(static_cast<int>(i));
+		}
+	}
+#endif
+}
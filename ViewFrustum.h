@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////////////
+// ViewFrustum.h
+// =============
+// view frustum planes and visibility tests against scene bounds
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SceneBounds.h"
+
+/***********************************************************
+ *  PACKED_BOUNDS
+ *
+ *  Object bounds stored as separate arrays of box centers and
+ *  extents, so four objects can be tested against a plane
+ *  with one set of SIMD instructions.
+ ***********************************************************/
+struct PACKED_BOUNDS
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+
+	// number of valid objects (the arrays are padded to a multiple of 4)
+	size_t count = 0;
+
+	void Resize(size_t objectCount);
+	void Set(size_t index, const BOUNDING_VOLUME& bounds);
+};
+
+/***********************************************************
+ *  ViewFrustum
+ *
+ *  The six clipping planes of a view-projection matrix, with
+ *  tests for single bounds and for packed arrays of bounds.
+ ***********************************************************/
+class ViewFrustum
+{
+public:
+	enum FRUSTUM_PLANE
+	{
+		PLANE_LEFT = 0,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_COUNT
+	};
+
+	ViewFrustum();
+
+	// extract the planes from a combined projection * view matrix
+	void ExtractPlanes(const glm::mat4& viewProjection);
+
+	// true if the frustum has been set from a matrix
+	bool IsValid() const { return m_bValid; }
+
+	// true if the bounding sphere is at least partly inside
+	bool TestSphere(const glm::vec3& center, float radius) const;
+	// true if the bounding box is at least partly inside
+	bool TestBox(const glm::vec3& minXYZ, const glm::vec3& maxXYZ) const;
+
+	// append the indices of the packed bounds that are visible
+	void CullPackedBounds(const PACKED_BOUNDS& bounds, std::vector<int>& visibleIndices) const;
+	// the same for the objects from firstIndex, a multiple of 4, up to endIndex,
+	// so separate threads can cull separate ranges
+	void CullPackedBounds(
+		const PACKED_BOUNDS& bounds,
+		size_t firstIndex,
+		size_t endIndex,
+		std::vector<int>& visibleIndices) const;
+
+	const glm::vec4& GetPlane(int plane) const { return m_planes[plane]; }
+
+private:
+	// planes stored as (normal.xyz, distance), normals pointing inward
+	glm::vec4 m_planes[PLANE_COUNT];
+	bool m_bValid;
+};
+
+/***********************************************************
+ *  SCENE_VIEW
+ *
+ *  One camera view of the scene and the part of the window
+ *  it is drawn into.
+ ***********************************************************/
+struct SCENE_VIEW
+{
+	// left, bottom, width and height as fractions of the framebuffer
+	glm::vec4 viewportRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+	// projection * view, and the frustum extracted from it
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+	ViewFrustum frustum;
+};
@@ -1,336 +1,804 @@
-/////////////////////////////////////////////////////////////////////////////////
-// ViewManager.cpp
-// ===============
-// Manage the viewing of 3D objects within the viewport
-//
-// AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-// Updated for CS-330 Milestone Three:
-// - WASD + QE camera movement
-// - Mouse look (cursor)
-// - Mouse scroll adjusts movement speed
-// - P = perspective, O = orthographic
-//
-// Notes:
-// - This version does NOT rely on Camera::ProcessMouseMovement.
-// - It updates the camera Front vector directly using yaw/pitch.
-// - It will work even if your Camera class is minimal.
-/////////////////////////////////////////////////////////////////////////////////
-
-#include "ViewManager.h"
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-// declaration of the global variables and defines
-namespace
-{
-	// Variables for window width and height
-	const int WINDOW_WIDTH = 1000;
-	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
-
-	// camera object used for viewing and interacting with the 3D scene
-	Camera* g_pCamera = nullptr;
-
-	// mouse movement processing
-	float gLastX = WINDOW_WIDTH / 2.0f;
-	float gLastY = WINDOW_HEIGHT / 2.0f;
-	bool gFirstMouse = true;
-
-	// yaw/pitch for mouse-look (degrees)
-	float gYaw = -90.0f;
-	float gPitch = 0.0f;
-
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f;
-	float gLastFrame = 0.0f;
-
-	// tuning
-	float gMouseSensitivity = 0.35f; // was 0.10f, increased so mouse look is noticeable
-	float gBaseMoveSpeed = 3.5f;
-	float gSpeedMultiplier = 1.0f;
-
-	// projection toggle
-	bool bOrthographicProjection = false;
-	float gOrthoScale = 3.5f;
-
-	// key edge detection so toggles happen once per press
-	bool gPrevPDown = false;
-	bool gPrevODown = false;
-}
-
-/***********************************************************
- *  ViewManager()
- ***********************************************************/
-ViewManager::ViewManager(ShaderManager* pShaderManager)
-{
-	// initialize the member variables
-	m_pShaderManager = pShaderManager;
-	m_pWindow = NULL;
-
-	g_pCamera = new Camera();
-
-	// default camera view parameters (perspective mode)
-	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
-
-	// Normalize the front vector so movement and mouse look feel correct
-	g_pCamera->Front = glm::normalize(glm::vec3(0.0f, -0.25f, -1.0f));
-
-	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-	g_pCamera->Zoom = 80.0f;
-}
-
-/***********************************************************
- *  ~ViewManager()
- ***********************************************************/
-ViewManager::~ViewManager()
-{
-	m_pShaderManager = NULL;
-	m_pWindow = NULL;
-
-	if (NULL != g_pCamera)
-	{
-		delete g_pCamera;
-		g_pCamera = NULL;
-	}
-}
-
-/***********************************************************
- *  CreateDisplayWindow()
- ***********************************************************/
-GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
-{
-	GLFWwindow* window = nullptr;
-
-	window = glfwCreateWindow(
-		WINDOW_WIDTH,
-		WINDOW_HEIGHT,
-		windowTitle,
-		NULL, NULL);
-
-	if (window == NULL)
-	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return NULL;
-	}
-
-	glfwMakeContextCurrent(window);
-
-	// capture mouse for camera look
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// callbacks
-	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
-	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
-
-	// enable blending for supporting transparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	m_pWindow = window;
-	return(window);
-}
-
-/***********************************************************
- *  Mouse_Position_Callback()
- ***********************************************************/
-void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
-{
-	if (g_pCamera == nullptr)
-	{
-		return;
-	}
-
-	// Optional: disable mouse-look in orthographic mode
-	if (bOrthographicProjection)
-	{
-		return;
-	}
-
-	float xpos = (float)xMousePos;
-	float ypos = (float)yMousePos;
-
-	if (gFirstMouse)
-	{
-		gLastX = xpos;
-		gLastY = ypos;
-		gFirstMouse = false;
-	}
-
-	float xoffset = xpos - gLastX;
-	float yoffset = gLastY - ypos; // reversed
-
-	gLastX = xpos;
-	gLastY = ypos;
-
-	// apply sensitivity
-	xoffset *= gMouseSensitivity;
-	yoffset *= gMouseSensitivity;
-
-	// update yaw/pitch
-	gYaw += xoffset;
-	gPitch += yoffset;
-
-	// clamp pitch to prevent flipping
-	if (gPitch > 89.0f) gPitch = 89.0f;
-	if (gPitch < -89.0f) gPitch = -89.0f;
-
-	// calculate front vector from yaw/pitch
-	glm::vec3 front;
-	front.x = cos(glm::radians(gYaw)) * cos(glm::radians(gPitch));
-	front.y = sin(glm::radians(gPitch));
-	front.z = sin(glm::radians(gYaw)) * cos(glm::radians(gPitch));
-
-	g_pCamera->Front = glm::normalize(front);
-}
-
-/***********************************************************
- *  Mouse_Scroll_Callback()
- ***********************************************************/
-void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset)
-{
-	// scroll up increases speed, scroll down decreases speed
-	gSpeedMultiplier += (float)yOffset * 0.1f;
-
-	// clamp multiplier
-	if (gSpeedMultiplier < 0.2f) gSpeedMultiplier = 0.2f;
-	if (gSpeedMultiplier > 4.0f) gSpeedMultiplier = 4.0f;
-}
-
-/***********************************************************
- *  ProcessKeyboardEvents()
- ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
-{
-	if (m_pWindow == NULL || g_pCamera == nullptr)
-	{
-		return;
-	}
-
-	// close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-	{
-		glfwSetWindowShouldClose(m_pWindow, true);
-	}
-
-	// Projection toggle (edge-triggered)
-	bool pDown = glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS;
-	bool oDown = glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS;
-
-	if (pDown && !gPrevPDown)
-	{
-		bOrthographicProjection = false;
-	}
-	if (oDown && !gPrevODown)
-	{
-		bOrthographicProjection = true;
-	}
-
-	gPrevPDown = pDown;
-	gPrevODown = oDown;
-
-	// movement amount this frame
-	float velocity = gBaseMoveSpeed * gSpeedMultiplier * gDeltaTime;
-
-	// WASD + QE movement (allowed in both modes, but orthographic view is usually fixed)
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
-	{
-		g_pCamera->Position += g_pCamera->Front * velocity;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
-	{
-		g_pCamera->Position -= g_pCamera->Front * velocity;
-	}
-
-	glm::vec3 right = glm::normalize(glm::cross(g_pCamera->Front, g_pCamera->Up));
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-	{
-		g_pCamera->Position -= right * velocity;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-	{
-		g_pCamera->Position += right * velocity;
-	}
-
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-	{
-		g_pCamera->Position -= g_pCamera->Up * velocity;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-	{
-		g_pCamera->Position += g_pCamera->Up * velocity;
-	}
-}
-
-/***********************************************************
- *  PrepareSceneView()
- ***********************************************************/
-void ViewManager::PrepareSceneView()
-{
-	if (m_pWindow == NULL || g_pCamera == nullptr)
-	{
-		return;
-	}
-
-	glm::mat4 view;
-	glm::mat4 projection;
-
-	// per-frame timing
-	float currentFrame = (float)glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
-
-	// process keyboard input
-	ProcessKeyboardEvents();
-
-	// view matrix
-	if (!bOrthographicProjection)
-	{
-		view = g_pCamera->GetViewMatrix();
-	}
-	else
-	{
-		// Orthographic view: look directly at the mug and keep it centered
-		glm::vec3 target = glm::vec3(0.0f, 0.85f, -2.8f);
-		glm::vec3 orthoCamPos = target + glm::vec3(0.0f, 1.5f, 6.0f);
-
-		view = glm::lookAt(
-			orthoCamPos,
-			target,
-			glm::vec3(0.0f, 1.0f, 0.0f));
-	}
-
-	// projection matrix
-	if (!bOrthographicProjection)
-	{
-		projection = glm::perspective(
-			glm::radians(g_pCamera->Zoom),
-			(GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT,
-			0.1f,
-			100.0f);
-	}
-	else
-	{
-		float aspect = (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT;
-
-		projection = glm::ortho(
-			-gOrthoScale * aspect,
-			gOrthoScale * aspect,
-			-gOrthoScale,
-			gOrthoScale,
-			0.1f,
-			100.0f);
-	}
-
-	// send to shader
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
-	}
-}
\ No newline at end of file
+/////////////////////////////////////////////////////////////////////////////////
+// ViewManager.cpp
+// ===============
+// Manage the viewing of 3D objects within the viewport
+//
+// AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+// Updated for CS-330 Milestone Three:
+// - WASD + QE camera movement
+// - Mouse look (cursor)
+// - Mouse scroll adjusts movement speed
+// - P = perspective, O = orthographic
+//
+// Notes:
+// - This version does NOT rely on Camera::ProcessMouseMovement.
+// - It updates the camera Front vector directly using yaw/pitch.
+// - It will work even if your Camera class is minimal.
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "ViewManager.h"
+#include "Profiler.h"
+#include "StartupReport.h"
+#include "RenderStats.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// declaration of the global variables and defines
+namespace
+{
+	// Variables for window width and height
+	const int WINDOW_WIDTH = 1000;
+	const int WINDOW_HEIGHT = 800;
+	const char* g_ViewName = "view";
+	const char* g_ProjectionName = "projection";
+
+	// tuning
+	float gMouseSensitivity = 0.35f; // was 0.10f, increased so mouse look is noticeable
+	float gBaseMoveSpeed = 3.5f;
+
+	// orthographic view size
+	float gOrthoScale = 3.5f;
+
+	// point the orthographic view and the fixed cameras look at
+	const glm::vec3 g_FixedViewTarget = glm::vec3(0.0f, 0.85f, -2.8f);
+
+	// fixed camera for the extra views of the multi-view layouts
+	struct FIXED_CAMERA
+	{
+		glm::vec3 eyeOffset;
+		glm::vec3 up;
+		bool bOrthographic;
+	};
+
+	const FIXED_CAMERA g_FrontCamera = { glm::vec3(0.0f, 1.5f, 6.0f), glm::vec3(0.0f, 1.0f, 0.0f), true };
+	const FIXED_CAMERA g_OverviewCamera = { glm::vec3(7.0f, 6.0f, 9.0f), glm::vec3(0.0f, 1.0f, 0.0f), false };
+	const FIXED_CAMERA g_TopCamera = { glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), true };
+	const FIXED_CAMERA g_SideCamera = { glm::vec3(9.0f, 1.5f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), false };
+
+	// one view of a layout: its fixed camera, or NULL for the
+	// interactive camera, and its left, bottom, width and height
+	// as fractions of the window
+	struct LAYOUT_VIEW
+	{
+		const FIXED_CAMERA* pCamera;
+		glm::vec4 viewportRect;
+	};
+
+	const LAYOUT_VIEW g_SingleLayout[] =
+	{
+		{ NULL, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) }
+	};
+	const LAYOUT_VIEW g_SplitLayout[] =
+	{
+		{ NULL, glm::vec4(0.0f, 0.0f, 0.5f, 1.0f) },
+		{ &g_OverviewCamera, glm::vec4(0.5f, 0.0f, 0.5f, 1.0f) }
+	};
+	const LAYOUT_VIEW g_PictureInPictureLayout[] =
+	{
+		{ NULL, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) },
+		{ &g_OverviewCamera, glm::vec4(0.68f, 0.68f, 0.3f, 0.3f) }
+	};
+	const LAYOUT_VIEW g_OrthoInsetLayout[] =
+	{
+		{ NULL, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) },
+		{ &g_FrontCamera, glm::vec4(0.68f, 0.02f, 0.3f, 0.3f) }
+	};
+	const LAYOUT_VIEW g_QuadLayout[] =
+	{
+		{ NULL, glm::vec4(0.0f, 0.5f, 0.5f, 0.5f) },
+		{ &g_FrontCamera, glm::vec4(0.5f, 0.5f, 0.5f, 0.5f) },
+		{ &g_TopCamera, glm::vec4(0.0f, 0.0f, 0.5f, 0.5f) },
+		{ &g_SideCamera, glm::vec4(0.5f, 0.0f, 0.5f, 0.5f) }
+	};
+
+	/***********************************************************
+	 *  GetFrontVector()
+	 ***********************************************************/
+	glm::vec3 GetFrontVector(float yaw, float pitch)
+	{
+		// calculate front vector from yaw/pitch
+		glm::vec3 front;
+		front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+		front.y = sin(glm::radians(pitch));
+		front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+
+		return glm::normalize(front);
+	}
+
+	/***********************************************************
+	 *  GetLayoutViews()
+	 ***********************************************************/
+	const LAYOUT_VIEW* GetLayoutViews(ViewManager::VIEW_LAYOUT layout, int& viewCount)
+	{
+		switch (layout)
+		{
+		case ViewManager::VIEW_LAYOUT_SPLIT:
+			viewCount = 2;
+			return g_SplitLayout;
+		case ViewManager::VIEW_LAYOUT_PICTURE_IN_PICTURE:
+			viewCount = 2;
+			return g_PictureInPictureLayout;
+		case ViewManager::VIEW_LAYOUT_ORTHO_INSET:
+			viewCount = 2;
+			return g_OrthoInsetLayout;
+		case ViewManager::VIEW_LAYOUT_QUAD:
+			viewCount = 4;
+			return g_QuadLayout;
+		default:
+			viewCount = 1;
+			return g_SingleLayout;
+		}
+	}
+
+	/***********************************************************
+	 *  BuildFixedCameraView()
+	 ***********************************************************/
+	void BuildFixedCameraView(const FIXED_CAMERA& camera, float aspect, SCENE_VIEW& sceneView)
+	{
+		sceneView.view = glm::lookAt(
+			g_FixedViewTarget + camera.eyeOffset,
+			g_FixedViewTarget,
+			camera.up);
+
+		if (camera.bOrthographic)
+		{
+			sceneView.projection = glm::ortho(
+				-gOrthoScale * aspect,
+				gOrthoScale * aspect,
+				-gOrthoScale,
+				gOrthoScale,
+				0.1f,
+				100.0f);
+		}
+		else
+		{
+			sceneView.projection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 100.0f);
+		}
+
+		sceneView.viewProjection = sceneView.projection * sceneView.view;
+		sceneView.frustum.ExtractPlanes(sceneView.viewProjection);
+	}
+}
+
+/***********************************************************
+ *  ViewManager()
+ ***********************************************************/
+ViewManager::ViewManager(ShaderManager* pShaderManager)
+{
+	// initialize the member variables
+	m_pShaderManager = pShaderManager;
+	m_pWindow = NULL;
+	m_pInputRecorder = NULL;
+	m_viewProjection = glm::mat4(1.0f);
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_bViewChanged = true;
+	m_bMovementKeysHeld = false;
+	m_movementInput = glm::vec3(0.0f);
+	m_viewLayout = VIEW_LAYOUT_SINGLE;
+	m_bShowPerfOverlay = false;
+
+	// mouse look starts from the window center, facing down -Z
+	m_lastMouseX = WINDOW_WIDTH / 2.0f;
+	m_lastMouseY = WINDOW_HEIGHT / 2.0f;
+	m_bFirstMouse = true;
+	m_yaw = -90.0f;
+	m_pitch = 0.0f;
+	m_speedMultiplier = 1.0f;
+	m_bOrthographicProjection = false;
+	m_bRefreshRequested = false;
+	m_bPickRequested = false;
+	for (int i = 0; i <= GLFW_KEY_LAST; i++)
+	{
+		m_bKeyDown[i] = false;
+	}
+
+	m_pCamera = new Camera();
+
+	// default camera view parameters (perspective mode)
+	m_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
+
+	// Normalize the front vector so movement and mouse look feel correct
+	m_pCamera->Front = glm::normalize(glm::vec3(0.0f, -0.25f, -1.0f));
+
+	m_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	m_pCamera->Zoom = 80.0f;
+
+	m_previousCameraPosition = m_pCamera->Position;
+}
+
+/***********************************************************
+ *  ~ViewManager()
+ ***********************************************************/
+ViewManager::~ViewManager()
+{
+	if (NULL != m_pWindow)
+	{
+		glfwSetWindowUserPointer(m_pWindow, NULL);
+	}
+
+	m_pShaderManager = NULL;
+	m_pWindow = NULL;
+
+	if (NULL != m_pCamera)
+	{
+		delete m_pCamera;
+		m_pCamera = NULL;
+	}
+}
+
+/***********************************************************
+ *  CreateDisplayWindow()
+ ***********************************************************/
+GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
+{
+	STARTUP_PHASE("CreateDisplayWindow");
+
+	GLFWwindow* window = nullptr;
+
+	window = glfwCreateWindow(
+		WINDOW_WIDTH,
+		WINDOW_HEIGHT,
+		windowTitle,
+		NULL, NULL);
+
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	// capture mouse for camera look
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// the callbacks find this view manager through the window
+	glfwSetWindowUserPointer(window, this);
+
+	// callbacks
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
+	// enable blending for supporting transparent rendering
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pWindow = window;
+	return(window);
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  The input callbacks only queue the raw event; it is applied
+ *  by ProcessInputEvents() in the update step.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	ViewManager* pViewManager = (ViewManager*)glfwGetWindowUserPointer(window);
+	if (NULL == pViewManager)
+	{
+		return;
+	}
+
+	INPUT_EVENT event = {};
+	event.type = INPUT_EVENT_KEY;
+	event.key = key;
+	event.action = action;
+	pViewManager->m_inputQueue.Push(event);
+}
+
+/***********************************************************
+ *  Mouse_Position_Callback()
+ ***********************************************************/
+void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
+{
+	ViewManager* pViewManager = (ViewManager*)glfwGetWindowUserPointer(window);
+	if (NULL == pViewManager)
+	{
+		return;
+	}
+
+	INPUT_EVENT event = {};
+	event.type = INPUT_EVENT_MOUSE_POSITION;
+	event.x = xMousePos;
+	event.y = yMousePos;
+	pViewManager->m_inputQueue.Push(event);
+}
+
+/***********************************************************
+ *  Mouse_Scroll_Callback()
+ ***********************************************************/
+void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset)
+{
+	ViewManager* pViewManager = (ViewManager*)glfwGetWindowUserPointer(window);
+	if (NULL == pViewManager)
+	{
+		return;
+	}
+
+	INPUT_EVENT event = {};
+	event.type = INPUT_EVENT_MOUSE_SCROLL;
+	event.x = xOffset;
+	event.y = yOffset;
+	pViewManager->m_inputQueue.Push(event);
+}
+
+/***********************************************************
+ *  Mouse_Button_Callback()
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	ViewManager* pViewManager = (ViewManager*)glfwGetWindowUserPointer(window);
+	if (NULL == pViewManager)
+	{
+		return;
+	}
+
+	INPUT_EVENT event = {};
+	event.type = INPUT_EVENT_MOUSE_BUTTON;
+	event.key = button;
+	event.action = action;
+	pViewManager->m_inputQueue.Push(event);
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	ViewManager* pViewManager = (ViewManager*)glfwGetWindowUserPointer(window);
+	if (NULL != pViewManager)
+	{
+		pViewManager->m_bRefreshRequested = true;
+	}
+}
+
+/***********************************************************
+ *  ConsumeRefreshRequest()
+ ***********************************************************/
+bool ViewManager::ConsumeRefreshRequest()
+{
+	bool bRequested = m_bRefreshRequested;
+	m_bRefreshRequested = false;
+	return bRequested;
+}
+
+/***********************************************************
+ *  ConsumePickRequest()
+ *
+ *  This method is used for handing a left click to the scene.
+ *  The cursor is captured for mouse look, so the click always
+ *  picks along the camera's line of sight.
+ ***********************************************************/
+bool ViewManager::ConsumePickRequest(glm::vec3& rayOrigin, glm::vec3& rayDirection)
+{
+	if ((false == m_bPickRequested) || (m_pCamera == nullptr))
+	{
+		return false;
+	}
+
+	m_bPickRequested = false;
+	rayOrigin = m_pCamera->Position;
+	rayDirection = m_pCamera->Front;
+	return true;
+}
+
+/***********************************************************
+ *  ProcessKeyEvent()
+ ***********************************************************/
+void ViewManager::ProcessKeyEvent(int key, int action)
+{
+	if ((key < 0) || (key > GLFW_KEY_LAST) || (action == GLFW_REPEAT))
+	{
+		return;
+	}
+
+	m_bKeyDown[key] = (action == GLFW_PRESS);
+
+	// toggles happen once per press
+	if (action != GLFW_PRESS)
+	{
+		return;
+	}
+
+	switch (key)
+	{
+	// close the window if the escape key has been pressed
+	case GLFW_KEY_ESCAPE:
+		glfwSetWindowShouldClose(m_pWindow, true);
+		break;
+	// Projection toggle
+	case GLFW_KEY_P:
+		m_bOrthographicProjection = false;
+		break;
+	case GLFW_KEY_O:
+		m_bOrthographicProjection = true;
+		break;
+	// performance HUD toggle
+	case GLFW_KEY_H:
+		m_bShowPerfOverlay = !m_bShowPerfOverlay;
+		break;
+	}
+}
+
+/***********************************************************
+ *  ApplyInputEvent()
+ *
+ *  This method is used for applying one queued or replayed
+ *  event. Mouse moves only add up yaw and pitch, returning
+ *  true so the caller rebuilds the front vector afterwards.
+ ***********************************************************/
+bool ViewManager::ApplyInputEvent(const INPUT_EVENT& event)
+{
+	switch (event.type)
+	{
+	case INPUT_EVENT_KEY:
+		ProcessKeyEvent(event.key, event.action);
+		break;
+
+	case INPUT_EVENT_MOUSE_POSITION:
+	{
+		// Optional: disable mouse-look in orthographic mode
+		if (m_bOrthographicProjection)
+		{
+			break;
+		}
+
+		float xpos = (float)event.x;
+		float ypos = (float)event.y;
+
+		if (m_bFirstMouse)
+		{
+			m_lastMouseX = xpos;
+			m_lastMouseY = ypos;
+			m_bFirstMouse = false;
+		}
+
+		float xoffset = xpos - m_lastMouseX;
+		float yoffset = m_lastMouseY - ypos; // reversed
+
+		m_lastMouseX = xpos;
+		m_lastMouseY = ypos;
+
+		// update yaw/pitch with sensitivity applied
+		m_yaw += xoffset * gMouseSensitivity;
+		m_pitch += yoffset * gMouseSensitivity;
+
+		// clamp pitch to prevent flipping
+		if (m_pitch > 89.0f) m_pitch = 89.0f;
+		if (m_pitch < -89.0f) m_pitch = -89.0f;
+
+		return true;
+	}
+
+	case INPUT_EVENT_MOUSE_SCROLL:
+		// scroll up increases speed, scroll down decreases speed
+		m_speedMultiplier += (float)event.y * 0.1f;
+
+		// clamp multiplier
+		if (m_speedMultiplier < 0.2f) m_speedMultiplier = 0.2f;
+		if (m_speedMultiplier > 4.0f) m_speedMultiplier = 4.0f;
+		break;
+
+	case INPUT_EVENT_MOUSE_BUTTON:
+		if ((event.key == GLFW_MOUSE_BUTTON_LEFT) && (event.action == GLFW_PRESS))
+		{
+			m_bPickRequested = true;
+		}
+		break;
+	}
+
+	return false;
+}
+
+/***********************************************************
+ *  ProcessInputEvents()
+ *
+ *  This method is used for draining the input queue once per
+ *  frame. The camera front vector is rebuilt once at the end,
+ *  however many moves a high polling rate mouse reported this
+ *  frame. While a log is replayed the live events are ignored,
+ *  apart from escape, and the frame's recorded events are
+ *  applied instead.
+ ***********************************************************/
+void ViewManager::ProcessInputEvents()
+{
+	if (m_pWindow == NULL || m_pCamera == nullptr)
+	{
+		return;
+	}
+
+	bool bLookChanged = false;
+	INPUT_EVENT event;
+
+	if ((NULL != m_pInputRecorder) && m_pInputRecorder->IsReplaying())
+	{
+		while (m_inputQueue.Pop(event))
+		{
+			if ((event.type == INPUT_EVENT_KEY) && (event.key == GLFW_KEY_ESCAPE) && (event.action == GLFW_PRESS))
+			{
+				glfwSetWindowShouldClose(m_pWindow, true);
+			}
+		}
+
+		for (size_t i = 0; i < m_pInputRecorder->GetReplayEventCount(); i++)
+		{
+			bLookChanged |= ApplyInputEvent(m_pInputRecorder->GetReplayEvent(i));
+		}
+	}
+	else
+	{
+		while (m_inputQueue.Pop(event))
+		{
+			if (NULL != m_pInputRecorder)
+			{
+				m_pInputRecorder->RecordEvent(event);
+			}
+			bLookChanged |= ApplyInputEvent(event);
+		}
+	}
+
+	if (bLookChanged)
+	{
+		m_pCamera->Front = GetFrontVector(m_yaw, m_pitch);
+	}
+
+	// keys held this frame, applied by every fixed update step until the next frame
+	m_movementInput = glm::vec3(0.0f);
+
+	// WASD + QE movement (allowed in both modes, but orthographic view is usually fixed)
+	if (m_bKeyDown[GLFW_KEY_W])
+	{
+		m_movementInput.x += 1.0f;
+	}
+	if (m_bKeyDown[GLFW_KEY_S])
+	{
+		m_movementInput.x -= 1.0f;
+	}
+	if (m_bKeyDown[GLFW_KEY_A])
+	{
+		m_movementInput.y -= 1.0f;
+	}
+	if (m_bKeyDown[GLFW_KEY_D])
+	{
+		m_movementInput.y += 1.0f;
+	}
+	if (m_bKeyDown[GLFW_KEY_Q])
+	{
+		m_movementInput.z -= 1.0f;
+	}
+	if (m_bKeyDown[GLFW_KEY_E])
+	{
+		m_movementInput.z += 1.0f;
+	}
+
+	// movement keys keep the view changing even if a frame runs no update step
+	m_bMovementKeysHeld = (m_movementInput != glm::vec3(0.0f));
+}
+
+/***********************************************************
+ *  FixedUpdate()
+ *
+ *  This method is used for moving the camera by one update
+ *  step. The step length is fixed, so the same keys give the
+ *  same movement at any frame rate.
+ ***********************************************************/
+void ViewManager::FixedUpdate(float stepSeconds)
+{
+	if (m_pCamera == nullptr)
+	{
+		return;
+	}
+
+	m_previousCameraPosition = m_pCamera->Position;
+
+	// movement amount this step
+	float velocity = gBaseMoveSpeed * m_speedMultiplier * stepSeconds;
+
+	glm::vec3 right = glm::normalize(glm::cross(m_pCamera->Front, m_pCamera->Up));
+	m_pCamera->Position += m_pCamera->Front * (m_movementInput.x * velocity);
+	m_pCamera->Position += right * (m_movementInput.y * velocity);
+	m_pCamera->Position += m_pCamera->Up * (m_movementInput.z * velocity);
+}
+
+/***********************************************************
+ *  UpdateView()
+ *
+ *  This method is used for rebuilding the view and projection
+ *  matrices from the camera position blended between the last
+ *  two fixed update steps, so movement looks smooth when the
+ *  frame rate and update rate differ. The result is compared
+ *  with the previous frame so callers can skip redrawing when
+ *  the view did not change.
+ ***********************************************************/
+void ViewManager::UpdateView(float interpolation)
+{
+	PROFILE_SCOPE("UpdateView");
+
+	if (m_pWindow == NULL || m_pCamera == nullptr)
+	{
+		return;
+	}
+
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	int layoutViewCount = 0;
+	const LAYOUT_VIEW* pLayoutViews = GetLayoutViews(m_viewLayout, layoutViewCount);
+
+	// the interactive camera keeps the window's proportions within its part of the window
+	float aspect = ((GLfloat)WINDOW_WIDTH * pLayoutViews[0].viewportRect.z) /
+		((GLfloat)WINDOW_HEIGHT * pLayoutViews[0].viewportRect.w);
+
+	glm::vec3 cameraPosition = glm::mix(m_previousCameraPosition, m_pCamera->Position, interpolation);
+
+	// view matrix
+	if (!m_bOrthographicProjection)
+	{
+		view = glm::lookAt(
+			cameraPosition,
+			cameraPosition + m_pCamera->Front,
+			m_pCamera->Up);
+	}
+	else
+	{
+		// Orthographic view: look directly at the mug and keep it centered
+		glm::vec3 target = g_FixedViewTarget;
+		glm::vec3 orthoCamPos = target + g_FrontCamera.eyeOffset;
+
+		view = glm::lookAt(
+			orthoCamPos,
+			target,
+			glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	// projection matrix
+	if (!m_bOrthographicProjection)
+	{
+		projection = glm::perspective(
+			glm::radians(m_pCamera->Zoom),
+			aspect,
+			0.1f,
+			100.0f);
+	}
+	else
+	{
+		projection = glm::ortho(
+			-gOrthoScale * aspect,
+			gOrthoScale * aspect,
+			-gOrthoScale,
+			gOrthoScale,
+			0.1f,
+			100.0f);
+	}
+
+	// the camera position also feeds the lighting, even when the ortho view is fixed
+	m_bViewChanged = m_bMovementKeysHeld ||
+		(view != m_view) ||
+		(projection != m_projection) ||
+		(cameraPosition != m_viewPosition);
+
+	m_view = view;
+	m_projection = projection;
+	m_viewPosition = cameraPosition;
+
+	// keep the clipping planes so the scene can skip objects out of view
+	m_viewProjection = projection * view;
+	m_viewFrustum.ExtractPlanes(m_viewProjection);
+
+	// the interactive camera is view 0, followed by the fixed cameras of the layout
+	m_sceneViews.resize(layoutViewCount);
+	m_sceneViews[0].viewportRect = pLayoutViews[0].viewportRect;
+	m_sceneViews[0].view = m_view;
+	m_sceneViews[0].projection = m_projection;
+	m_sceneViews[0].viewProjection = m_viewProjection;
+	m_sceneViews[0].frustum = m_viewFrustum;
+
+	for (int i = 1; i < layoutViewCount; i++)
+	{
+		const glm::vec4& rect = pLayoutViews[i].viewportRect;
+		m_sceneViews[i].viewportRect = rect;
+		BuildFixedCameraView(
+			*pLayoutViews[i].pCamera,
+			((GLfloat)WINDOW_WIDTH * rect.z) / ((GLfloat)WINDOW_HEIGHT * rect.w),
+			m_sceneViews[i]);
+	}
+}
+
+/***********************************************************
+ *  ApplyViewToShader()
+ ***********************************************************/
+void ViewManager::ApplyViewToShader()
+{
+	PROFILE_SCOPE("ApplyViewToShader");
+
+	// send to shader
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setMat4Value(g_ViewName, m_view);
+		m_pShaderManager->setMat4Value(g_ProjectionName, m_projection);
+		m_pShaderManager->setVec3Value("viewPosition", m_viewPosition);
+		RenderStats::AddUniformUpdates(3);
+	}
+}
+
+/***********************************************************
+ *  BuildCameraPoseView()
+ *
+ *  This method is used for building a view from a camera pose
+ *  with the same projection settings as the interactive
+ *  camera. Orthographic poses use the orthographic view size
+ *  but keep their own position and direction.
+ ***********************************************************/
+void ViewManager::BuildCameraPoseView(const CAMERA_POSE& pose, float aspect, SCENE_VIEW& sceneView)
+{
+	glm::vec3 front = GetFrontVector(pose.yaw, pose.pitch);
+
+	sceneView.view = glm::lookAt(
+		pose.position,
+		pose.position + front,
+		glm::vec3(0.0f, 1.0f, 0.0f));
+
+	if (pose.bOrthographic)
+	{
+		sceneView.projection = glm::ortho(
+			-gOrthoScale * aspect,
+			gOrthoScale * aspect,
+			-gOrthoScale,
+			gOrthoScale,
+			0.1f,
+			100.0f);
+	}
+	else
+	{
+		sceneView.projection = glm::perspective(
+			glm::radians(pose.zoom),
+			aspect,
+			0.1f,
+			100.0f);
+	}
+
+	sceneView.viewProjection = sceneView.projection * sceneView.view;
+	sceneView.frustum.ExtractPlanes(sceneView.viewProjection);
+}
+
+/***********************************************************
+ *  GetCameraPose()
+ *
+ *  This method is used for describing the interactive camera
+ *  as a pose, so offline renders can start from what the
+ *  window shows. The orthographic toggle looks from the fixed
+ *  front camera, so that eye is used instead.
+ ***********************************************************/
+CAMERA_POSE ViewManager::GetCameraPose() const
+{
+	CAMERA_POSE pose;
+	pose.name = "camera";
+	pose.bOrthographic = m_bOrthographicProjection;
+
+	glm::vec3 front = m_pCamera->Front;
+	pose.position = m_pCamera->Position;
+	pose.zoom = m_pCamera->Zoom;
+	if (m_bOrthographicProjection)
+	{
+		pose.position = g_FixedViewTarget + g_FrontCamera.eyeOffset;
+		front = -g_FrontCamera.eyeOffset;
+	}
+
+	// the inverse of GetFrontVector()
+	front = glm::normalize(front);
+	pose.yaw = glm::degrees(atan2(front.z, front.x));
+	pose.pitch = glm::degrees(asin(glm::clamp(front.y, -1.0f, 1.0f)));
+
+	return pose;
+}
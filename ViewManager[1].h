@@ -1,44 +1,169 @@
-/////////////////////////////////////////////////////////////////////////////////
-// ViewManager.h
-// ============
-// manage the viewing of 3D objects within the viewport
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//  Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-/////////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "camera.h"
-
-// GLFW library
-#include "GLFW/glfw3.h"
-
-class ViewManager
-{
-public:
-	// constructor / destructor
-	ViewManager(ShaderManager* pShaderManager);
-	~ViewManager();
-
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-
-	// prepare the view/projection matrices each frame
-	void PrepareSceneView();
-
-	// mouse callbacks for interaction with the 3D scene
-	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
-	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-
-	// active OpenGL display window
-	GLFWwindow* m_pWindow;
-
-	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
-};
+/////////////////////////////////////////////////////////////////////////////////
+// ViewManager.h
+// ============
+// manage the viewing of 3D objects within the viewport
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//  Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "camera.h"
+#include "ViewFrustum.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CAMERA_POSE
+ *
+ *  Camera parameters as the interactive camera uses them:
+ *  position, mouse-look yaw and pitch in degrees, and the
+ *  perspective field of view in degrees.
+ ***********************************************************/
+struct CAMERA_POSE
+{
+	std::string name;
+	glm::vec3 position = glm::vec3(0.0f, 5.0f, 12.0f);
+	float yaw = -90.0f;
+	float pitch = 0.0f;
+	float zoom = 80.0f;
+	bool bOrthographic = false;
+};
+
+class ViewManager
+{
+public:
+	// arrangements of the interactive camera and the fixed cameras in the window
+	enum VIEW_LAYOUT
+	{
+		// the interactive camera only
+		VIEW_LAYOUT_SINGLE,
+		// interactive camera and a perspective overview side by side
+		VIEW_LAYOUT_SPLIT,
+		// perspective overview inset in the top right corner
+		VIEW_LAYOUT_PICTURE_IN_PICTURE,
+		// orthographic front view inset in the bottom right corner
+		VIEW_LAYOUT_ORTHO_INSET,
+		// interactive camera plus front, top and side views in quarters
+		VIEW_LAYOUT_QUAD
+	};
+
+	// constructor / destructor
+	ViewManager(ShaderManager* pShaderManager);
+	~ViewManager();
+
+	// create the initial OpenGL display window
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+
+	// apply the queued input events once per frame: toggles, mouse look, and the movement keys held
+	void ProcessInputEvents();
+	// move the camera by one fixed update step using the keys read by ProcessInputEvents
+	void FixedUpdate(float stepSeconds);
+	// rebuild the view/projection matrices, blending the camera between the
+	// last two update steps (0 = previous step, 1 = latest step)
+	void UpdateView(float interpolation);
+	// send the matrices from the last UpdateView call to the shader
+	void ApplyViewToShader();
+	// true if the last UpdateView call changed the matrices or camera position
+	bool HasViewChanged() const { return m_bViewChanged; }
+	// true once after the window system asked for the window contents to be redrawn
+	bool ConsumeRefreshRequest();
+	// true once after a left click, with the camera ray through the crosshair
+	bool ConsumePickRequest(glm::vec3& rayOrigin, glm::vec3& rayDirection);
+	// record the applied input events to this recorder, or take them from its replay
+	void SetInputRecorder(InputRecorder* pInputRecorder) { m_pInputRecorder = pInputRecorder; }
+
+	// frustum of the view/projection matrices from the last UpdateView call
+	const ViewFrustum& GetViewFrustum() const { return m_viewFrustum; }
+	// combined projection * view matrix from the last UpdateView call
+	const glm::mat4& GetViewProjection() const { return m_viewProjection; }
+	// choose the views drawn each frame
+	void SetViewLayout(VIEW_LAYOUT layout) { m_viewLayout = layout; }
+	// views built by the last UpdateView call; view 0 is the interactive camera
+	int GetViewCount() const { return (int)m_sceneViews.size(); }
+	const SCENE_VIEW& GetSceneView(int viewIndex) const { return m_sceneViews[viewIndex]; }
+	// build the matrices and frustum of a camera pose for the given aspect ratio
+	static void BuildCameraPoseView(const CAMERA_POSE& pose, float aspect, SCENE_VIEW& sceneView);
+	// the interactive camera as a pose, as the last update step left it
+	CAMERA_POSE GetCameraPose() const;
+	// true while the performance HUD is toggled on with the H key
+	bool IsPerfOverlayVisible() const { return m_bShowPerfOverlay; }
+
+	// keyboard and mouse callbacks; they only queue the event for ProcessInputEvents
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+	// window callback for exposed or resized window contents
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+
+	// active OpenGL display window
+	GLFWwindow* m_pWindow;
+
+	// camera object used for viewing and interacting with the 3D scene
+	Camera* m_pCamera;
+
+	// raw events queued by the window callbacks
+	InputQueue m_inputQueue;
+	// input log being recorded or replayed, if any
+	InputRecorder* m_pInputRecorder;
+	// keys currently held, from the queued key events
+	bool m_bKeyDown[GLFW_KEY_LAST + 1];
+
+	// mouse movement processing
+	float m_lastMouseX;
+	float m_lastMouseY;
+	bool m_bFirstMouse;
+	// yaw/pitch for mouse-look (degrees)
+	float m_yaw;
+	float m_pitch;
+	// movement speed, adjusted with the scroll wheel
+	float m_speedMultiplier;
+
+	// projection toggle
+	bool m_bOrthographicProjection;
+	// set by the window refresh callback, cleared by ConsumeRefreshRequest()
+	bool m_bRefreshRequested;
+	// set by a left click, cleared by ConsumePickRequest()
+	bool m_bPickRequested;
+
+	// clipping planes and matrix of the current view, used for culling
+	ViewFrustum m_viewFrustum;
+	glm::mat4 m_viewProjection;
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	// camera position the view was built from, sent to the shader for lighting
+	glm::vec3 m_viewPosition;
+	bool m_bViewChanged;
+	bool m_bMovementKeysHeld;
+
+	// views of the current layout, rebuilt by UpdateView
+	VIEW_LAYOUT m_viewLayout;
+	std::vector<SCENE_VIEW> m_sceneViews;
+
+	// held movement keys as -1, 0 or 1 along the front, right and up directions
+	glm::vec3 m_movementInput;
+	// camera position before the latest fixed update step
+	glm::vec3 m_previousCameraPosition;
+
+	// performance HUD toggle
+	bool m_bShowPerfOverlay;
+
+	// apply one key press or release
+	void ProcessKeyEvent(int key, int action);
+	// apply one input event, true if it moved the mouse look
+	bool ApplyInputEvent(const INPUT_EVENT& event);
+
+};